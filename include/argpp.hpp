@@ -29,10 +29,7 @@
  * @brief Include just this file in your own application code.
  * @details This file defines the base class argpp::ArgppBase, which clients should use
  * to define their own derived classes, as well as some typedefs used mostly by the
- * implementation class argpp::impl::ArgppBaseImpl. Perhaps the most interesting
- * of these is the argpp::MapOfChildren which is used in the
- * argpp::impl::ArgppBaseImpl::parserRouter() function to populate the \b child_inputs[]
- * array member of the \b argp_state argument.
+ * implementation class argpp::impl::ArgppBaseImpl.
  *
  * The application uses the so-called
  * <a href="http://c2.com/cgi/wiki?PimplIdiom" target="_blank">Pimpl idiom</a>
@@ -86,6 +83,15 @@
 #  define ARGPP_HAVE_UNIQUE_PTR
 #endif // check for std::unique_ptr
 
+//---------------------------------------------------------------
+// ARGPP_HAVE_THREAD_LOCAL (each thread selects its own root
+// instance and parse state, see argpp::impl::ParseContext) and
+// ARGPP_HAVE_UNORDERED_MAP (hash tables for the option indexes)
+// are set by configure when the library is built; nothing in
+// this header depends on them.
+//---------------------------------------------------------------
+
+#include <deque>
 #include <map>
 #include <memory>
 #include <string>
@@ -206,6 +212,22 @@ namespace argpp {
     key_finito       = ARGP_KEY_FINI     //!< = ARGP_KEY_FINI
   };
 
+  /**
+ * @enum argpp_lifecycle_key
+ * @brief The keys which a parser passes to ArgppBase::setLifecycleKeys(),
+ * one for each of the hooks which are called after ARGP_KEY_INIT.
+ */
+  enum argpp_lifecycle_key {
+    lk_none      = 0x00, //!< none of the hooks below
+    lk_more_args = 0x01, //!< ARGP_KEY_ARGS, i.e. keyArgsImpl()
+    lk_no_args   = 0x02, //!< ARGP_KEY_NO_ARGS, i.e. keyNoArgsImpl()
+    lk_end       = 0x04, //!< ARGP_KEY_END, i.e. keyEndImpl()
+    lk_success   = 0x08, //!< ARGP_KEY_SUCCESS, i.e. keySuccessImpl()
+    lk_error     = 0x10, //!< ARGP_KEY_ERROR, i.e. errorImpl()
+    lk_fini      = 0x20, //!< ARGP_KEY_FINI, i.e. finiImpl()
+    lk_all       = 0x3f  //!< all of the above OR'ed together
+  };
+
   /**
  * @enum argpp_argp_key_help
  * @brief Used in the help filter function.
@@ -241,6 +263,16 @@ namespace argpp {
     hlp_std_help    = ARGP_HELP_STD_HELP     //!< = ARGP_HELP_STD_HELP
   };
 
+  /**
+ * @enum argpp_parse_engine
+ * @brief Selects the code which parses the command line when
+ * ArgppBase::parse() is called. See ArgppBase::setParseEngine().
+ */
+  enum argpp_parse_engine {
+    eng_argp   = 0, //!< calls argp_parse()
+    eng_native = 1  //!< uses the native C++ engine of argp++
+  };
+
   /**
  * @struct ArgppOption
  * @brief A wrapper around \b argp_option.
@@ -370,6 +402,111 @@ namespace argpp {
       }
   };
 
+  /**
+ * @struct ArgppStringView
+ * @brief A pointer and a length referring to a string owned by somebody else,
+ * usually an element of \b argv.
+ */
+  struct ARGPP_API ArgppStringView {
+      const char *data_;
+      size_t      size_;
+
+      ArgppStringView()
+        : data_(NULL)
+        , size_(0) {}
+
+      ArgppStringView(const char *s)
+        : data_(s)
+        , size_(s ? std::char_traits<char>::length(s) : 0) {}
+
+      ArgppStringView(const char *s, size_t n)
+        : data_(s)
+        , size_(n) {}
+
+      bool empty() const { return size_ == 0; }
+
+      std::string str() const { return data_ ? std::string(data_, size_) : std::string(); }
+  };
+
+  /**
+ * @struct ParsedOptionView
+ * @brief The same as ParsedOption, except that the strings are not copied.
+ * @details The long name refers to the parser's own option (see ArgppBase::addOption()),
+ * and the argument refers to the \b argv passed to main(). The views stay valid as long
+ * as \b argv does and no more options are added to the parser.
+ */
+  struct ARGPP_API ParsedOptionView {
+      int             key_;
+      ArgppStringView long_name_;
+      ArgppStringView arg_;
+      ///
+      /// @brief The index of the element of \b argv which contains the argument if there
+      /// is one, otherwise the option itself; -1 if the option did not come from \b argv.
+      /// @details Note that \b argp can permute \b argv while parsing it; the index is
+      /// the one in \b argv as the parse leaves it.
+      ///
+      int             argv_index_;
+
+      ParsedOptionView()
+        : key_       (0)
+        , long_name_ ()
+        , arg_       ()
+        , argv_index_(-1) {}
+
+      explicit ParsedOptionView(
+          int k
+          , ArgppStringView s = ArgppStringView()
+          , ArgppStringView a = ArgppStringView()
+          , int idx = -1)
+        : key_       (k)
+        , long_name_ (s)
+        , arg_       (a)
+        , argv_index_(idx) {}
+  };
+
+  /**
+ * @struct NonOptionArgView
+ * @brief A non-option argument which refers to the element of \b argv it came from.
+ * @details See ParsedOptionView.
+ */
+  struct ARGPP_API NonOptionArgView {
+      ArgppStringView arg_;
+      int             argv_index_;
+
+      NonOptionArgView()
+        : arg_       ()
+        , argv_index_(-1) {}
+
+      explicit NonOptionArgView(ArgppStringView a, int idx = -1)
+        : arg_       (a)
+        , argv_index_(idx) {}
+  };
+
+  /**
+ * @struct ArgppPrebuiltHelp
+ * @brief A help or usage text which was formatted when the program was built;
+ * see ArgppBase::writePrebuiltHelp() and ArgppBase::installPrebuiltHelp().
+ * @details Tables of these are meant to be generated, not written by hand.
+ */
+  struct ARGPP_API ArgppPrebuiltHelp {
+      ///
+      /// @brief The ARGP_HELP_* flags the text is for, without ARGP_HELP_EXIT_ERR
+      /// and ARGP_HELP_EXIT_OK.
+      ///
+      unsigned            flags_;
+      ///
+      /// @brief Identifies the options, documentation strings and layout parameters
+      /// which the text was formatted from.
+      ///
+      unsigned long long  fingerprint_;
+      ///
+      /// @brief The program name which the text contains.
+      ///
+      const char         *name_;
+      const char         *text_;
+      size_t              size_;
+  };
+
   /**
  * @typedef VersionFunc
  * @brief See documentation for \b argp_program_version_hook
@@ -384,15 +521,41 @@ namespace argpp {
  */
   typedef char* (*HelpFilter)(int key, const char *text, void *input);
 
+  /**
+ * @typedef NonOptionArgFunc
+ * @brief Receives each argument read by ArgppBase::readNonOptionArgs() together
+ * with the \c data passed to it.
+ * @details \c arg is only valid during the call. Return \b ARGPP_SUCCESS, or
+ * \b ARGPP_DONT_CARE to skip the argument, to go on reading; anything else stops.
+ */
+  typedef error_t (*NonOptionArgFunc)(const char *arg, void *data);
+
   // forward declare:
   class ArgppBase;
 
+  /**
+ * @typedef SubcommandFactory
+ * @brief Creates the parser of a subcommand as a child of \c parent; see
+ * ArgppBase::addSubcommand() and Factory<T>::createSubcommand().
+ * @details Returns NULL if the parser could not be created.
+ */
+  typedef ArgppBase* (*SubcommandFactory)(ArgppBase *parent);
+
+  /**
+ * @typedef AppletFactory
+ * @brief Creates the root parser of an applet of an ArgppMultiCall for the command
+ * line \c argc, \c argv; see Factory<T>::createApplet().
+ * @details Returns NULL if the parser could not be created.
+ */
+  typedef ArgppBase* (*AppletFactory)(int argc, char **argv);
+
   typedef std::vector<argp_child>                   Argp_Child_Vec;
   typedef std::vector<argp_option>                  Argp_Option_Vec;
   typedef std::vector<ArgppBase*>                   ArgppChildren;
   typedef ArgppChildren::iterator                   Child_It;
   typedef ArgppChildren::const_iterator             Child_It_const;
   typedef std::vector<ArgppOption>                  ArgppOptions;
+  // no longer used by the library; kept for source compatibility:
   typedef std::map<argp_child*, ArgppBase*>         MapOfChildren;
   typedef ArgppOptions::iterator                    Opt_It;
   typedef ArgppOptions::const_iterator              Opt_It_const;
@@ -400,6 +563,8 @@ namespace argpp {
   typedef std::vector<ParsedOption>::iterator       P_Opts_it;
   typedef std::vector<ParsedOption>::const_iterator P_Opts_cit;
   typedef std::vector<std::string>                  OtherArgs;
+  typedef std::vector<ParsedOptionView>             ParsedOptionViews;
+  typedef std::vector<NonOptionArgView>             NonOptionArgViews;
 
   /**
  * @namespace argpp::impl
@@ -408,13 +573,20 @@ namespace argpp {
  * <a href="http://c2.com/cgi/wiki?PimplIdiom" target="_blank">Pimpl idiom</a>)
  *
  * If C++11 or C++0x language support is available, our code uses a \c \b std::unique_pointer<T>
- * in the argppbaseimpl.cpp file to hold the pointer to the singleton root parser
+ * in argpp::impl::ParseContext to hold the pointer to the root parser
  * instance. Otherwise, we use a very simple auto pointer for that which is default constructible
  * with a NULL pointer and never uses copying or assignment.
+ *
+ * Each tree of parsers has its own argpp::impl::ParseContext, i.e. its own root instance
+ * and parse state. If the library was built with \c thread_local support (see
+ * ARGPP_HAVE_THREAD_LOCAL), each thread selects the context its static calls work on.
  */
   namespace impl {
     // forward declarations:
     class ArgppBaseImpl;
+    class ArgppPlanImpl;
+    class ArgppEventReaderImpl;
+    class ArgppMultiCallImpl;
 #ifndef ARGPP_HAVE_UNIQUE_PTR
     class DeleteHelper;
 #endif
@@ -425,6 +597,19 @@ namespace argpp {
  * @details Derive your own class from this base class and create instances
  * by calling the argpp::Factory<T>::createParser() function (replacing the
  * "T" with your own class name).
+ *
+ * Besides the --help option of \b argp, which lists all of the options, the
+ * user can enter "--help=PATTERN" to list only the options with a word in their
+ * long names or descriptions which begins with PATTERN (ignoring case), or
+ * "--help-group=N" or "--help-group N" to list only those of group N (see
+ * ArgppOption::group_). They are found through an index which is built the first
+ * time it is needed, so with thousands of options the time this takes depends on
+ * the number of options listed. Otherwise they behave like --help, except that a
+ * search which finds nothing is an error, and they are not available with
+ * argpp::fl_no_help. They are hidden options of the root, or of the parser of a
+ * subcommand, so a "--help=x" which getopt takes for the argument of another
+ * option is that option's argument. If the program has an option called "help"
+ * or "help-group" itself, that option is used instead.
  */
   class ARGPP_API ArgppBase {
       friend class impl::ArgppBaseImpl;
@@ -511,6 +696,30 @@ namespace argpp {
       ///
       static void argppStateHelp(const argp_state *state, FILE *stream, unsigned flags);
       ///
+      /// @brief Appends the text argppError() would print to \c out, e.g. for sending it
+      /// back to a client.
+      /// @details Nothing is printed, and the parse goes on: to end it, return an error
+      /// from parserImpl(). The text is formatted even if the parse flags include
+      /// argpp::fl_no_errs.
+      ///
+      static void argppError    (const argp_state *state, const std::string &errmsg, std::string &out);
+      ///
+      /// @brief Appends the text argppUsage() would print to \c out; see
+      /// argppError(const argp_state*, const std::string&, std::string&).
+      ///
+      static void argppUsage    (const argp_state *state, std::string &out);
+      ///
+      /// @brief Appends the text argppStateHelp() would print to \c out; see
+      /// argppError(const argp_state*, const std::string&, std::string&).
+      /// @details Each text is only formatted the first time it is asked for with
+      /// the same \c flags for the same tree of parsers, so asking for it again
+      /// costs a copy. Adding options or children, or changing any of the texts,
+      /// formats it anew, and so does a change of ARGP_HELP_FMT, of the LC_MESSAGES
+      /// locale, of $LANGUAGE or of the default gettext domain. A plan (see ArgppPlan)
+      /// keeps the texts it has formatted.
+      ///
+      static void argppStateHelp(const argp_state *state, std::string &out, unsigned flags);
+      ///
       /// @brief Does sanity checking on flags passed to the argp_parse() function.
       /// @param val : Passed as a non-const reference. Flags are sometimes interdependent.
       /// If there is an inconsistent flag set which can be corrected by adding or subtracting
@@ -567,6 +776,34 @@ namespace argpp {
       ///
       void addNonOptionArg(const std::string &arg);
       ///
+      /// @brief Same as addParsedOption(), except that the strings are not copied.
+      /// @details The strings which \c opt refers to must stay valid as long as the
+      /// parsed options are used, which is the case for the \c arg passed to parserImpl().
+      ///
+      void addParsedOption(const ParsedOptionView &opt);
+      ///
+      /// @brief Same as addNonOptionArg(), except that the string is not copied.
+      /// @details See addParsedOption(const ParsedOptionView &opt).
+      ///
+      void addNonOptionArg(const NonOptionArgView &arg);
+      ///
+      /// @brief Says which of keyArgsImpl(), keyNoArgsImpl(), keyEndImpl(), keySuccessImpl(),
+      /// errorImpl() and finiImpl() this parser overrides.
+      /// @details By default all of them are called for every parser of the tree, as \b argp
+      /// does. A tree with many children which only have options spends much of each parse
+      /// calling the dummies, so a derived class should call this in its constructor with
+      /// the hooks it implements, OR'ed together, or with argpp::lk_none. The native engine
+      /// (see setParseEngine()) reads the keys when it builds its tables for a parse or for
+      /// an ArgppPlan, and never calls the other hooks of this parser; under \b argp,
+      /// argpp::impl::ArgppBaseImpl::parserRouter() declines their keys without calling
+      /// them. initImpl() and keyArgImpl() are always called. Call this before the tree is
+      /// parsed or an ArgppPlan is built from it, never from one of the hooks.
+      /// @param keys : the values of argpp::argpp_lifecycle_key OR'ed together.
+      /// @returns Returns false, changing nothing, if keys contains any flags not contained
+      /// in the enumeration argpp_lifecycle_key.
+      ///
+      bool setLifecycleKeys(unsigned keys);
+      ///
       /// @brief Derived classes must implement the pure virtual
       /// parserImpl() member function.
       /// @details This function is called whenever argp calls argpp::impl::ArgppBaseImpl::parserRouter()
@@ -720,10 +957,14 @@ namespace argpp {
       /// run-time translations of help strings.
       /// See http://www.gnu.org/software/libc/manual/html_node/Argp-Help-Filtering.html#Argp-Help-Filtering
       /// for further details.
+      /// The result is cached for each \c key and \c text; see clearHelpFilterCache().
       /// @return Any string returned by helpFilterImpl() is copied by the static argpp::impl::ArgppBaseImpl::HelpFilter() function
-      /// to a C string allocated with malloc() before returning it to the caller. This is according
+      /// to a C string allocated with malloc() before returning it to \b argp. This is according
       /// to the argp documentation at
       /// http://www.gnu.org/software/libc/manual/html_node/Argp-Help-Filtering.html#Argp-Help-Filtering.
+      /// The help formatter of argp++ uses the cached string without copying it.
+      /// An empty string leaves \c text as it is, and so does one of 16384 characters or more
+      /// (or as many as the environment variable ARGPP_MAX_HELP_TEXT says).
       ///
       virtual std::string helpFilterImpl(int /*key*/, const char * /*text*/) { return std::string(); }
       ///
@@ -753,11 +994,18 @@ namespace argpp {
       //-------------------------
       ///
       /// @brief Flag to let derived classes know that one of the special options
-      /// "--help", "--version" or "--usage" was entered by the user on the command line.
-      /// @details The constructor of argpp::impl::ArgppBaseImpl does its own parsing
-      /// of the command line in the \b argc and \b argv parameters passed in order
-      /// to determine whether one of the special options listed above was entered.
-      /// If so, a flag is set to \b true which can be queried with this function.
+      /// "--help", "--version" or "--usage" was entered by the user on the command line
+      /// (or "--help=PATTERN" or "--help-group=N", see ArgppBase).
+      /// @details When the root instance is created, the command line in the \b argc
+      /// and \b argv parameters is scanned once, up to "--", in order to determine
+      /// whether one of the special options listed above was entered. If so, a flag
+      /// is set to \b true which can be queried with this function; all of the
+      /// parsers in the tree share it.
+      ///
+      /// parse() scans the command line again once the options of the whole tree are
+      /// known, and resolves abbreviations as \b argp does: "--v" is not a request for
+      /// the version if the program also has a --verbose option, and neither is an option
+      /// which the program has defined with the same name for itself.
       ///
       static bool wasHelpEntered();
       ///
@@ -781,6 +1029,77 @@ namespace argpp {
       ///
       static char** getArgv();
       ///
+      /// @brief Returns the number of elements of getParsedArgv().
+      ///
+      static int getParsedArgc();
+      ///
+      /// @brief Returns the command line which the last call to parse() parsed: the same as
+      /// getArgv(), unless response files were expanded (see setExpandResponseFiles()).
+      /// @details The argv indexes in the parse results (see ParsedOptionView::argv_index_ and
+      /// getArgvIndexAfterArgpParse()) refer to this command line. It stays valid until the next
+      /// call to reparse() or clearAllParsers().
+      ///
+      static char** getParsedArgv();
+      ///
+      /// @brief Returns the index in getParsedArgv() of the first argument which the last
+      /// call to parse() did not read, i.e. what \b argp_parse() returned in \c arg_index;
+      /// 0 before parse() has been called.
+      ///
+      static int getArgvIndexAfterArgpParse();
+      ///
+      /// @brief Determines whether parse() expands response files.
+      /// @details If \c expand is true, each argument of the form \c @path is replaced by the
+      /// words in the file at \c path before the command line is parsed, so that parserImpl()
+      /// and the other callbacks only ever see the result. The words are separated by blanks
+      /// or newlines and can be quoted as in the shell (without any expansions), and a word
+      /// beginning with \c # starts a comment. Words of the form \c @path in the file are
+      /// expanded in turn; a file which includes itself, directly or not, is an error (ELOOP).
+      /// As with GCC, an argument is left as it is if there is no file by that name.
+      ///
+      /// The files are mapped into memory and split in place, so nothing is copied and the
+      /// parse results can refer to them; see getParsedArgv(). If a file can't be read or has an
+      /// unclosed quote, parse() reports the error as \b argp would and calls exit() unless
+      /// argpp::fl_no_exit is set. The default is not to expand response files.
+      ///
+      static void setExpandResponseFiles(bool expand = true);
+      ///
+      /// @brief Returns true if parse() expands response files. See setExpandResponseFiles().
+      ///
+      static bool expandsResponseFiles();
+      ///
+      /// @brief Determines whether parse() stops at the first non-option argument.
+      /// @details If \c stop is true, parse() reads the options up to the first argument
+      /// which is not an option, or up to "--", and leaves that argument and everything after
+      /// it in \b argv for getRemainingArgv(), without passing any of them to keyArgImpl() or
+      /// looking at them at all. This is meant for wrappers such as
+      /// "tool [OPTION...] [--] COMMAND [ARG...]", which hand the command on to \b execvp()
+      /// or to another tree of parsers. The options are read in order, as with
+      /// argpp::fl_no_reorder, so an option after the command belongs to the command.
+      /// getArgvIndexAfterArgpParse() is the index of the first remaining argument, and
+      /// wasHelpEntered() only considers the options before it. The default is not to stop.
+      ///
+      static void setStopAtFirstNonOption(bool stop = true);
+      ///
+      /// @brief Returns true if parse() stops at the first non-option argument.
+      /// See setStopAtFirstNonOption().
+      ///
+      static bool stopsAtFirstNonOption();
+      ///
+      /// @brief Returns the number of elements of getRemainingArgv().
+      ///
+      static int getRemainingArgc();
+      ///
+      /// @brief Returns the arguments which parse() left over when it stopped at the first
+      /// non-option argument (see setStopAtFirstNonOption()).
+      /// @details This points into getParsedArgv(), so nothing is copied, and like \b argv
+      /// it ends with a NULL pointer; it can be passed straight to \b execvp() or to
+      /// \b posix_spawn(), or to ArgppPlan::parse() of another tree, with the command name
+      /// as the program name. It is NULL before parse() has been called with stopping
+      /// enabled, and empty if the command line had no arguments left. It stays valid as long
+      /// as getParsedArgv() does.
+      ///
+      static char** getRemainingArgv();
+      ///
       /// @brief Determines whether parsed options are stored in the root instance
       /// or in each individual parser.
       /// @details When parserImpl() or some other client code calls addParsedOption(), the target
@@ -834,6 +1153,50 @@ namespace argpp {
       ///
       static bool parse();
       ///
+      /// @brief Parses another command line with the same tree of parsers.
+      /// @details Forgets the results of the previous parse in all of the parsers of
+      /// the tree (the parsed options, the non-option arguments and the error codes) and
+      /// parses \c argv, which becomes the one returned by getArgc() and getArgv().
+      /// The arrays of options and children built by the previous parse are reused
+      /// unless parsers, options or messages have been added or changed since then, and
+      /// the memory used for the results is kept for the next parse, so the memory use
+      /// does not grow with the number of re-parses.
+      ///
+      /// As with parse(), \b argp may call exit() for --help, --version or errors
+      /// unless argpp::fl_no_exit has been set with setArgpParseFlags().
+      /// @param argc : the number of elements in \c argv.
+      /// @param argv : the command line, including the program name; it must stay
+      /// valid as long as the results are used.
+      /// @return The same as parse().
+      ///
+      static bool reparse(int argc, char **argv);
+      ///
+      /// @brief Reads more non-option arguments from the file descriptor \c fd, e.g. a list
+      /// of files piped in from <tt>find -print0</tt>, until the end of the input.
+      /// @details The input is read in large blocks, and each argument is handed on as soon
+      /// as it is complete, so that only the current block (or the longest argument, if that
+      /// is longer) is held in memory however many arguments there are. Each argument goes to
+      /// \c func if it is not NULL, otherwise to keyArgImpl() of this parser, as if it were the
+      /// only non-option argument on a command line whose \c argv is empty. The default
+      /// keyArgImpl() then stores a copy with addNonOptionArg(); override it, or pass \c func,
+      /// to process the arguments without keeping them.
+      ///
+      /// Call this after parse(), since keyArgImpl() may need the parsed options.
+      /// @param fd    : the file descriptor to read from, e.g. \c STDIN_FILENO. It is not closed.
+      /// @param delim : the character which ends each argument: '\\0' or '\\n'. The last
+      /// argument need not be followed by it.
+      /// @param func  : called with each argument, or NULL.
+      /// @param data  : passed on to \c func.
+      /// @return Returns \b ARGPP_SUCCESS at the end of the input, the first value other than
+      /// \b ARGPP_SUCCESS and \b ARGPP_DONT_CARE returned by \c func or keyArgImpl(), or the
+      /// \c errno value of a failed read. An argument declined with \b ARGPP_DONT_CARE is
+      /// skipped.
+      ///
+      error_t readNonOptionArgs(int fd
+                                , char delim = '\0'
+                                , NonOptionArgFunc func = NULL
+                                , void *data = NULL);
+      ///
       /// @brief This returns the error code that would typically be returned by one of the
       /// <a href="http://www.gnu.org/software/libc/manual/html_node/Argp-Helper-Functions.html#Argp-Helper-Functions" target="_blank">helper functions</a>.
       /// @return \c \b error_t is an alias for \c \b int. It should correspond to one of the standard
@@ -861,6 +1224,41 @@ namespace argpp {
       ///
       static bool setArgpParseFlags  (unsigned int flags);
       ///
+      /// @brief Selects the engine used by parse().
+      /// @details With argpp::eng_argp, parse() calls \b argp_parse(). With argpp::eng_native,
+      /// the command line is parsed by the C++ engine of argp++ which works directly on the
+      /// tree of parsers. It follows the rules of \b argp_parse() and \b getopt_long() (the
+      /// order of the ARGP_KEY_* calls, option aliases, optional arguments, abbreviated long
+      /// options, ARGP_IN_ORDER, ARGP_LONG_ONLY and the other flags), and prints the same
+      /// error messages. The help and usage texts come out as \b argp_state_help() prints them,
+      /// but the sorted list of options they are made from is kept from one call to the next.
+      ///
+      /// The default is argpp::eng_argp unless the library was built with ARGPP_USE_NATIVE_ENGINE
+      /// defined, or against a local copy of argp (WITH_LOCAL_ARGP).
+      /// @param eng : one of the values of the enumeration argpp_parse_engine.
+      /// @return Returns false if \c eng is not a valid engine.
+      ///
+      static bool setParseEngine     (argpp_parse_engine eng);
+      ///
+      /// @brief Returns the engine which parse() will use. See setParseEngine().
+      ///
+      static argpp_parse_engine getParseEngine();
+      ///
+      /// @brief Gives the native engine a buffer for its temporary tables.
+      /// @details The native engine allocates everything it needs during a parse (the
+      /// option tables and the state of each parser) from a per-thread arena, which
+      /// is released at the end of the parse. The arena uses \c buf first and only
+      /// goes to the heap when it is full, so a buffer of a few kilobytes, e.g. on the
+      /// stack of main(), avoids nearly all heap allocations of the engine.
+      ///
+      /// \c buf must stay valid as long as parse() may be called, or until
+      /// setScratchBuffer() is called again; pass NULL to use only the heap (the default).
+      /// The buffer belongs to the calling thread.
+      /// @param buf  : the buffer, suitably aligned for any type, or NULL.
+      /// @param size : its size in bytes.
+      ///
+      static void setScratchBuffer   (void *buf, size_t size);
+      ///
       /// @brief Checks the pointer against all of the registered children
       /// in the root instance's tree of child objects.
       /// @param parent: A pointer to a parser instance derived from ArgppBase.
@@ -872,6 +1270,11 @@ namespace argpp {
       /// @brief Called by the argpp::Factory<T>::createParser() function
       /// when the first (root) instance is created. Subsequent calls do not
       /// do anything.
+      /// @details A thread which has no root instance of its own can also pass
+      /// the root instance of a tree created on another thread; the static member
+      /// functions then work on that tree on the calling thread as well, e.g. to
+      /// build the tree on one thread and parse it on another. Only one thread
+      /// may parse a tree at a time.
       ///
       static void installArgppRootInstance (ArgppBase  *pInstance);
       ///
@@ -893,6 +1296,38 @@ namespace argpp {
       ///
       static void installVersionHook (VersionFunc f);
       ///
+      /// @brief Writes C++ source code which defines a table of the help and usage texts
+      /// of the tree of the root instance, formatted as they are now.
+      /// @details The table is a <tt>static const argpp::ArgppPrebuiltHelp</tt> array named
+      /// \c identifier, with one text for --help, one for --usage and the two printed for
+      /// errors. A program can write it at build time, e.g. when it is run with some
+      /// environment variable set, after setting up its parsers as usual and before
+      /// calling parse(), and be compiled again with the table passed to
+      /// installPrebuiltHelp().
+      ///
+      /// The texts are formatted without help filters and translations, with the width
+      /// and other parameters of ARGP_HELP_FMT as currently set, and for the program
+      /// name taken from argv[0].
+      /// @return Returns false if there is no root instance, a parser of the tree has
+      /// a help filter (see installHelpFilter()), or writing to \c out failed.
+      ///
+      static bool writePrebuiltHelp  (FILE *out, const std::string &identifier);
+      ///
+      /// @brief Makes the help and usage texts of \c help, as written by writePrebuiltHelp(),
+      /// take the place of formatting them.
+      /// @details When argp++ formats a help or usage text (see setParseEngine(),
+      /// ArgppPlan, argppStateHelp(), argppUsage() and argppError()), a text of the table
+      /// with the same flags and program name is written with a single call instead,
+      /// provided that the options, the documentation strings and the parameters of
+      /// ARGP_HELP_FMT still have the same fingerprint, that no parser has a help filter,
+      /// and that messages are not being translated (LC_MESSAGES is "C" or "POSIX").
+      /// Otherwise the text is formatted as usual. The help which \b argp_parse() prints
+      /// by itself is not affected.
+      ///
+      /// The table must stay valid as long as it is installed; pass NULL to remove it.
+      ///
+      static void installPrebuiltHelp(const ArgppPrebuiltHelp *help, size_t n);
+      ///
       /// @brief Sets the locale for translating \b argp help messages.
       /// @details If this is an empty string, argp uses either the "libc" domain
       /// (i.e. locale) or whatever the sysem locale uses.
@@ -911,6 +1346,13 @@ namespace argpp {
       /// @details Many of the static functions in ArgppBase will expect the existence of the
       /// root parser in order to be effective.
       ///
+      /// If the library was built with \c thread_local support (see ARGPP_HAVE_THREAD_LOCAL),
+      /// the root instance and all of the state set or returned by the static member
+      /// functions of ArgppBase belong to the tree selected on the calling thread: the
+      /// one created on it, or the one passed to installArgppRootInstance(). Independent
+      /// trees of parsers can therefore be created and parsed on different threads at
+      /// the same time.
+      ///
       static ArgppBase* getRootInstance();
       ///
       /// @brief Destroys all parsers including the root instance.
@@ -930,6 +1372,16 @@ namespace argpp {
       ///
       void installHelpFilter();
       ///
+      /// @brief Makes the help call helpFilterImpl() again for this parser.
+      /// @details helpFilterImpl() is called once for each key and text; what it returns
+      /// is kept with the parser and used by every help, usage and error text printed
+      /// afterwards. Call this function when helpFilterImpl() would now return something
+      /// else, e.g. after the language of the translations has been changed. The help
+      /// texts formatted for a plan (see ArgppPlan) are not affected; build a new one.
+      /// It may also be called from helpFilterImpl() itself.
+      ///
+      void clearHelpFilterCache();
+      ///
       /// @brief Appends a single option to the vector of options.
       /// @details Add all of the options by calling addOption() or addOptions() before calling the
       /// static parse() function.
@@ -973,6 +1425,12 @@ namespace argpp {
       /// @return    : Returns `true` if the option was found, otherwise `false`
       bool findOption        (int key, ArgppOption &opt) const;
       ///
+      /// @brief Returns the option whose long name is `long_name` in `opt`, if found.
+      /// @param long_name : The long option name without the leading "--"
+      /// @param opt       : ArgppOption reference to hold the returned option object
+      /// @return          : Returns `true` if the option was found, otherwise `false`
+      bool findOption        (const std::string &long_name, ArgppOption &opt) const;
+      ///
       /// @brief See documentation of setChildFlags() for details.
       /// @returns Returns a bitmask with the currently set flags which are passed to argp_parse()
       /// in the child \b argp struct member.
@@ -1060,6 +1518,18 @@ namespace argpp {
       ///
       OtherArgs const &     getNonOptionArgs() const;
       ///
+      /// @brief The same as getParsedOptions(), but without copying the strings.
+      /// @details The options are recorded as ParsedOptionView objects while parsing;
+      /// getParsedOptions() makes copies of them the first time it is called. Programs
+      /// which only need the views never pay for the copies.
+      ///
+      ParsedOptionViews const & getParsedOptionViews() const;
+      ///
+      /// @brief The same as getNonOptionArgs(), but without copying the strings.
+      /// @details See getParsedOptionViews().
+      ///
+      NonOptionArgViews const & getNonOptionArgViews() const;
+      ///
       /// @brief Returns the parent of the current object as a
       /// pointer to the base class.
       ///
@@ -1080,7 +1550,8 @@ namespace argpp {
       ///
       /// @brief Adds a child parser to the current object.
       /// @details If the child object already has a parent,
-      /// it will be re-parented here.
+      /// it will be re-parented here. Nothing happens if \c pChild is
+      /// this object or one of its ancestors.
       ///
       void addChild(ArgppBase *pChild);
       ///
@@ -1093,6 +1564,573 @@ namespace argpp {
       /// of children of the current object.
       ///
       bool isGrandChild(ArgppBase* pChild) const;
+      ///
+      /// @brief Registers a subcommand, such as "status" in "tool [OPTION...] status [ARG...]".
+      /// @details Only the name, the factory and the description are stored; the parser of the
+      /// subcommand is not created until parse() finds \c name as the first non-option
+      /// argument of this parser. Then \c factory is called with this object as the parent,
+      /// and the new parser, together with its own children, parses the arguments after the
+      /// name, with the name in the place of the program name. A subcommand's parser can have
+      /// subcommands of its own. The parser is kept for later parses; the parsers of the
+      /// subcommands which are never selected are never created.
+      ///
+      /// While there are subcommands, the options are parsed in order (as with
+      /// argpp::fl_no_reorder), so that an option after the name of the subcommand belongs
+      /// to the subcommand. A non-option argument which is not the name of a subcommand goes
+      /// to keyArgImpl() as usual. The help of this parser lists the subcommands with their
+      /// descriptions, and unless setUsageMessage() has been called, the usage message is
+      /// "COMMAND [ARG...]". ArgppPlan::parse() does not select subcommands.
+      ///
+      /// The argv indexes of the results of a subcommand (see ParsedOptionView::argv_index_)
+      /// refer to getParsedArgv(), like all of the others.
+      /// @param name    : the name of the subcommand.
+      /// @param factory : creates the parser, e.g. &Factory<T>::createSubcommand.
+      /// @param doc     : the description shown in the help.
+      /// @return Returns false if \c name is empty or already taken, or \c factory is NULL.
+      ///
+      bool addSubcommand(const std::string &name
+                         , SubcommandFactory factory
+                         , const std::string &doc = std::string());
+      ///
+      /// @brief Returns the parser of the subcommand of this parser which the last parse
+      /// selected, or NULL if there was none.
+      ///
+      ArgppBase *getSubcommand() const;
+      ///
+      /// @brief Returns the name of the subcommand returned by getSubcommand(), or an
+      /// empty string.
+      ///
+      const std::string &getSubcommandName() const;
+  };
+
+  /**
+ * @brief The results of one call to ArgppPlan::parse().
+ * @details Holds what ArgppBase::parse() leaves in the root instance and in the
+ * static state of ArgppBase, so that each parse against a shared plan has its own.
+ * The views refer to the \b argv which was parsed and must not be used after it
+ * is gone. An object can be reused for any number of parses; each parse clears it
+ * first but keeps the memory of its vectors.
+ */
+  class ARGPP_API ArgppParseResult {
+      friend class impl::ArgppBaseImpl;
+      friend class impl::ArgppPlanImpl;
+      friend class ArgppBatchResults;
+
+    public:
+      ArgppParseResult();
+      ///
+      /// @brief Forgets the results of the last parse.
+      ///
+      void clear();
+      ///
+      /// @brief Returns true once the result has been filled in by ArgppPlan::parse().
+      ///
+      bool wasParsed() const { return parsed_; }
+      ///
+      /// @brief The same as ArgppBase::getRetvalErrorFromArgpParse() for this parse.
+      ///
+      error_t getRetvalErrorFromArgpParse() const;
+      ///
+      /// @brief The same as ArgppBase::getErrorCodeFromArgp() for this parse.
+      ///
+      error_t getErrorCodeFromArgp() const { return error_code_; }
+      ///
+      /// @brief The same as ArgppBase::getArgvIndexAfterArgpParse() for this parse.
+      ///
+      int getArgvIndexAfterArgpParse() const { return arg_idx_; }
+      ///
+      /// @brief The same as ArgppBase::wasHelpEntered() for this parse.
+      ///
+      bool wasHelpEntered() const { return help_called_; }
+      ///
+      /// @brief The options which were parsed, in order, from all of the parsers in
+      /// the tree.
+      ///
+      const ParsedOptionViews &getParsedOptionViews() const { return parsed_views_; }
+      ///
+      /// @brief The non-option arguments, in order.
+      ///
+      const NonOptionArgViews &getNonOptionArgViews() const { return other_arg_views_; }
+      ///
+      /// @brief The same as getParsedOptionViews(), but with copies of the strings.
+      /// @details The copies are only made when this is called.
+      ///
+      const ParsedOptions &getParsedOptions() const;
+      ///
+      /// @brief The same as getNonOptionArgViews(), but with copies of the strings.
+      ///
+      const OtherArgs &getNonOptionArgs() const;
+      ///
+      /// @brief The error messages which \b argp printed during the parse.
+      /// @details Only filled in by ArgppPlan::parseBatch() and ArgppPlan::parseFile(),
+      /// and only where \b open_memstream() is available; empty otherwise.
+      ///
+      const std::string &getErrorMessage() const { return error_msg_; }
+
+    private:
+      ///
+      /// @brief Copies \c s into owned_strings_ and returns a view of the copy.
+      ///
+      ArgppStringView ownString(const std::string &s);
+
+      bool                    parsed_;
+      error_t                 retval_error_;
+      error_t                 error_code_;
+      int                     arg_idx_;
+      bool                    help_called_;
+      std::string             error_msg_;
+      ParsedOptionViews       parsed_views_;
+      NonOptionArgViews       other_arg_views_;
+      ///
+      /// @brief The strings passed to the std::string overloads of addParsedOption()
+      /// and addNonOptionArg(); a std::deque doesn't move its elements when it grows.
+      ///
+      std::deque<std::string> owned_strings_;
+      mutable ParsedOptions   parsed_options_;
+      mutable OtherArgs       other_args_;
+
+      ///
+      /// @brief The copy constructor is not implemented, since the views may refer
+      /// to owned_strings_.
+      ///
+      ArgppParseResult(const ArgppParseResult &);
+      ///
+      /// @brief The copy assignment operator is not implemented.
+      ///
+      ArgppParseResult& operator=(const ArgppParseResult &);
+  };
+
+  /**
+ * @typedef ArgppCommandLine
+ * @brief One command line for ArgppPlan::parseBatch(), including the program name.
+ */
+  typedef std::vector<std::string>      ArgppCommandLine;
+  typedef std::vector<ArgppCommandLine> ArgppCommandLines;
+
+  class ArgppBatchResults;
+
+  /**
+ * @brief Receives the results of ArgppPlan::parseBatch() and ArgppPlan::parseFile(),
+ * one command line at a time.
+ */
+  class ARGPP_API ArgppBatchSink {
+    public:
+      virtual ~ArgppBatchSink();
+      ///
+      /// @brief Called once for each command line, in order.
+      /// @param line   : the index of the command line in the vector passed to
+      /// ArgppPlan::parseBatch(), or its line number (starting with 1) in the file
+      /// passed to ArgppPlan::parseFile().
+      /// @param result : the result of parsing the command line. Its views refer to
+      /// a buffer which is reused for the next line, so they are only valid until
+      /// this function returns.
+      /// @return Return false to stop the batch after this line.
+      ///
+      virtual bool lineParsed(size_t line, const ArgppParseResult &result) = 0;
+      ///
+      /// @brief Called instead of lineParsed() with the results of many lines at once
+      /// when a file is parsed on several threads; the calls are still in order.
+      /// @details The default implementation passes each line to lineParsed() (see
+      /// ArgppBatchResults::replay()).
+      /// @return Return false to stop the batch after these lines.
+      ///
+      virtual bool linesParsed(const ArgppBatchResults &lines);
+  };
+
+  /**
+ * @brief An ArgppBatchSink which keeps the results of a whole batch in a few flat tables.
+ * @details There is one Line for each command line, and its options and non-option
+ * arguments are the ranges of getOptions() and getArgs() it refers to. All of the strings
+ * are copied into one pool, and the long names of the options are stored only once, so
+ * a large batch needs only a handful of allocations.
+ */
+  class ARGPP_API ArgppBatchResults : public ArgppBatchSink {
+      friend class impl::ArgppPlanImpl;
+
+    public:
+      ///
+      /// @brief Stands for "no string" in StringRef::offset_ and for "no long name"
+      /// in Option::name_.
+      ///
+      static const size_t NPOS = static_cast<size_t>(-1);
+
+      ///
+      /// @brief A string in the pool; see getString().
+      ///
+      struct StringRef {
+          size_t offset_;
+          size_t size_;
+
+          StringRef()
+            : offset_(NPOS)
+            , size_  (0) {}
+      };
+
+      ///
+      /// @brief The result of one command line; see ArgppParseResult.
+      ///
+      struct Line {
+          size_t    line_;
+          error_t   retval_error_;
+          error_t   error_code_;
+          int       argv_index_;
+          bool      help_entered_;
+          size_t    first_option_;
+          size_t    num_options_;
+          size_t    first_arg_;
+          size_t    num_args_;
+          StringRef error_msg_;
+      };
+
+      ///
+      /// @brief A parsed option; \c name_ is the index of its long name in getNames(),
+      /// or NPOS if it has none.
+      ///
+      struct Option {
+          int       key_;
+          size_t    name_;
+          StringRef arg_;
+          int       argv_index_;
+      };
+
+      ///
+      /// @brief A non-option argument.
+      ///
+      struct Arg {
+          StringRef arg_;
+          int       argv_index_;
+      };
+
+      typedef std::vector<Line>        Lines;
+      typedef std::vector<Option>      Options;
+      typedef std::vector<Arg>         Args;
+      typedef std::vector<std::string> Names;
+
+      ArgppBatchResults();
+      ///
+      /// @brief Appends the result of one command line to the tables.
+      ///
+      virtual bool lineParsed(size_t line, const ArgppParseResult &result);
+      ///
+      /// @brief Appends the tables of \c lines to ours.
+      ///
+      virtual bool linesParsed(const ArgppBatchResults &lines);
+      ///
+      /// @brief Empties the tables.
+      ///
+      void clear();
+      ///
+      /// @brief Passes each of the lines in turn to \c sink.lineParsed(), as if they
+      /// were being parsed.
+      /// @return Returns false if \c sink asked to stop.
+      ///
+      bool replay(ArgppBatchSink &sink) const;
+
+      const Lines   &getLines()   const { return lines_; }
+      const Options &getOptions() const { return options_; }
+      const Args    &getArgs()    const { return args_; }
+      const Names   &getNames()   const { return names_; }
+      ///
+      /// @brief Returns a view of a string in the pool.
+      /// @details The view is valid until more lines are added.
+      ///
+      ArgppStringView getString(const StringRef &ref) const;
+
+    private:
+      StringRef addString(ArgppStringView s);
+      size_t    addName(ArgppStringView s);
+
+      Lines                         lines_;
+      Options                       options_;
+      Args                          args_;
+      Names                         names_;
+      std::map<std::string, size_t> name_index_;
+      std::string                   pool_;
+  };
+
+  /**
+ * @brief A tree of parsers compiled for parsing any number of command lines,
+ * on any number of threads at the same time.
+ * @details ArgppBase::parse() sets up the \b argp structs inside the parser objects
+ * and stores the results there, too, so a tree can only be parsed once. A plan copies
+ * everything \b argp_parse() needs (options, documentation strings, children,
+ * flags, and the option tables of the native engine) when it is constructed and
+ * never changes afterwards; each call to parse() writes only to its ArgppParseResult
+ * and to the state of the calling thread, so no locking is needed.
+ *
+ * The parser objects are still called back as usual (parserImpl(), keyArgImpl(), ...)
+ * with \b argp_state::input pointing to them, so their callbacks must not modify
+ * them when a plan is shared by several threads. The default implementations only
+ * read them, and addParsedOption() and addNonOptionArg() store into the result of the
+ * parse in progress instead of the parser objects (regardless of
+ * ArgppBase::setRootHasParsedOptions() and ArgppBase::setRootHasNonOptionArgs()).
+ *
+ * The tree must outlive the plan, and no options or children may be added to it while
+ * the plan is in use, since the callbacks look up their options in the parser objects.
+ * The plan does not use the argp structs of the tree, so building another plan or
+ * calling ArgppBase::parse() does not affect it. The engine (see ArgppBase::setParseEngine())
+ * and the flags (see ArgppBase::setArgpParseFlags()) are the ones in effect when the
+ * plan is built, plus argpp::fl_no_exit: parse() never calls exit(). Use
+ * ArgppParseResult::getRetvalErrorFromArgpParse() and ArgppParseResult::wasHelpEntered()
+ * to find out what happened instead.
+ */
+  class ARGPP_API ArgppPlan {
+      friend class ArgppEventReader;
+    public:
+      ///
+      /// @brief Compiles the tree of parsers whose root is \c root.
+      /// @param root : the root of the tree; if NULL, the root instance of the
+      /// calling thread (see ArgppBase::getRootInstance()).
+      ///
+      explicit ArgppPlan(ArgppBase *root = NULL);
+      ~ArgppPlan();
+      ///
+      /// @brief Returns false if there was no tree to compile.
+      ///
+      bool isValid() const { return pimpl_ != NULL; }
+      ///
+      /// @brief Parses a command line.
+      /// @details \c argv is permuted as by \b argp_parse(), so each thread must pass
+      /// its own.
+      /// @param argc   : the number of elements in \c argv.
+      /// @param argv   : the command line, including the program name.
+      /// @param result : receives the parsed options and arguments.
+      /// @return Returns true if \b argp_parse() would have returned 0.
+      ///
+      bool parse(int argc, char **argv, ArgppParseResult &result) const;
+      ///
+      /// @brief Parses each of the command lines in turn and passes the results to \c sink.
+      /// @details The strings in \c lines are not modified. The error messages of \b argp
+      /// are collected in ArgppParseResult::getErrorMessage() instead of being printed
+      /// (except for the ones from \b getopt when the \b argp engine is used, which
+      /// always go to \c stderr). An empty command line is passed to \c sink with the
+      /// error EINVAL.
+      /// @return Returns the number of command lines passed to \c sink.
+      ///
+      size_t parseBatch(const ArgppCommandLines &lines, ArgppBatchSink &sink) const;
+      ///
+      /// @brief Reads one command line from each line of \c in, including the program
+      /// name, and parses it as parseBatch() does.
+      /// @details The lines are split into words as by the shell, with quoting
+      /// and backslash escapes but without any expansion; a \c # at the start of a word
+      /// begins a comment. Lines without any words are skipped. A line with an unclosed
+      /// quote is passed to \c sink with the error EINVAL.
+      ///
+      /// With more than one thread, the calling thread reads \c in in chunks of whole
+      /// lines, the other threads parse them, and the calling thread passes the results
+      /// to ArgppBatchSink::linesParsed() one chunk at a time, in the order of the
+      /// file. Only a few chunks per thread are in memory at any time. The callbacks of
+      /// the parser objects are called on several threads at once; see ArgppPlan. If
+      /// one of them throws, the exception is rethrown here once the threads have
+      /// stopped. Without \c thread_local support (see ARGPP_HAVE_THREAD_LOCAL), the
+      /// lines are always parsed on the calling thread.
+      /// @param threads : the number of threads which parse; 0 means one for each core.
+      /// @return Returns false if \c in could not be read.
+      ///
+      bool parseFile(FILE *in, ArgppBatchSink &sink, unsigned threads = 1) const;
+      ///
+      /// @brief The same as parseFile(FILE*, ArgppBatchSink&, unsigned) for the file
+      /// at \c path.
+      /// @return Returns false if the file could not be opened or read; \b errno tells why.
+      ///
+      bool parseFile(const std::string &path, ArgppBatchSink &sink, unsigned threads = 1) const;
+
+    private:
+      ///
+      /// @brief The opaque pointer to our implementation class.
+      ///
+      impl::ArgppPlanImpl *pimpl_;
+      ///
+      /// @brief The copy constructor of ArgppPlan is not implemented.
+      ///
+      ArgppPlan(const ArgppPlan &);
+      ///
+      /// @brief The copy assignment operator of ArgppPlan is not implemented.
+      ///
+      ArgppPlan& operator=(const ArgppPlan &);
+  };
+
+  /**
+ * @struct ArgppEvent
+ * @brief One item returned by ArgppEventReader::next().
+ */
+  struct ARGPP_API ArgppEvent {
+      enum kind_type {
+        ev_option,    //!< an option with key key_ and, if it has one, the argument arg_
+        ev_arg,       //!< a non-option argument arg_
+        ev_error,     //!< an unknown or ambiguous option, or a missing or unexpected argument
+        ev_end        //!< the end of argv
+      };
+      kind_type       kind_;
+      ///
+      /// @brief The key of the option; for ev_error, the offending character if the
+      /// error concerns a short option, otherwise 0.
+      ///
+      int             key_;
+      ///
+      /// @brief The argument of the option, or the non-option argument; it points
+      /// into \b argv.
+      ///
+      ArgppStringView arg_;
+      ///
+      /// @brief The index of the element of \b argv which contains the argument if
+      /// there is one, otherwise the option itself (see ParsedOptionView).
+      ///
+      int             argv_index_;
+      ///
+      /// @brief The parser which owns the option; NULL for the default options
+      /// of \b argp such as --help and --version, and for the other kinds of event.
+      ///
+      ArgppBase      *parser_;
+
+      ArgppEvent()
+        : kind_      (ev_end)
+        , key_       (0)
+        , arg_       ()
+        , argv_index_(-1)
+        , parser_    (NULL) {}
+  };
+
+  /**
+ * @brief Reads a command line one event at a time, for callers which would rather
+ * pull the options and arguments than have them pushed to the parser callbacks.
+ * @details The command line is split up as by \b getopt_long() with the options
+ * of the plan, but in the order of \b argv, as with ARGP_IN_ORDER, and without
+ * calling any of the parser functions. \b argv is neither permuted nor copied,
+ * and nothing beyond the element which next() returns is looked at, so a caller
+ * which only needs the first few tokens (a subcommand name, for instance) can
+ * simply stop reading and hand getIndex() on to whatever comes next. Everything
+ * after "--" is returned as non-option arguments.
+ *
+ * Errors are not printed; they are returned as ArgppEvent::ev_error, and next()
+ * may be called again to carry on after them. The plan and \b argv must outlive
+ * the reader. Any number of readers may use the same plan at the same time.
+ */
+  class ARGPP_API ArgppEventReader {
+    public:
+      ///
+      /// @brief Prepares to read \c argv with the options of \c plan.
+      /// @param plan : the compiled tree; if it is not valid, there are no events.
+      /// @param argc : the number of elements in \c argv.
+      /// @param argv : the command line, including the program name.
+      ///
+      ArgppEventReader(const ArgppPlan &plan, int argc, char **argv);
+      ~ArgppEventReader();
+      ///
+      /// @brief Reads the next event into \c ev.
+      /// @return Returns false, with ev.kind_ set to ArgppEvent::ev_end,
+      /// once there are no more.
+      ///
+      bool next(ArgppEvent &ev);
+      ///
+      /// @brief Returns the index of the first element of \b argv which has not
+      /// been read completely; getArgc() once everything has been read.
+      ///
+      int  getIndex() const;
+      ///
+      /// @brief Returns the \c argc passed to the constructor.
+      ///
+      int  getArgc() const;
+
+    private:
+      ///
+      /// @brief The opaque pointer to our implementation class.
+      ///
+      impl::ArgppEventReaderImpl *pimpl_;
+      ///
+      /// @brief The copy constructor of ArgppEventReader is not implemented.
+      ///
+      ArgppEventReader(const ArgppEventReader &);
+      ///
+      /// @brief The copy assignment operator of ArgppEventReader is not implemented.
+      ///
+      ArgppEventReader& operator=(const ArgppEventReader &);
+  };
+
+  /**
+ * @struct ArgppApplet
+ * @brief One applet of an ArgppMultiCall.
+ */
+  struct ARGPP_API ArgppApplet {
+      ///
+      /// @brief The name by which the program is called, e.g. the name of a symbolic link.
+      ///
+      const char    *name_;
+      ///
+      /// @brief Creates the root parser of the applet, e.g. &Factory<T>::createApplet.
+      ///
+      AppletFactory  factory_;
+      ///
+      /// @brief A description of the applet for listings; may be NULL.
+      ///
+      const char    *doc_;
+  };
+
+  /**
+ * @brief Selects one of several programs (applets) built into the same binary by the
+ * name under which it was called, as \b busybox does.
+ * @details Each applet registers the factory of its root parser under its name; only
+ * the parser of the applet which is called is created. The name is the base name of
+ * \b argv[0], i.e. everything after the last ARGPP_DIR_SEPARATOR (on Windows, without a
+ * trailing ".exe"). If that is not the name of an applet, the binary was presumably
+ * called by its own name, and \b argv[1] is tried next, so that "prog applet ARG..."
+ * works as well.
+ *
+ * The applets are kept sorted by name and looked up by binary search, so the time it
+ * takes does not depend much on how many there are. A table of applets can be passed
+ * to the constructor in one go, in any order.
+ */
+  class ARGPP_API ArgppMultiCall {
+    public:
+      ArgppMultiCall();
+      ///
+      /// @brief Registers the \c count applets in \c applets.
+      /// @details The strings are not copied and must outlive the object, which is the
+      /// case for a static table. If a name occurs more than once, the first one wins.
+      ///
+      ArgppMultiCall(const ArgppApplet *applets, size_t count);
+      ~ArgppMultiCall();
+      ///
+      /// @brief Registers an applet; the strings are copied.
+      /// @return Returns false if \c name is empty or already taken, or \c factory is NULL.
+      ///
+      bool addApplet(const std::string &name
+                     , AppletFactory factory
+                     , const std::string &doc = std::string());
+      ///
+      /// @brief Returns the applet called \c name, or NULL if there is none.
+      ///
+      const ArgppApplet *findApplet(const char *name) const;
+      ///
+      /// @brief Creates the root parser of the applet which the command line calls.
+      /// @details See ArgppMultiCall for how the applet is found. If it was found in
+      /// \b argv[1], the parser gets the command line from there on, i.e. \c argc - 1 and
+      /// \c argv + 1. Only the factory of that applet is called.
+      /// @return Returns what the factory returned, or NULL if no applet was found.
+      ///
+      ArgppBase *createParser(int argc, char **argv) const;
+      ///
+      /// @brief Returns the number of applets.
+      ///
+      size_t size() const;
+      ///
+      /// @brief Returns the applets in the order of their names, e.g. for listing them.
+      ///
+      const ArgppApplet &operator[](size_t i) const;
+
+    private:
+      ///
+      /// @brief The opaque pointer to our implementation class.
+      ///
+      impl::ArgppMultiCallImpl *pimpl_;
+      ///
+      /// @brief The copy constructor of ArgppMultiCall is not implemented.
+      ///
+      ArgppMultiCall(const ArgppMultiCall &);
+      ///
+      /// @brief The copy assignment operator of ArgppMultiCall is not implemented.
+      ///
+      ArgppMultiCall& operator=(const ArgppMultiCall &);
   };
 
   ///
@@ -1168,6 +2206,22 @@ namespace argpp {
           retval->addOptions(opts);
         return retval;
       }
+      ///
+      /// @brief A SubcommandFactory which creates a T without any options as a child
+      /// of \c parent; see ArgppBase::addSubcommand().
+      ///
+      static ArgppBase* createSubcommand(ArgppBase *parent)
+      {
+        return createParser(ArgppOptions(), parent);
+      }
+      ///
+      /// @brief An AppletFactory which creates a T without any options as the root
+      /// instance; see ArgppMultiCall.
+      ///
+      static ArgppBase* createApplet(int argc, char **argv)
+      {
+        return createParser(argc, argv);
+      }
       //-----------------------------------------------------------------------
       // Overloaded version so that clients don't have to pass the command line
       // arguments each time they create an object. Once the root parser has
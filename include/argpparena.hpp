@@ -0,0 +1,174 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+
+#ifndef ARGPPARENA_H
+#define ARGPPARENA_H
+
+/**
+ * @file argpparena.hpp
+ * @brief Contains the monotonic arena used for memory which lives only as long
+ * as a parse or as the parse results.
+ * @details Like argppbaseimpl.hpp, this header is only needed to build the library.
+ */
+
+#include <cstddef>
+#include <limits>
+#include <new>
+
+//---------------------------------------------------------------
+// Is std::pmr available? If so, ParseArena is built on
+// std::pmr::monotonic_buffer_resource:
+//---------------------------------------------------------------
+#if (__cplusplus >= 201703L) && defined(__has_include)
+#  if __has_include(<memory_resource>)
+#    include <memory_resource>
+#    define ARGPP_HAVE_PMR
+#  endif
+#endif // check for std::pmr
+
+namespace argpp {
+  namespace impl {
+
+    ///
+    /// @class ParseArena
+    /// @brief A monotonic allocator: memory is handed out by bumping a pointer and
+    /// is only given back all at once by release().
+    /// @details The first block is the buffer passed to setBuffer(), if any, so that
+    /// callers can provide a buffer on the stack for the common small case; more
+    /// blocks are taken from the heap as needed, each twice the size of the last.
+    ///
+    class ParseArena
+    {
+      public:
+        ///
+        /// @brief Every allocation is aligned to this many bytes.
+        ///
+        static const size_t ALIGNMENT = 2 * sizeof(void*) > sizeof(double)
+            ? 2 * sizeof(void*) : sizeof(double);
+
+        ParseArena();
+        ~ParseArena();
+        ///
+        /// @brief Releases everything and uses \c buf as the first block from now on.
+        /// @details \c buf must stay valid until release() is called or another
+        /// buffer is set; pass NULL to use only the heap.
+        ///
+        void  setBuffer(void *buf, size_t size);
+        ///
+        /// @brief Returns \c size bytes aligned to ALIGNMENT; never returns NULL.
+        ///
+        void *allocate(size_t size);
+        ///
+        /// @brief Gives back all of the memory allocated so far.
+        ///
+        void  release();
+
+      private:
+#ifdef ARGPP_HAVE_PMR
+        std::pmr::monotonic_buffer_resource *res_;
+        alignas(std::pmr::monotonic_buffer_resource)
+        unsigned char storage_[sizeof(std::pmr::monotonic_buffer_resource)];
+#else
+        struct Block {
+            Block *next_;
+        };
+        void  *buf_;
+        size_t buf_size_;
+        char  *cur_;
+        char  *end_;
+        Block *blocks_;
+        size_t next_size_;
+#endif
+        ParseArena(const ParseArena &);
+        ParseArena& operator=(const ParseArena &);
+    };
+
+    ///
+    /// @class ArenaAllocator
+    /// @brief An allocator for the standard containers which takes its memory from
+    /// a ParseArena; deallocate() does nothing.
+    /// @details With a NULL arena, the global operator new and delete are used.
+    ///
+    template <typename T>
+    class ArenaAllocator
+    {
+      public:
+        typedef T              value_type;
+        typedef T*             pointer;
+        typedef const T*       const_pointer;
+        typedef T&             reference;
+        typedef const T&       const_reference;
+        typedef size_t         size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        template <typename U>
+        struct rebind {
+            typedef ArenaAllocator<U> other;
+        };
+
+        explicit ArenaAllocator(ParseArena *arena = NULL)
+          : arena_(arena) {}
+
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U> &other)
+          : arena_(other.arena()) {}
+
+        pointer allocate(size_type n, const void * = NULL) {
+          if (n > max_size()) {
+            throw std::bad_alloc();
+          }
+          void *p = arena_ ? arena_->allocate(n * sizeof(T))
+                           : ::operator new(n * sizeof(T));
+          return static_cast<pointer>(p);
+        }
+
+        void deallocate(pointer p, size_type) {
+          if (!arena_) {
+            ::operator delete(p);
+          }
+        }
+
+        size_type max_size() const { return std::numeric_limits<size_type>::max() / sizeof(T); }
+
+        void construct(pointer p, const T &val) { new (static_cast<void*>(p)) T(val); }
+        void destroy(pointer p) { p->~T(); }
+
+        pointer       address(reference r) const       { return &r; }
+        const_pointer address(const_reference r) const { return &r; }
+
+        ParseArena *arena() const { return arena_; }
+
+        template <typename U>
+        bool operator==(const ArenaAllocator<U> &other) const { return arena_ == other.arena(); }
+        template <typename U>
+        bool operator!=(const ArenaAllocator<U> &other) const { return arena_ != other.arena(); }
+
+      private:
+        ParseArena *arena_;
+    };
+
+  } // namespace impl
+} // namespace argpp
+
+
+#endif // ARGPPARENA_H
@@ -35,85 +35,246 @@
  */
 
 #include "argpp.hpp"
+#include "argpparena.hpp"
+#include "argpphelp.hpp"
+#include "argppresponse.hpp"
+
+#ifdef ARGPP_HAVE_UNORDERED_MAP
+#  include <unordered_map>
+#  include <unordered_set>
+#else
+#  include <set>
+#endif
+
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+#  include <mutex>
+#  define ARGPP_THREAD_LOCAL thread_local
+#else
+#  define ARGPP_THREAD_LOCAL
+#endif
+
+#ifdef _WIN32
+#  define ARGPP_DIR_SEPARATOR '\\'
+#else
+#  define ARGPP_DIR_SEPARATOR '/'
+#endif
+
+//---------------------------------------------------------------
+// Which engine parse() uses unless ArgppBase::setParseEngine() is
+// called. Define ARGPP_USE_NATIVE_ENGINE to make the native engine
+// the default; this is also done when building against a local
+// argp (e.g. on musl-based systems):
+//---------------------------------------------------------------
+#if defined(WITH_LOCAL_ARGP) && !defined(ARGPP_USE_NATIVE_ENGINE)
+#  define ARGPP_USE_NATIVE_ENGINE
+#endif
+
+#ifdef ARGPP_USE_NATIVE_ENGINE
+#  define ARGPP_DEFAULT_PARSE_ENGINE argpp::eng_native
+#else
+#  define ARGPP_DEFAULT_PARSE_ENGINE argpp::eng_argp
+#endif
 
 namespace argpp {
   namespace impl {
+
+    class ArgppPlanImpl;
+    class NativeTable;
+
+    //-----------------------------------------------------------
+    // Indexes into ArgppBaseImpl::options_ by key and long name:
+    //-----------------------------------------------------------
+#ifdef ARGPP_HAVE_UNORDERED_MAP
+    typedef std::unordered_map<int, size_t>         OptionKeyIndex;
+    typedef std::unordered_map<std::string, size_t> OptionNameIndex;
+#else
+    typedef std::map<int, size_t>                   OptionKeyIndex;
+    typedef std::map<std::string, size_t>           OptionNameIndex;
+#endif
+
+    //-----------------------------------------------------------
+    // The results of helpFilterImpl(), see
+    // ArgppBaseImpl::help_filter_cache_. The key is the key
+    // passed to the filter and the text it was given:
+    //-----------------------------------------------------------
+    typedef std::pair<int, const char*> HelpFilterKey;
     ///
-    /// @class ArgppBaseImpl
-    /// @brief Encapsulates the implementation details and data members of ArgppBase.
-    /// @details Uses the <a href="http://c2.com/cgi/wiki?PimplIdiom" target="_blank">Pimpl idiom</a>
-    /// in order to facilitate binary compatibility with future releases.
+    /// @brief Orders HelpFilterKeys by the key, then by the contents of the text;
+    /// a NULL text comes before any other.
     ///
-    class ArgppBaseImpl
+    struct HelpFilterKeyLess {
+        bool operator()(const HelpFilterKey &a, const HelpFilterKey &b) const;
+    };
+    ///
+    /// @brief The text which the help filter returned for a HelpFilterKey.
+    ///
+    struct HelpFilterResult {
+        std::string text_;
+        ///
+        /// @brief False if the text passed to the filter is used as it is.
+        ///
+        bool        changed_;
+    };
+    typedef std::map<HelpFilterKey, HelpFilterResult, HelpFilterKeyLess> HelpFilterCache;
+
+    //-----------------------------------------------------------
+    // The parsers which exist, see ArgppBaseImpl::registry():
+    //-----------------------------------------------------------
+#ifdef ARGPP_HAVE_UNORDERED_MAP
+    typedef std::unordered_set<const argpp::ArgppBase*> ParserRegistry;
+#else
+    typedef std::set<const argpp::ArgppBase*>           ParserRegistry;
+#endif
+
+#ifdef ARGPP_HAVE_UNIQUE_PTR
+    typedef std::unique_ptr<argpp::ArgppBase> DeleteHelper;
+#else
+    ///
+    /// @class DeleteHelper
+    /// @brief The DeleteHelper class facilitates destruction of the
+    /// root instance (an ArgppBase pointer).
+    /// @details Since it is a member of the ParseContext owning the tree of parsers,
+    /// its destructor calls the destructor of the root instance which destroys
+    /// all of its children recursively (via the destructor of the pimpl_ member
+    /// it contains).
+    ///
+    class DeleteHelper {
+      public:
+        ///
+        /// @brief The defaul constructor sets the pointer member initially to NULL.
+        ///
+        DeleteHelper() : p_(NULL) {}
+        explicit DeleteHelper(ArgppBase *p) : p_(p) {}
+
+        ~DeleteHelper() { if (p_) delete p_; }
+
+        ArgppBase *get() { return p_; }
+
+        const ArgppBase *get() const { return p_; }
+
+        ArgppBase * operator->() { return p_; }
+
+        const ArgppBase * operator->() const { return p_; }
+
+        void reset(ArgppBase *p = NULL) {
+          if (p_) {
+            delete p_;
+          }
+          p_ = p;
+        }
+
+        explicit operator bool() const { return p_ != NULL; }
+      private:
+        ArgppBase *p_;
+        //---------------------------
+        // These are not implemented:
+        //---------------------------
+        ///
+        /// @brief The copy constructor is not implemented.
+        ///
+        DeleteHelper(const DeleteHelper& other);
+        ///
+        /// @brief The copy assignment operator is not implemented.
+        ///
+        DeleteHelper& operator=(const DeleteHelper& other);
+    };
+#endif
+
+    ///
+    /// @class ParseContext
+    /// @brief Holds everything which belongs to one tree of parsers and its parse.
+    /// @details Earlier releases kept these values in static data members of
+    /// ArgppBaseImpl, which allowed only one parse per process. Each tree of parsers
+    /// now has its own ParseContext, which owns the root instance and which every
+    /// parser of the tree points to (see ArgppBaseImpl::ctx_), so independent trees
+    /// do not share any state. The callbacks find the context through the parser in
+    /// \b argp_state::input (see of()), whichever thread the parse runs on.
+    ///
+    /// The static member functions of ArgppBase work on the context selected on the
+    /// calling thread (see current()). A thread starts with a context of its own; it
+    /// selects the context of another tree by passing its root instance to
+    /// ArgppBase::installArgppRootInstance(). A context is destroyed, together with
+    /// its tree, when no thread has it selected any more.
+    ///
+    /// The only state still shared by all threads are the global variables of
+    /// \b argp itself (see ArgppBase::installBugAddress(), ArgppBase::installProgVersion()
+    /// and ArgppBase::installVersionHook()) and the table of prebuilt help texts
+    /// (see ArgppBase::installPrebuiltHelp()), which should be set once before
+    /// any other threads are started.
+    ///
+    class ParseContext
     {
-        friend class argpp::ArgppBase;
-        //------------------------------------------------------------------
-        // The default constructor, copy constructor, and copy assignment
-        // operator of ArgppBaseImpl are not implemented:
-        //------------------------------------------------------------------
+      public:
         ///
-        /// @brief The default constructor of ArgppBaseImpl is not implemented.
+        /// @brief Initializes everything to the same defaults which the static
+        /// data members of ArgppBaseImpl had in earlier releases.
         ///
-        ArgppBaseImpl();
+        ParseContext();
         ///
-        /// @brief The copy constructor of ArgppBaseImpl is not implemented.
+        /// @brief Returns the context selected on the calling thread.
+        /// @details If none has been selected yet, a new one is made for the thread.
         ///
-        ArgppBaseImpl(const ArgppBaseImpl &);
+        static ParseContext &current();
         ///
-        /// @brief The copy assignment operator of ArgppBaseImpl is not implemented.
+        /// @brief Selects \c ctx on the calling thread instead of the context selected
+        /// before, which is destroyed if no other thread has it selected.
         ///
-        ArgppBaseImpl& operator=(const ArgppBaseImpl &);
-        //------------------------------------------------------------------
-        // ArgppBase uses this constructor to initialize its pimpl_ member:
-        //------------------------------------------------------------------
+        static void select(ParseContext *ctx);
         ///
-        /// @brief ArgppBase uses this constructor to initialize its pimpl_ member.
-        /// @param argc : Count of command line arguments passed to main().
-        /// @param argv : Vector of command line arguments passed to main().
-        /// @param parent : Pointer to the parent object (can be NULL).
-        /// @param holder : Pointer to the ArgppBase object doing the initialization.
+        /// @brief Returns the context of the parse which \c state belongs to.
+        /// @details That is the context of ArgppPlan::parse() (see forPlans()) while a
+        /// plan is being parsed on the calling thread, otherwise the context of the tree
+        /// of the parser in \c state->input; current() if there is none, as for the
+        /// parsers which \b argp adds itself, or if \c state is NULL.
         ///
-        ArgppBaseImpl(  int        argc
-                      , char **    argv
-                      , ArgppBase *parent
-                      , ArgppBase *holder);
-        //---------------------------------------------------------------------
-        // The destructor of ArgppBaseImpl deletes all of the children parsers.
-        //---------------------------------------------------------------------
+        static ParseContext &of(const argp_state *state);
         ///
-        /// @brief The destructor of ArgppBaseImpl deletes all of the children parsers.
+        /// @brief Returns the context which ArgppPlan::parse() uses on the calling thread.
+        /// @details It never has a tree; see ArgppPlanImpl::parse().
         ///
-        ~ArgppBaseImpl();
-
-        //---------------------------------------------------------
-        // Static data members...
-        //---------------------------------------------------------
+        static ParseContext &forPlans();
+        ///
+        /// @brief Returns the temporary memory of the native engine on the calling thread,
+        /// released at the end of each parse. See ArgppBase::setScratchBuffer().
+        ///
+        static ParseArena &scratch();
+        ///
+        /// @brief The number of threads which have this context selected.
+        /// @details Only changed by select(), with the lock of the registry held
+        /// (see ArgppBaseImpl::registry()).
+        ///
+        size_t         selections_;
+        ///
+        /// @brief Owns the root instance of the tree of parsers.
+        /// @details See documentation for ArgppBase::getRootInstance().
+        ///
+        DeleteHelper root_;
         ///
         /// @brief When parse() returns, this is set to true.
         ///
-        static bool          parsed_;
+        bool          parsed_;
         ///
         /// @brief Where to collect the parsed options and their arguments.
         /// @details When options are parsed, e.g. in the parserImpl() member function,
         /// this flag determines where they will be added. The default behavior is
         /// for the root instance to collect all of them.
         /// To change this behavior, you can call setRootHasParsedOptions() before calling
-        /// the static parse() function.
+        /// parse().
         ///
         /// Also, see the documentation for rootHasParsedOptions().
         ///
-        static bool          root_has_parsed_options_;
+        bool          root_has_parsed_options_;
         ///
         /// @brief Where to put the non-option arguments.
         /// @details When non-option arguments are parsed, e.g. in the
         /// keyArgImpl() member function, this flag determines where they will be added.
         /// The default value is for the root instance to collect all of them. To
         /// change this behavior, you can call setRootHasNonOptionArgs() before calling
-        /// the static parse() function.
+        /// parse().
         ///
         /// Also, see the documentation for rootHasNonOptionArgs().
         ///
-        static bool          root_has_nonopt_args_;
+        bool          root_has_nonopt_args_;
         ///
         /// @brief These flags are passed to the \b argp_parse() function.
         /// @details Flags are OR'ed together as a bitmask. For details on the values allowed,
@@ -122,7 +283,7 @@ namespace argpp {
         ///
         /// Also, see the documentation for the argpp::argpp_parse_flag enumeration.
         ///
-        static unsigned int  argp_flags_;
+        unsigned int  argp_flags_;
         ///
         /// @brief Determines whether or not argp++ should call exit() after
         /// one of the
@@ -140,37 +301,37 @@ namespace argpp {
         /// Therefore, all of the wrappers for the argp helper functions which take references to
         /// std::string as arguments are implemented by copying the argp_state data, passing the flags together with
         /// ARGP_NO_EXIT, then calling the native helper function, and funally by setting the flag \b argpp_should_exit. Since the helper function wrappers are
-        /// invariably called during one of the parser routines, the code in the static parserRouter()
+        /// invariably called during one of the parser routines, the code in parserRouter()
         /// function checks this flag after the routine returns and calls exit() if it is set. That way,
         /// we can be assured that all of the temporary string objects have been cleaned up before exit()
         /// is called.
         ///
         /// Clients can pass ARGP_NO_EXIT as well, in which case this flag is always false.
         ///
-        static bool          argpp_should_exit_;
+        bool          argpp_should_exit_;
         ///
         /// @brief This is typically returned by one of the
         /// <a href="http://www.gnu.org/software/libc/manual/html_node/Argp-Helper-Functions.html#Argp-Helper-Functions" target="_blank">helper functions</a>.
         /// We store it here in case clients wish to examine it when argp++ doesn't call exit():
         ///
-        static error_t       error_code_from_argp_;
+        error_t       error_code_from_argp_;
         ///
         /// @brief Stores the error code returned from argp_parse().
         /// @details See documentation for ArgppBase::getRetvalErrorFromArgpParse().
         ///
-        static error_t       retval_error_;
+        error_t       retval_error_;
         ///
         /// @brief See documentation for ArgppBase::setDomain() for further details.
         ///
-        static std::string   argp_domain_;
+        std::string   argp_domain_;
         ///
         /// @brief This stores the \b argc parameter passed to main().
         ///
-        static int    argc_;
+        int    argc_;
         ///
         /// @brief This stores the \b argv parameter passed to main().
         ///
-        static char **argv_;
+        char **argv_;
         ///
         /// @brief The constructor of the implementation class examines the command line
         /// in an attempt to find out whether the user entered one of the special options
@@ -180,15 +341,173 @@ namespace argpp {
         /// of the various "key...Impl" routines and avoid running code which isn't
         /// appropriate in such cases.
         ///
-        static bool   help_called_;
+        bool   help_called_;
+        ///
+        /// @brief Set when the argp structs of the tree have been set up by
+        /// ArgppBaseImpl::prepareParserVecs(), and cleared by everything which changes
+        /// the tree (see ArgppBaseImpl::treeChanged()).
+        /// @details parse() and reparse() only set up the argp structs again if it is not set.
         ///
-        /// @brief This is the maximum number of characters allowed in the
-        /// help filter string allocation. Currently it is set to MAX_BLK_SIZE = 16384.
+        bool   vecs_ready_;
+        ///
+        /// @brief Texts returned by the help filter must be shorter than this,
+        /// otherwise the text passed to the filter is used. Currently it is set to 16384.
         /// This value can be overridden by setting an environment variable
-        /// "ARGPP_MAX_HELP_TEXT". The constructor of ArgppBaseImpl queries this
+        /// "ARGPP_MAX_HELP_TEXT". The constructor of the root instance queries this
         /// environment variable and sets it to that size, if set.
         ///
-        static size_t help_max_blk_size_;
+        size_t help_max_blk_size_;
+        ///
+        /// @brief See documentation for ArgppBase::setParseEngine().
+        ///
+        argpp_parse_engine engine_;
+        ///
+        /// @brief The plan being parsed by ArgppPlan::parse(), or NULL; only set in the
+        /// context of forPlans().
+        /// @details While it is set, parserRouter() takes the child inputs from the
+        /// plan instead of the parser objects.
+        ///
+        const ArgppPlanImpl *plan_;
+        ///
+        /// @brief Where addParsedOption() and addNonOptionArg() store the results while
+        /// ArgppPlan::parse() is running on this thread; NULL otherwise.
+        ///
+        ArgppParseResult   *result_;
+        ///
+        /// @brief Where \b argp prints its error messages while a batch is being parsed
+        /// on this thread (see ArgppPlan::parseBatch()); NULL for the default.
+        ///
+        FILE               *err_stream_;
+        ///
+        /// @brief See documentation for ArgppBase::setExpandResponseFiles().
+        ///
+        bool                expand_response_files_;
+        ///
+        /// @brief The command line of the last parse with the response files expanded.
+        ///
+        ResponseFiles       response_files_;
+        ///
+        /// @brief See documentation for ArgppBase::setStopAtFirstNonOption().
+        ///
+        bool                stop_at_first_arg_;
+        ///
+        /// @brief The index in the parsed argv of the first argument which was handed
+        /// off by the last parse; -1 if there was none. See ArgppBase::getRemainingArgv().
+        ///
+        int                 hand_off_index_;
+        ///
+        /// @brief The parser whose subcommand was selected by the last stage of parse();
+        /// NULL if there was none. See ArgppBase::addSubcommand().
+        ///
+        ArgppBase          *subcommand_owner_;
+        ///
+        /// @brief The index in the parsed argv of the \b argv[0] of the stage being parsed,
+        /// i.e. of the name of the subcommand; added to the argv indexes of the results.
+        ///
+        int                 argv_offset_;
+        ///
+        /// @brief \b argp_state::next as parserRouter() last saw it in this parse.
+        /// @details This and the next three members are how parserRouter() follows
+        /// getopt through argv; see trackOption() in argppbaseimpl.cpp.
+        ///
+        int                 seen_next_;
+        ///
+        /// @brief The number of non-options which getopt has skipped so far; they
+        /// end up behind the options when argv has been permuted.
+        ///
+        int                 skipped_args_;
+        ///
+        /// @brief The next option character of the cluster of short options (such as
+        /// "-abc") which getopt is in the middle of, or NULL.
+        ///
+        const char         *short_cluster_;
+        ///
+        /// @brief The index in argv of the option being parsed, as ParsedOptionView
+        /// has it, or -1.
+        ///
+        int                 option_index_;
+        ///
+        /// @brief The sorted options of the tree for the help; see renderHelp().
+        /// @details Cleared by ArgppBaseImpl::treeChanged().
+        ///
+        HelpLayout          help_layout_;
+      private:
+        class Selection;
+        ///
+        /// @brief Returns the selection of the calling thread.
+        ///
+        static Selection &selection();
+        ///
+        /// @brief Replaces \c selected by \c ctx and destroys the context which was
+        /// in \c selected if no other thread has it selected.
+        ///
+        static void reselect(ParseContext *&selected, ParseContext *ctx);
+        ///
+        /// @brief The copy constructor of ParseContext is not implemented.
+        ///
+        ParseContext(const ParseContext &);
+        ///
+        /// @brief The copy assignment operator of ParseContext is not implemented.
+        ///
+        ParseContext& operator=(const ParseContext &);
+    };
+
+    ///
+    /// @class ArgppBaseImpl
+    /// @brief Encapsulates the implementation details and data members of ArgppBase.
+    /// @details Uses the <a href="http://c2.com/cgi/wiki?PimplIdiom" target="_blank">Pimpl idiom</a>
+    /// in order to facilitate binary compatibility with future releases.
+    ///
+    class ArgppBaseImpl
+    {
+        friend class argpp::ArgppBase;
+        friend class ParseContext;
+        friend class NativeTable;
+        friend class NativeParser;
+        friend class ArgppPlanImpl;
+        friend class ArgppMultiCallImpl;
+        friend class HelpLayout;
+        //------------------------------------------------------------------
+        // The default constructor, copy constructor, and copy assignment
+        // operator of ArgppBaseImpl are not implemented:
+        //------------------------------------------------------------------
+        ///
+        /// @brief The default constructor of ArgppBaseImpl is not implemented.
+        ///
+        ArgppBaseImpl();
+        ///
+        /// @brief The copy constructor of ArgppBaseImpl is not implemented.
+        ///
+        ArgppBaseImpl(const ArgppBaseImpl &);
+        ///
+        /// @brief The copy assignment operator of ArgppBaseImpl is not implemented.
+        ///
+        ArgppBaseImpl& operator=(const ArgppBaseImpl &);
+        //------------------------------------------------------------------
+        // ArgppBase uses this constructor to initialize its pimpl_ member:
+        //------------------------------------------------------------------
+        ///
+        /// @brief ArgppBase uses this constructor to initialize its pimpl_ member.
+        /// @param argc : Count of command line arguments passed to main().
+        /// @param argv : Vector of command line arguments passed to main().
+        /// @param parent : Pointer to the parent object (can be NULL).
+        /// @param holder : Pointer to the ArgppBase object doing the initialization.
+        ///
+        ArgppBaseImpl(  int        argc
+                      , char **    argv
+                      , ArgppBase *parent
+                      , ArgppBase *holder);
+        //---------------------------------------------------------------------
+        // The destructor of ArgppBaseImpl deletes all of the children parsers.
+        //---------------------------------------------------------------------
+        ///
+        /// @brief The destructor of ArgppBaseImpl deletes all of the children parsers.
+        ///
+        ~ArgppBaseImpl();
+
+        //---------------------------------------------------------
+        // Static data members...
+        //---------------------------------------------------------
         ///
         /// @brief The name of the environment variable to check, currently
         /// set to "ARGPP_MAX_HELP_TEXT".
@@ -200,9 +519,9 @@ namespace argpp {
         //---------------------------------------------------------
         ///
         /// @brief See documentation for argpp::ArgppBase::wasHelpEntered()
-        /// and for the static member variable help_called_ for more details.
+        /// and for ParseContext::help_called_ for more details.
         ///
-        static bool wasHelpEntered() { return help_called_; }
+        static bool wasHelpEntered() { return ParseContext::of(NULL).help_called_; }
         ///
         /// @brief See documentation for argpp::ArgppBase::getRetvalErrorFromArgpParse()
         /// for more details.
@@ -217,22 +536,22 @@ namespace argpp {
         /// @brief See documentation for argpp::ArgppBase::setRootHasParsedOptions()
         /// for more details.
         ///
-        static void setRootHasParsedOptions(bool set_root) { root_has_parsed_options_ = set_root; }
+        static void setRootHasParsedOptions(bool set_root) { ParseContext::current().root_has_parsed_options_ = set_root; }
         ///
         /// @brief See documentation for argpp::ArgppBase::setRootHasNonOptionArgs()
         /// for more details.
         ///
-        static void setRootHasNonOptionArgs(bool set_root) { root_has_nonopt_args_ = set_root; }
+        static void setRootHasNonOptionArgs(bool set_root) { ParseContext::current().root_has_nonopt_args_ = set_root; }
         ///
         /// @brief See documentation for argpp::ArgppBase::rootHasParsedOptions()
         /// for more details.
         ///
-        static bool rootHasParsedOptions() { return root_has_parsed_options_; }
+        static bool rootHasParsedOptions() { return ParseContext::current().root_has_parsed_options_; }
         ///
         /// @brief See documentation for argpp::ArgppBase::rootHasNonOptionArgs()
         /// for more details.
         ///
-        static bool rootHasNonOptionArgs() { return root_has_nonopt_args_; }
+        static bool rootHasNonOptionArgs() { return ParseContext::current().root_has_nonopt_args_; }
         ///
         /// @brief Called by addOptions() to detect the null delimiting option
         /// (an entry with zero in all fields).
@@ -254,6 +573,13 @@ namespace argpp {
         static void argppError (const argp_state *state
                              , std::string const &errmsg);
         ///
+        /// @brief Returns the line which argppError() prints before the usage:
+        /// the name of the program, as argp takes it from state->name or argv[0],
+        /// followed by \c errmsg.
+        ///
+        static std::string errorLine(const argp_state *state
+                                   , std::string const &errmsg);
+        ///
         /// @brief See documentation for
         /// ArgppBase::argppFailure()
         ///
@@ -275,6 +601,26 @@ namespace argpp {
                                  , unsigned flags);
         ///
         /// @brief See documentation for
+        /// ArgppBase::argppError(const argp_state*, const std::string&, std::string&)
+        ///
+        static void argppError (const argp_state *state
+                             , std::string const &errmsg
+                             , std::string &out);
+        ///
+        /// @brief See documentation for
+        /// ArgppBase::argppUsage(const argp_state*, std::string&)
+        ///
+        static void argppUsage (const argp_state *state
+                             , std::string &out);
+        ///
+        /// @brief See documentation for
+        /// ArgppBase::argppStateHelp(const argp_state*, std::string&, unsigned)
+        ///
+        static void argppStateHelp(const argp_state *state
+                                 , std::string &out
+                                 , unsigned flags);
+        ///
+        /// @brief See documentation for
         /// ArgppBase::clearAllParsers()
         ///
         static void clearAllParsers();
@@ -300,6 +646,24 @@ namespace argpp {
         ///
         static char *  helpFilter(int key, const char *text, void *input);
         ///
+        /// @brief Same as helpFilter(), except that a text returned by helpFilterImpl()
+        /// is not copied; it belongs to the cache of the parser.
+        ///
+        static const char *filteredText(int key, const char *text, void *input);
+        ///
+        /// @brief Returns the input which the group of \c ap gets in the parse of \c state,
+        /// i.e. the parser which owns \c ap, as \b argp passes it to the help filter.
+        /// @details The parser is looked up in the tree (or the plan) being parsed, not
+        /// in \b argp_state::pstate, whose layout is private to \b argp. Returns NULL for
+        /// the groups of the default options and if \c state is NULL.
+        ///
+        static void *argpInput(const argp *ap, const argp_state *state);
+        ///
+        /// @brief Returns the parser whose argp struct is \c ap, looking in the tree below
+        /// \c p including the subcommands which have been instantiated; NULL if none.
+        ///
+        static ArgppBase *argpOwner(ArgppBase *p, const argp *ap);
+        ///
         /// @brief See documentation for ArgppBase::flagOk().
         ///
         static bool internalFlagCheck(unsigned &val, unsigned chk);
@@ -320,6 +684,14 @@ namespace argpp {
         ///
         static void installVersionHook(VersionFunc f);
         ///
+        /// @brief See documentation for ArgppBase::writePrebuiltHelp().
+        ///
+        static bool writePrebuiltHelp(FILE *out, const std::string &identifier);
+        ///
+        /// @brief See documentation for ArgppBase::installPrebuiltHelp().
+        ///
+        static void installPrebuiltHelp(const ArgppPrebuiltHelp *help, size_t n);
+        ///
         /// @brief See documentation for ArgppBase::isParentValid().
         ///
         static bool isParentValid(ArgppBase  *parent);
@@ -339,10 +711,71 @@ namespace argpp {
         ///
         static error_t parserRouter(int key, char *arg, argp_state *state);
         ///
+        /// @brief Returns the value of argpp::argpp_lifecycle_key for \c key, e.g. argpp::lk_end
+        /// for ARGP_KEY_END, or 0 for ARGP_KEY_INIT, ARGP_KEY_ARG and the options.
+        ///
+        static unsigned int lifecycleKey(int key);
+        ///
+        /// @brief Answers the hidden options with the key HELP_SEARCH_KEY, i.e. "--help",
+        /// "--help=PATTERN" and "--help-group=N" or "--help-group N", which setupOptions()
+        /// adds to the options of the parser at the top of a parse unless the tree has options
+        /// of these names.
+        /// @details Plain "--help" prints the help as argp's own option would. Either way,
+        /// exit() is called afterwards unless the flags include ARGP_NO_EXIT. A group which
+        /// is missing or not a number, and a search which finds nothing, are errors
+        /// reported by argppError().
+        ///
+        static error_t helpSearch(const char *arg, argp_state *state);
+        ///
         /// @brief See documentation for ArgppBase::parse()
         ///
         static bool parse();
         ///
+        /// @brief See documentation for ArgppBase::reparse()
+        ///
+        static bool reparse(int argc, char **argv);
+        ///
+        /// @brief Returns true if one of the arguments before "--", if any, is a request
+        /// for help or the version (see isHelpRequest() and isHelpSearch()).
+        /// @details An argument which looks like one is resolved against all the options
+        /// of the tree, i.e. \c table, or else a NativeTable built from \c root once such
+        /// an argument turns up, so that e.g. "--v" is not taken for --version if the
+        /// program has a --verbose option, nor is "-o --help" a request for help if -o takes
+        /// an argument. If both are NULL, as when the root instance is constructed, only
+        /// argp's default options are known.
+        ///
+        static bool helpRequested(int argc, char **argv
+                                  , const argp *root, const NativeTable *table = NULL);
+        ///
+        /// @brief Returns the part of \c path after the last ARGPP_DIR_SEPARATOR, or
+        /// \c path itself if there is none.
+        ///
+        static const char *baseName(const char *path);
+        ///
+        /// @brief Returns the name of the program for error messages, as argp takes
+        /// it from argv[0], or an empty string if there is none.
+        ///
+        static const char *programName(char **argv);
+        ///
+        /// @brief Expands the response files of the command line into
+        /// ParseContext::response_files_ for parse().
+        /// @details If that fails, the error is reported as by \b argp_failure(), and
+        /// exit() is called unless ARGP_NO_EXIT is set.
+        /// @return Returns false if the command line can't be parsed.
+        ///
+        static bool expandResponseFiles(int argc, char **argv);
+        ///
+        /// @brief Runs the engine on the tree whose root is \c top, for parse().
+        /// @details \c top is the root instance, or the parser of the subcommand selected
+        /// by the stage before, which is parsed with the rest of the command line.
+        ///
+        static error_t parseStage(ArgppBase *top, int argc, char **argv);
+        ///
+        /// @brief Called by everything which changes the argp structs of the tree whose
+        /// context is \c ctx, so that the next parse sets them up again.
+        ///
+        static void treeChanged(ParseContext &ctx);
+        ///
         /// @brief See documentation for ArgppBase::setArgpParseFlags()
         ///
         static bool setArgpParseFlags(unsigned int);
@@ -361,11 +794,59 @@ namespace argpp {
         ///
         /// @brief See documentation for ArgppBase::getArgc()
         ///
-        static int getArgc() { return argc_; }
+        static int getArgc() { return ParseContext::of(NULL).argc_; }
+        ///
+        /// @brief See documentation for ArgppBase::setParseEngine()
+        ///
+        static bool setParseEngine(argpp_parse_engine eng);
+        ///
+        /// @brief See documentation for ArgppBase::getParseEngine()
+        ///
+        static argpp_parse_engine getParseEngine() { return ParseContext::current().engine_; }
+        ///
+        /// @brief See documentation for ArgppBase::setScratchBuffer()
+        ///
+        static void setScratchBuffer(void *buf, size_t size) { ParseContext::scratch().setBuffer(buf, size); }
+        ///
+        /// @brief Gives ArgppPlanImpl access to the implementation of a parser.
+        ///
+        static ArgppBaseImpl *implOf(ArgppBase *p) { return p->pimpl_; }
         ///
         /// @brief See documentation for ArgppBase::getArgv()
         ///
-        static char** getArgv() { return argv_; }
+        static char** getArgv() { return ParseContext::of(NULL).argv_; }
+        ///
+        /// @brief See documentation for ArgppBase::getParsedArgc()
+        ///
+        static int getParsedArgc();
+        ///
+        /// @brief See documentation for ArgppBase::getParsedArgv()
+        ///
+        static char** getParsedArgv();
+        ///
+        /// @brief See documentation for ArgppBase::setExpandResponseFiles()
+        ///
+        static void setExpandResponseFiles(bool expand) { ParseContext::current().expand_response_files_ = expand; }
+        ///
+        /// @brief See documentation for ArgppBase::expandsResponseFiles()
+        ///
+        static bool expandsResponseFiles() { return ParseContext::current().expand_response_files_; }
+        ///
+        /// @brief See documentation for ArgppBase::setStopAtFirstNonOption()
+        ///
+        static void setStopAtFirstNonOption(bool stop) { ParseContext::current().stop_at_first_arg_ = stop; }
+        ///
+        /// @brief See documentation for ArgppBase::stopsAtFirstNonOption()
+        ///
+        static bool stopsAtFirstNonOption() { return ParseContext::current().stop_at_first_arg_; }
+        ///
+        /// @brief See documentation for ArgppBase::getRemainingArgc()
+        ///
+        static int getRemainingArgc();
+        ///
+        /// @brief See documentation for ArgppBase::getRemainingArgv()
+        ///
+        static char** getRemainingArgv();
 
         //----------------------------------------------------------
         // Non-static member functions:
@@ -375,6 +856,18 @@ namespace argpp {
         ///
         void addChild(ArgppBase* pChild);
         ///
+        /// @brief See documentation for ArgppBase::addSubcommand()
+        ///
+        bool addSubcommand(const std::string &name, SubcommandFactory factory, const std::string &doc);
+        ///
+        /// @brief See documentation for ArgppBase::getSubcommand()
+        ///
+        ArgppBase *getSubcommand() const;
+        ///
+        /// @brief See documentation for ArgppBase::getSubcommandName()
+        ///
+        const std::string &getSubcommandName() const;
+        ///
         /// @brief See documentation for ArgppBase::addOption(const ArgppOption &opt)
         ///
         bool addOption(const ArgppOption &opt);
@@ -399,6 +892,18 @@ namespace argpp {
         ///
         void addNonOptionArg(const std::string &arg);
         ///
+        /// @brief See documentation for ArgppBase::addParsedOption(const ParsedOptionView &)
+        ///
+        void addParsedOption(ParsedOptionView const &opt);
+        ///
+        /// @brief See documentation for ArgppBase::addNonOptionArg(const NonOptionArgView &)
+        ///
+        void addNonOptionArg(NonOptionArgView const &arg);
+        ///
+        /// @brief See documentation for ArgppBase::setLifecycleKeys()
+        ///
+        bool setLifecycleKeys(unsigned keys);
+        ///
         /// @brief Returns the ArgppOption corresponding to `key` in `opt`.
         /// @details This function is useful within code which has no direct access to anything
         /// but the `key`, but `addParsedOption` needs to be called.
@@ -408,6 +913,32 @@ namespace argpp {
         ///
         bool findOption(int key, ArgppOption &opt) const;
         ///
+        /// @brief Returns the ArgppOption whose long name is `long_name` in `opt`.
+        /// @return    : returns `true` if the option was found, otherwise `false`
+        ///
+        bool findOption(const std::string &long_name, ArgppOption &opt) const;
+        ///
+        /// @brief Returns the context which the results of this parser go to: that of
+        /// ArgppPlan::parse() while a plan is being parsed on the calling thread (see
+        /// ParseContext::of()), otherwise that of the tree.
+        ///
+        ParseContext &context() const;
+        ///
+        /// @brief Returns the instance which stores the parsed options or the non-option
+        /// arguments: the root instance of the tree if \c to_root is set, otherwise this one.
+        /// @return NULL if \c to_root is set but there is no root instance.
+        ///
+        ArgppBaseImpl *resultsOwner(bool to_root);
+        ///
+        /// @brief Returns the vector which addNonOptionArg() appends to: that of the
+        /// ArgppParseResult of a plan being parsed, or else that of resultsOwner().
+        ///
+        NonOptionArgViews *nonOptionArgSink();
+        ///
+        /// @brief Copies \c s into strings_ and returns a view of the copy.
+        ///
+        ArgppStringView ownString(const std::string &s);
+        ///
         /// @brief See documentation of argpp::ArgppBase::setChildFlags() for details.
         ///
         unsigned int childFlags() const { return static_cast<unsigned int>(child_argp_.flags); }
@@ -416,6 +947,10 @@ namespace argpp {
         ///
         error_t implKeyArg(const char* arg, argp_state *state);
         ///
+        /// @brief See documentation for ArgppBase::readNonOptionArgs()
+        ///
+        error_t readNonOptionArgs(int fd, char delim, NonOptionArgFunc func, void *data);
+        ///
         /// @brief See documentation for ArgppBase::genericParserImpl()
         ///
         error_t genericParserImpl(int key, const char *arg, argp_state *state);
@@ -444,10 +979,27 @@ namespace argpp {
         ///
         OtherArgs const & getNonOptionArgs() const;
         ///
+        /// @brief See documentation for ArgppBase::getParsedOptionViews()
+        ///
+        const ParsedOptionViews &getParsedOptionViews() const { return parsed_views_; }
+        ///
+        /// @brief See documentation for ArgppBase::getNonOptionArgViews()
+        ///
+        const NonOptionArgViews &getNonOptionArgViews() const { return other_arg_views_; }
+        ///
         /// @brief See documentation for ArgppBase::installHelpFilter()
         ///
         void installHelpFilter();
         ///
+        /// @brief See documentation for ArgppBase::clearHelpFilterCache()
+        ///
+        void clearHelpFilterCache();
+        ///
+        /// @brief Returns what helpFilterImpl() returns for \c key and \c text, or
+        /// \c text if that is to be used as it is; see help_filter_cache_.
+        ///
+        const char *filterText(int key, const char *text);
+        ///
         /// @brief See documentation for ArgppBase::isChildOfThisParent()
         ///
         bool isChildOfThisParent(ArgppBase* pChild) const;
@@ -456,12 +1008,63 @@ namespace argpp {
         ///
         bool isGrandChild(ArgppBase* pChild) const;
         ///
+        /// @brief Returns the parent whose children_ contain \c p, or NULL.
+        ///
+        static ArgppBase *listedParent(const ArgppBase *p);
+        ///
+        /// @brief Every parser which has been created and not yet destroyed, on any
+        /// thread, so that pointers passed in by clients can be checked without
+        /// dereferencing them.
+        /// @details Only used with the lock of registryMutex() held.
+        ///
+        static ParserRegistry &registry();
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+        ///
+        /// @brief Guards registry() and ParseContext::selections_.
+        ///
+        static std::mutex &registryMutex();
+#endif
+        ///
+        /// @brief Returns true if \c p is a parser which exists (see registry()).
+        ///
+        static bool isRegistered(const ArgppBase *p);
+        ///
+        /// @brief Returns true if this parser or one of the children which are parsed
+        /// together with it has any subcommands.
+        ///
+        bool hasSubcommands() const;
+        ///
+        /// @brief Returns true if this parser or one of the children which are parsed
+        /// together with it has an option called \c name, not counting documentation
+        /// options.
+        ///
+        bool hasLongOption(const char *name) const;
+        ///
+        /// @brief Returns true if this parser is at the top of a parse, i.e. the root or
+        /// the parser of a subcommand, which adds the options of helpSearch() to its own.
+        ///
+        bool answersHelpSearch() const;
+        ///
+        /// @brief Selects the subcommand called \c name, if there is one.
+        ///
+        bool selectSubcommand(const char *name);
+        ///
+        /// @brief Creates the parser of the selected subcommand the first time it is
+        /// selected, and returns it; NULL if the factory failed.
+        ///
+        ArgppBase *instantiateSubcommand();
+        ///
         /// @brief This is called by parse() before argp_parse() is called.
         /// @details It calls setupOptions() and setupChildren(), and calls
         /// prepareParserVecs() on all of its children.
         ///
         void prepareParserVecs();
         ///
+        /// @brief Forgets the parse results of this parser and all of its children.
+        /// @details The vectors keep their memory for the next parse.
+        ///
+        void clearResults();
+        ///
         /// @brief Removes the child from the parent's vector of children if it is found.
         /// @param pChild : See documentation for ArgppBase::addChild().
         ///
@@ -527,6 +1130,10 @@ namespace argpp {
         ///
         bool installed_help_filter_;
         ///
+        /// @brief The hooks which the holder implements; see ArgppBase::setLifecycleKeys().
+        ///
+        unsigned int lifecycle_keys_;
+        ///
         /// @brief Stores a pointer to the ArgppBase instance of which the current ArgppBaseImpl
         /// object is contained in its pimpl_ member.
         ///
@@ -537,6 +1144,17 @@ namespace argpp {
         ///
         ArgppBase *holders_parent_;
         ///
+        /// @brief The context of the tree: the one of the parent, or for a root instance
+        /// the one selected on the thread which created it.
+        ///
+        ParseContext *ctx_;
+        ///
+        /// @brief True while holder_ is in the children_ of holders_parent_.
+        /// @details This makes isChildOfThisParent() a constant-time check and lets
+        /// isGrandChild() follow the parents up instead of searching the children.
+        ///
+        bool listed_;
+        ///
         /// @brief The top-level argp struct for this instance.
         /// @details The argp structs of the children of holder_ will be formed into an array
         /// before argp_parse() is called. A pointer to the first element of that array
@@ -603,12 +1221,50 @@ namespace argpp {
         ///
         ArgppChildren children_;
         ///
-        /// @brief A std::map which correlates the vector of children with the vector
-        /// of argp_child structs after prepareParserVecs() has been called.
-        /// @details See documentation of parserRouter() as well as comments in the
-        /// source code for more details.
+        /// @brief The children which are in children_vec_, in the same order, after
+        /// prepareParserVecs() has been called.
+        /// @details Element \c i is what parserRouter() stores in \b child_inputs[i]; see
+        /// the comments in the source code for more details.
+        ///
+        ArgppChildren child_inputs_;
+        ///
+        /// @brief A subcommand registered with addSubcommand().
+        ///
+        struct Subcommand {
+            std::string        name_;
+            std::string        doc_;
+            SubcommandFactory  factory_;
+            ///
+            /// @brief The number of subcommands added before this one; the help lists
+            /// them in that order.
+            ///
+            size_t             order_;
+            ///
+            /// @brief The parser, once the subcommand has been selected; it is one of
+            /// the children_ of this parser.
+            ///
+            ArgppBase         *parser_;
+        };
+        typedef std::vector<Subcommand> Subcommands;
+        ///
+        /// @brief The subcommands, sorted by name for selectSubcommand().
         ///
-        MapOfChildren map_of_children_;
+        Subcommands subcommands_;
+        ///
+        /// @brief Orders the subcommands by name, as ArgppMultiCallImpl does the applets.
+        ///
+        static bool subcommandNameLess(const Subcommand &sc, const char *name);
+        ///
+        /// @brief The index in subcommands_ of the subcommand selected by the last parse,
+        /// or NO_SUBCOMMAND.
+        ///
+        size_t selected_subcommand_;
+        static const size_t NO_SUBCOMMAND = static_cast<size_t>(-1);
+        ///
+        /// @brief True for the parser of a subcommand; the parent leaves it out of
+        /// its argp struct, since it only ever parses the arguments after its name.
+        ///
+        bool is_subcommand_;
         ///
         /// @brief A std::vector of ArgppOptions.
         /// @details These are copied into a vector of \c \b argp_option structs in
@@ -616,18 +1272,65 @@ namespace argpp {
         ///
         ArgppOptions options_;
         ///
+        /// @brief Maps the key of each option to its index in options_.
+        /// @details Maintained by addOption(); the first option added with a given
+        /// key wins, as it does for std::find() with ArgppOption::operator==().
+        /// This makes supportedOption() and findOption(), which are called for every
+        /// parsed option, independent of the number of options.
+        ///
+        OptionKeyIndex key_index_;
+        ///
+        /// @brief Maps the long name of each option to its index in options_.
+        ///
+        OptionNameIndex name_index_;
+        ///
+        /// @brief What helpFilterImpl() returned for each key and text, so that it is
+        /// only called once for each; see ArgppBase::clearHelpFilterCache().
+        /// @details The texts of the keys are the copies kept in help_filter_texts_,
+        /// since the help formatters may pass a temporary copy of a doc string.
+        ///
+        HelpFilterCache help_filter_cache_;
+        std::deque<std::string> help_filter_texts_;
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+        ///
+        /// @brief Guards the cache, since a plan may format the help on several
+        /// threads at once (see ArgppPlan::parseFile()).
+        ///
+        std::mutex help_filter_mutex_;
+#endif
+        ///
+        /// @brief The successfully parsed options, in the order in which they were added.
+        /// @details This is where the options are recorded; parsed_options_ holds copies
+        /// of the same options which are only made when getParsedOptions() is called.
+        ///
+        ParsedOptionViews parsed_views_;
+        ///
+        /// @brief The non-option arguments, in the order in which they were added.
+        /// @details See parsed_views_.
+        ///
+        NonOptionArgViews other_arg_views_;
+        ///
+        /// @brief Holds the strings passed to the overloads of addParsedOption() and
+        /// addNonOptionArg() taking std::string arguments, which the views refer to.
+        /// @details The arena never moves what it has handed out, and all of the
+        /// strings are freed together when the instance is destroyed.
+        ///
+        ParseArena strings_;
+        ///
         /// @brief A std::vector of ParsedOption objects.
         /// @details After parsing has finished, derived implementations can fetch the
-        /// successfully parsed options by calling getParsedOptions().
+        /// successfully parsed options by calling getParsedOptions(), which copies any
+        /// options from parsed_views_ which are not here yet.
         ///
-        ParsedOptions parsed_options_;
+        mutable ParsedOptions parsed_options_;
         ///
         /// @brief A std::vector of strings containing the non-option arguments entered
         /// on the command line.
         /// @details After parsing has finished, derived implementations can fetch the
-        /// successfully parsed non-option arguments by calling getNonOptionArgs().
+        /// successfully parsed non-option arguments by calling getNonOptionArgs(), which
+        /// copies any arguments from other_arg_views_ which are not here yet.
         ///
-        OtherArgs other_args_;
+        mutable OtherArgs other_args_;
     };
 
   } // namespace impl
@@ -0,0 +1,102 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+
+#ifndef ARGPPCMDLINE_H
+#define ARGPPCMDLINE_H
+
+/**
+ * @file argppcmdline.hpp
+ * @brief Contains the splitter which turns a line of text into an \b argv.
+ * @details Like argppbaseimpl.hpp, this header is only needed to build the library.
+ */
+
+#include <cstddef>
+#include <vector>
+
+namespace argpp {
+  namespace impl {
+
+    ///
+    /// @class CommandLineSplitter
+    /// @brief Splits text into words as the POSIX shell does, but without any expansions.
+    /// @details Words are separated by blanks, including newlines. Single quotes preserve
+    /// everything up to the next single quote; double quotes do the same, except that a
+    /// backslash escapes \c $, \c `, \c " and \c \\. Elsewhere a backslash preserves the
+    /// next character, and a backslash followed by a newline is removed everywhere except
+    /// inside single quotes. Quoted and unquoted parts next to each other make up one word,
+    /// so \c "" is an empty word. An unquoted \c # at the start of a word begins a comment
+    /// which runs to the end of the line.
+    ///
+    /// split() copies the words into a buffer which is reused by the next call, so that
+    /// splitting many lines allocates nothing once the buffer is large enough; splitInPlace()
+    /// doesn't copy at all.
+    ///
+    class CommandLineSplitter
+    {
+      public:
+        CommandLineSplitter();
+        ///
+        /// @brief Splits the text from \c begin up to \c end.
+        /// @return Returns false if a quote is not closed; see error().
+        ///
+        bool split(const char *begin, const char *end);
+        ///
+        /// @brief The number of words found by the last call to split().
+        ///
+        int argc() const { return static_cast<int>(argv_.size() - 1); }
+        ///
+        /// @brief The words found by the last call to split(), followed by NULL.
+        /// @details The pointers stay valid until split() is called again.
+        ///
+        char **argv() { return &argv_[0]; }
+        ///
+        /// @brief Describes why the last call to split() failed, or NULL if it didn't.
+        ///
+        const char *error() const { return error_; }
+        ///
+        /// @brief Splits the text from \c begin up to \c end where it is, and appends
+        /// a pointer to each word to \c words.
+        /// @details The words are unquoted and terminated by a NUL character inside the
+        /// text, so there must be room for one more character at \c end. If a quote
+        /// is not closed, the text is left in an undefined state.
+        /// @return Returns NULL, or a description of the error.
+        ///
+        static const char *splitInPlace(char *begin, char *end, std::vector<char*> &words);
+
+      private:
+        ///
+        /// @brief A copy of the text, which is split in place.
+        ///
+        std::vector<char>  words_;
+        std::vector<char*> argv_;
+        const char        *error_;
+
+        CommandLineSplitter(const CommandLineSplitter &);
+        CommandLineSplitter& operator=(const CommandLineSplitter &);
+    };
+
+  } // namespace impl
+} // namespace argpp
+
+
+#endif // ARGPPCMDLINE_H
@@ -0,0 +1,364 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+
+#ifndef ARGPPHELP_H
+#define ARGPPHELP_H
+
+/**
+ * @file argpphelp.hpp
+ * @brief Contains the native formatter of the help and usage texts.
+ * @details The output is the same as that of \b argp_state_help(), byte for byte:
+ * the options are sorted and the text is wrapped exactly as argp-help.c and
+ * argp-fmtstream.c do it, and the help filters are called with the same keys
+ * in the same order. The difference is that the sorted list of options is
+ * kept from one call to the next, and that the text is formatted in memory
+ * and written to the stream all at once. The formatted texts are kept, too,
+ * so that showing the same help again only copies it.
+ *
+ * It also answers "--help=PATTERN" and "--help-group=N", which argp does not
+ * know, by formatting only the entries of the options which match, and writes
+ * texts which were formatted at build time instead of formatting them again
+ * (see ArgppBase::installPrebuiltHelp()).
+ *
+ * Like argppbaseimpl.hpp, this header is only needed to build the library.
+ */
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+#include "argpp.hpp"
+
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+#  include <mutex>
+#endif
+
+namespace argpp {
+  namespace impl {
+
+    class HelpStream;
+
+    ///
+    /// @brief The key of the hidden options behind "--help=PATTERN" and "--help-group=N"
+    /// (see ArgppBaseImpl::helpSearch()), in the group of the parser at the top of the
+    /// parse. argp passes on only the low 24 bits of the keys of long options.
+    ///
+    const int HELP_SEARCH_KEY = -0x4853;
+
+    ///
+    /// @brief What "--help=PATTERN" or "--help-group=N" asks for.
+    ///
+    struct HelpSearch {
+        ///
+        /// @brief The PATTERN of --help=PATTERN, or NULL for --help-group=N.
+        ///
+        const char *pattern_;
+        int         group_;
+    };
+
+    ///
+    /// @class HelpLayout
+    /// @brief The options of a tree of argp structs in the order in which the help
+    /// lists them; corresponds to the sorted "struct hol" of argp-help.c.
+    /// @details Building the layout is the expensive part of formatting the help
+    /// (argp merges the options of each child into those of its parent, which takes
+    /// quadratic time, and sorts them), so a layout is built once and used for as
+    /// long as the tree does not change. isFor() checks that the argp structs of the
+    /// tree are still the same ones; the owner of the layout must clear() it when the
+    /// structs may have been changed in place (see ArgppBaseImpl::treeChanged()).
+    ///
+    /// The texts returned by text() are kept with the layout and forgotten with it.
+    ///
+    class HelpLayout
+    {
+      public:
+        HelpLayout();
+        ///
+        /// @brief Lays out the options of the tree whose root is \c root, unless
+        /// that has already been done.
+        ///
+        void build(const argp *root);
+        ///
+        /// @brief Returns true if the layout was built for the tree whose root is \c root.
+        /// @details The root itself may be a different struct with the same options
+        /// and children, as argp_parse() and the native engine put a new one on top
+        /// of the tree for each parse.
+        ///
+        bool isFor(const argp *root) const;
+        ///
+        /// @brief Forgets the layout.
+        ///
+        void clear();
+        ///
+        /// @brief Forgets the texts formatted by text(), but keeps the layout.
+        /// @details Unlike clear(), this may be called while a help text is being
+        /// formatted, e.g. by a help filter.
+        ///
+        void clearTexts();
+        ///
+        /// @brief Formats the help for \c root as \b argp_state_help() would.
+        /// @param root  : The root of the tree the layout was built for.
+        /// @param state : The state of the parse, or NULL as with \b argp_help().
+        /// @param flags : The ARGP_HELP_* flags.
+        /// @param name  : The program name printed in the usage text.
+        /// @param out   : The text is appended to this string.
+        ///
+        void render(const argp *root, const argp_state *state, unsigned flags
+                    , const char *name, std::string &out) const;
+        ///
+        /// @brief Same as render(), except that the text is only formatted the first
+        /// time it is asked for with the same flags and program name.
+        /// @details The texts of the filters of the parsers are cached in the same way
+        /// (see ArgppBase::clearHelpFilterCache()). May be called on several threads at
+        /// once.
+        /// @return The text, which stays valid until clear() is called.
+        ///
+        const std::string &text(const argp *root, const argp_state *state, unsigned flags
+                                , const char *name) const;
+        ///
+        /// @brief Calls the help filter of \c ap with \c text.
+        /// @details The filter of the parsers (ArgppBaseImpl::helpFilter()) is bypassed:
+        /// the text it would copy is taken from the cache of the parser instead, so
+        /// that nothing is allocated. Pass the result to releaseText() when done.
+        ///
+        static const char *filterText(const argp *ap, int key, const char *text, void *input);
+        ///
+        /// @brief Frees \c filtered, as returned by filterText(), if it was allocated.
+        ///
+        static void releaseText(const argp *ap, const char *filtered, const char *text);
+        ///
+        /// @brief Returns the input which the help filter of \c ap gets; see
+        /// ArgppBaseImpl::argpInput().
+        ///
+        static void *argpInput(const argp *ap, const argp_state *state);
+        ///
+        /// @brief Formats the entries which match \c search as render() would format
+        /// them in the long help, with the headers of the children they belong to.
+        /// @details The entries are looked up in an index of the words of their long
+        /// names and documentation strings and of their groups, which is built the first
+        /// time it is needed. Looking them up takes logarithmic time, so the time it
+        /// takes is proportional to the output rather than to the number of options.
+        /// @return False if no entry matched; nothing is appended then.
+        ///
+        bool renderMatches(const argp *root, const argp_state *state, const HelpSearch &search
+                           , std::string &out) const;
+        ///
+        /// @brief Computes the fingerprint which a table of ArgppBase::installPrebuiltHelp()
+        /// must have for the tree whose root is \c root.
+        /// @details The fingerprint is kept until clear() is called or the tree is a
+        /// different one; the layout need not have been built.
+        /// @return False if the texts of the tree can't be prebuilt, since a parser
+        /// of the tree has a help filter.
+        ///
+        bool fingerprint(const argp *root, const argp_state *state
+                         , unsigned long long &value) const;
+
+      private:
+        ///
+        /// @brief Corresponds to "struct hol_cluster": the options of a child which
+        /// has a group or a header.
+        ///
+        struct Cluster {
+            const char *header_;
+            ///
+            /// @brief The position of the child in its parent's array of children.
+            ///
+            int         index_;
+            int         group_;
+            ///
+            /// @brief Index into clusters_, or -1.
+            ///
+            int         parent_;
+            ///
+            /// @brief The argp struct of the parent, NULL for the root.
+            ///
+            const argp *argp_;
+            int         depth_;
+        };
+        ///
+        /// @brief Corresponds to "struct hol_entry": an option and its aliases.
+        ///
+        struct Entry {
+            const argp_option *opt_;
+            unsigned           num_;
+            ///
+            /// @brief Offset into short_options_ of the short options of the entry
+            /// which are not shadowed by those of an earlier entry.
+            ///
+            size_t             so_;
+            int                group_;
+            ///
+            /// @brief Index into clusters_, or -1.
+            ///
+            int                cluster_;
+            ///
+            /// @brief The argp struct the option belongs to, NULL for the root.
+            ///
+            const argp        *argp_;
+        };
+        ///
+        /// @brief What the output of render() depends on apart from the layout.
+        ///
+        struct TextKey {
+            unsigned    flags_;
+            ///
+            /// @brief False if the help filters can't be called (see filterText()).
+            ///
+            bool        has_inputs_;
+            std::string name_;
+            std::string bug_address_;
+            ///
+            /// @brief The value of ARGP_HELP_FMT, which is read when the text is formatted.
+            ///
+            std::string help_fmt_;
+            ///
+            /// @brief What the translations depend on: the LC_MESSAGES locale, $LANGUAGE
+            /// and the default gettext domain.
+            ///
+            std::string messages_;
+
+            bool operator<(const TextKey &other) const;
+        };
+        typedef std::map<TextKey, std::string> TextCache;
+        ///
+        /// @brief A word of the long name or of the documentation string of an
+        /// entry, in lower case, and the index of the entry in entries_.
+        ///
+        typedef std::pair<std::string, size_t> WordIndex;
+        ///
+        /// @brief The group of an entry, and its index in entries_.
+        ///
+        typedef std::pair<int, size_t>         GroupIndex;
+        struct HelpState;
+        struct EntryState;
+
+        void addArgp(const argp *ap, const argp *root, int cluster, bool *seen);
+        static bool keyMatches(const argp *ap, const std::vector<const void*> &key
+                               , size_t &pos);
+        static void addKey(const argp *ap, std::vector<const void*> &key);
+        void setGroup(const char *name, int group);
+        void sort(size_t first, size_t n, std::vector<Entry> &tmp);
+        int  compare(const Entry &e1, const Entry &e2) const;
+        int  compareClusters(int cl1, int cl2) const;
+        int  compareCousins(int cl1, int cl2) const;
+        int  baseCluster(int cl) const;
+        bool isChildCluster(int cl1, int cl2) const;
+        char firstShort(const Entry &e) const;
+
+        void usage(const argp *root, HelpStream &fs) const;
+        void help(const argp *root, const argp_state *state
+                  , const std::vector<size_t> *selected, HelpStream &fs) const;
+        void buildIndex() const;
+        void findMatches(const HelpSearch &search, std::vector<size_t> &selected) const;
+        void entryHelp(const Entry &e, const argp *root, const argp_state *state
+                       , HelpStream &fs, HelpState &hhstate) const;
+        void comma(unsigned col, EntryState &pest) const;
+        void header(const char *str, const argp *ap, EntryState &pest) const;
+
+        ///
+        /// @brief What isFor() compares: the options and children of the root and
+        /// the argp structs of the other nodes, in pre-order.
+        ///
+        std::vector<const void*> key_;
+        std::vector<Entry>       entries_;
+        std::vector<Cluster>     clusters_;
+        std::string              short_options_;
+        bool                     built_;
+        ///
+        /// @brief See text().
+        ///
+        mutable TextCache        texts_;
+        ///
+        /// @brief See renderMatches(); both are sorted, and empty until
+        /// the first search.
+        ///
+        mutable std::vector<WordIndex>  words_;
+        mutable std::vector<GroupIndex> groups_;
+        mutable bool                    indexed_;
+        ///
+        /// @brief See fingerprint(): the key of the tree it was computed for, as in
+        /// key_, the bug address it includes, the fingerprint and whether it is
+        /// valid (1), the tree has a help filter (0) or it is unknown (-1).
+        ///
+        mutable std::vector<const void*> fp_key_;
+        mutable std::string              fp_bug_address_;
+        mutable unsigned long long       fp_;
+        mutable int                      fp_status_;
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+        ///
+        /// @brief Guards texts_, the index and the fingerprint.
+        ///
+        mutable std::mutex       cache_mutex_;
+#endif
+
+        HelpLayout(const HelpLayout &);
+        HelpLayout& operator=(const HelpLayout &);
+    };
+
+    ///
+    /// @brief Same as \b argp_state_help(), except that the text is formatted by a
+    /// HelpLayout and that exit() is never called; the caller does that.
+    /// @details The layout of ArgppPlan::parse() is that of the plan; otherwise it is
+    /// the one kept in the ParseContext of the calling thread.
+    ///
+    void renderHelp(const argp_state *state, FILE *stream, unsigned flags);
+    ///
+    /// @brief Appends the text renderHelp() would write to \c out.
+    /// @details Unlike renderHelp(), the text is formatted even if the flags of the
+    /// parse include ARGP_NO_ERRS.
+    ///
+    void formatHelp(const argp_state *state, unsigned flags, std::string &out);
+    ///
+    /// @brief Returns true if \c arg is "--help=PATTERN", "--help-group=N" or
+    /// "--help-group" (with N in the next argument).
+    /// @details Only the full names are recognized; this is for looking at a command
+    /// line before the options of the tree are known.
+    ///
+    bool isHelpSearch(const char *arg);
+    ///
+    /// @brief Fills in \c search for \c arg as the argument of --help-group if \c group
+    /// is true, or else of --help; returns false if the group is not a number.
+    ///
+    bool makeHelpSearch(const char *arg, bool group, HelpSearch &search);
+    ///
+    /// @brief Prints the entries which match \c search (see HelpLayout::renderMatches())
+    /// to \c stream, unless the flags of the parse include ARGP_NO_ERRS.
+    /// @return false if there are none, which the caller reports as an error.
+    ///
+    bool renderHelpSearch(const argp_state *state, FILE *stream, const HelpSearch &search);
+    ///
+    /// @brief See ArgppBase::installPrebuiltHelp().
+    ///
+    void installPrebuiltHelp(const ArgppPrebuiltHelp *help, size_t n);
+    ///
+    /// @brief Writes the table of ArgppBase::writePrebuiltHelp() for the tree whose root
+    /// is \c root, which must be the root a parse sees (see NativeTable::rootArgp()).
+    ///
+    bool writePrebuiltHelp(FILE *out, const char *identifier, const argp *root
+                           , const char *name);
+
+  } // namespace impl
+} // namespace argpp
+
+
+#endif // ARGPPHELP_H
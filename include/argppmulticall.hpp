@@ -0,0 +1,92 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+
+#ifndef ARGPPMULTICALL_H
+#define ARGPPMULTICALL_H
+
+/**
+ * @file argppmulticall.hpp
+ * @brief Contains the implementation of argpp::ArgppMultiCall.
+ * @details Like argppbaseimpl.hpp, this header is only needed to build the library.
+ */
+
+#include <vector>
+#include "argpp.hpp"
+#include "argpparena.hpp"
+
+namespace argpp {
+  namespace impl {
+
+    ///
+    /// @class ArgppMultiCallImpl
+    /// @brief Encapsulates the implementation details and data members of ArgppMultiCall.
+    ///
+    class ArgppMultiCallImpl
+    {
+      public:
+        ArgppMultiCallImpl();
+        ///
+        /// @brief Adds the applets of a table, which need not be sorted.
+        ///
+        void addTable(const ArgppApplet *applets, size_t count);
+        ///
+        /// @brief See documentation for ArgppMultiCall::addApplet().
+        ///
+        bool addApplet(const std::string &name, AppletFactory factory, const std::string &doc);
+        ///
+        /// @brief See documentation for ArgppMultiCall::findApplet().
+        ///
+        const ArgppApplet *findApplet(const char *name) const;
+        ///
+        /// @brief See documentation for ArgppMultiCall::createParser().
+        ///
+        ArgppBase *createParser(int argc, char **argv) const;
+
+        ///
+        /// @brief The applets, sorted by name without duplicates.
+        ///
+        std::vector<ArgppApplet> applets_;
+
+      private:
+        ///
+        /// @brief Returns the name of the applet which \c argv0 calls: its base name,
+        /// on Windows without the ".exe" which it may or may not have. \c buf holds
+        /// the name if it had to be changed.
+        ///
+        static const char *appletName(const char *argv0, std::string &buf);
+        const char *copyString(const std::string &s);
+
+        ///
+        /// @brief Holds the strings of the applets added by addApplet().
+        ///
+        ParseArena strings_;
+
+        ArgppMultiCallImpl(const ArgppMultiCallImpl &);
+        ArgppMultiCallImpl& operator=(const ArgppMultiCallImpl &);
+    };
+
+  } // namespace impl
+} // namespace argpp
+
+
+#endif // ARGPPMULTICALL_H
@@ -0,0 +1,500 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+
+#ifndef ARGPPNATIVE_H
+#define ARGPPNATIVE_H
+
+/**
+ * @file argppnative.hpp
+ * @brief Contains the declarations of the native parsing engine.
+ * @details The native engine is an alternative to \b argp_parse() which works
+ * directly on the tree of ArgppBase objects. It reproduces the behavior of
+ * \b argp_parse() and the \b getopt_long() functions it is built on, i.e. the
+ * same sequence of ARGP_KEY_* calls, the same permutation of \b argv, the same
+ * abbreviation rules for long options and the same error messages, so that
+ * clients cannot tell which engine was used. See ArgppBase::setParseEngine().
+ *
+ * Like argppbaseimpl.hpp, this header is only needed to build the library.
+ */
+
+#include "argppbaseimpl.hpp"
+#include "argpparena.hpp"
+
+namespace argpp {
+  namespace impl {
+
+    ///
+    /// @struct NativeGroup
+    /// @brief Corresponds to the "group" struct in the \b argp sources: one for each
+    /// parser in the tree, plus the ones for the default options (--help, --usage, ...)
+    /// and for --version.
+    ///
+    struct NativeGroup {
+        ///
+        /// @brief The argp struct which \b argp_state_help() will see for this group.
+        ///
+        const argp   *argp_;
+        ///
+        /// @brief The parser function; ArgppBaseImpl::parserRouter() for our own parsers.
+        ///
+        argp_parser_t parser_;
+        ///
+        /// @brief Index of the parent group, or -1 for the top-level groups.
+        ///
+        int           parent_;
+        ///
+        /// @brief Index into the parent's child_inputs vector.
+        ///
+        unsigned      parent_index_;
+        ///
+        /// @brief Offset of this group's child_inputs in the vector of all child_inputs.
+        ///
+        size_t        child_inputs_begin_;
+        ///
+        /// @brief The number of children, i.e. the size of this group's child_inputs.
+        ///
+        size_t        num_children_;
+        ///
+        /// @brief The keys of argpp::argpp_lifecycle_key which the parser is passed; see
+        /// ArgppBase::setLifecycleKeys(). None for the default options and --version.
+        ///
+        unsigned      lifecycle_keys_;
+    };
+
+    ///
+    /// @struct NativeLongOption
+    /// @brief Corresponds to an entry in the array of \b struct \b option passed to
+    /// \b getopt_long().
+    ///
+    struct NativeLongOption {
+        const char *name_;
+        size_t      len_;
+        ///
+        /// @brief 0, 1 or 2 (no_argument, required_argument or optional_argument).
+        ///
+        int         has_arg_;
+        ///
+        /// @brief The key passed to the parser function.
+        ///
+        int         key_;
+        ///
+        /// @brief The index of the group which receives this option.
+        ///
+        size_t      group_;
+    };
+
+    typedef std::vector<NativeGroup,      ArenaAllocator<NativeGroup> >      NativeGroups;
+    typedef std::vector<NativeLongOption, ArenaAllocator<NativeLongOption> > NativeLongOptions;
+
+    ///
+    /// @class PrefixIndex
+    /// @brief A sorted array of long option names for resolving exact matches and
+    /// abbreviations by binary search.
+    /// @details All names beginning with a given prefix form a contiguous range of
+    /// the sorted array, so both kinds of lookup take O(length of the prefix * log n)
+    /// instead of comparing the prefix with every name. The names are not copied and
+    /// must outlive the index.
+    ///
+    /// If a name is added more than once, only the entry with the smallest value is
+    /// kept, so that the first of several options with the same name wins if the
+    /// values are indexes into an option array.
+    ///
+    class PrefixIndex
+    {
+      public:
+        struct Entry {
+            const char *name_;
+            size_t      len_;
+            ///
+            /// @brief The value passed to add(), usually an index into an option array.
+            ///
+            size_t      value_;
+        };
+        typedef std::pair<const Entry*, const Entry*> Range;
+
+        ///
+        /// @brief The entries are allocated from \c arena, or from the heap if it is NULL.
+        ///
+        explicit PrefixIndex(ParseArena *arena = NULL);
+        ///
+        /// @brief Adds a name; build() must be called before the next lookup.
+        ///
+        void  add(const char *name, size_t value);
+        ///
+        /// @brief Sorts the names and drops the duplicates.
+        ///
+        void  build();
+        ///
+        /// @brief Returns the entries whose names begin with the first \c len characters
+        /// of \c prefix, in sorted order; an exact match, if there is one, comes first.
+        ///
+        Range matches(const char *prefix, size_t len) const;
+        ///
+        /// @brief Resolves \c prefix to an exact match or an unambiguous abbreviation.
+        /// @return The value of the matching entry, or -1 if there is none. If there are
+        /// several candidates, -1 is returned and \c *ambiguous is set to true; matches()
+        /// returns the list of candidates.
+        ///
+        int   find(const char *prefix, size_t len, bool *ambiguous = NULL) const;
+
+      private:
+        std::vector<Entry, ArenaAllocator<Entry> > entries_;
+    };
+
+    ///
+    /// @class NativeTable
+    /// @brief The option tables built from a tree of parsers.
+    /// @details This is what \b argp_parse() computes in its parser_init() function,
+    /// i.e. the groups in pre-order, the string of short options and the array of
+    /// long options, except that short options are looked up in a table indexed
+    /// by the character instead of calling strchr().
+    ///
+    class NativeTable
+    {
+      public:
+        ///
+        /// @brief Builds the tables for the tree of argp structs whose root is \c root.
+        /// @param root  : The argp struct which would be passed to \b argp_parse(), e.g.
+        /// the main_argp_ of the root instance after ArgppBaseImpl::prepareParserVecs(),
+        /// or the root of an ArgppPlanImpl.
+        /// @param flags : The flags which would be passed to \b argp_parse().
+        /// @param arena : Where the tables are allocated; see ParseContext::scratch().
+        /// NULL means the heap, for tables which outlive the parse.
+        /// @param owner : The parser whose main_argp_ is \c root, if any. The lifecycle keys
+        /// of the groups are read from it and from its children; otherwise each group gets
+        /// all of them, and the caller may fill in NativeGroup::lifecycle_keys_ itself.
+        ///
+        NativeTable(const argp *root, unsigned flags, ParseArena *arena, ArgppBase *owner = NULL);
+        ///
+        /// @brief Returns the argp struct to store in argp_state::root_argp.
+        ///
+        const argp *rootArgp() const { return root_argp_; }
+        ///
+        /// @brief Returns the index of the group owning the short option \c c,
+        /// or -1 if \c c is not a short option.
+        ///
+        int shortGroup(unsigned char c) const { return short_group_[c]; }
+        ///
+        /// @brief Returns 0, 1 or 2 (see NativeLongOption::has_arg_) for a
+        /// valid short option.
+        ///
+        int shortHasArg(unsigned char c) const { return short_has_arg_[c]; }
+        ///
+        /// @brief Returns the index of the names in long_options_; the value of each entry
+        /// is the index of the option in long_options_.
+        ///
+        const PrefixIndex &prefixIndex() const { return prefix_index_; }
+        ///
+        /// @brief Resolves the first \c len characters of \c name to a long option as
+        /// \b getopt_long() does: an exact match wins, otherwise the first abbreviation
+        /// in the order of the options, unless another one would do something else.
+        /// @return The index of the option in long_options_, or -1. If the name is
+        /// ambiguous, the indexes of the candidates are added to \c *ambiguous.
+        ///
+        int findLongOption(const char *name, size_t len, std::vector<size_t> *ambiguous) const;
+        ///
+        /// @brief Returns true if the group at index \c g holds argp's default options or
+        /// --version rather than those of a parser of the tree.
+        ///
+        bool isDefaultGroup(size_t g) const;
+
+        NativeGroups      groups_;
+        NativeLongOptions long_options_;
+        unsigned          flags_;
+
+      private:
+        void addParser(const argp *ap, ArgppBase *owner
+                       , int parent, unsigned parent_index, size_t &num_inputs);
+        void addGroup(const argp *ap, ArgppBase *owner
+                      , int parent, unsigned parent_index, size_t num_children
+                      , size_t &num_inputs);
+
+        ///
+        /// @brief The long names in long_options_. Since getopt_long() finds the first
+        /// of several options with the same name, the index only contains that one.
+        ///
+        PrefixIndex  prefix_index_;
+        const argp  *root_argp_;
+        argp         top_argp_;
+        argp_child   top_children_[4];
+        int          short_group_[256];
+        signed char  short_has_arg_[256];
+
+        NativeTable(const NativeTable &);
+        NativeTable& operator=(const NativeTable &);
+    };
+
+    ///
+    /// @struct NativeToken
+    /// @brief One item returned by NativeLexer::next().
+    ///
+    struct NativeToken {
+        enum kind_type {
+          tk_option,      //!< an option for the group group_ with key key_
+          tk_arg,         //!< a non-option argument (only in ARGP_IN_ORDER mode)
+          tk_end,         //!< no more options
+          tk_error        //!< unknown or ambiguous option, or a missing or unexpected argument
+        };
+        kind_type kind_;
+        size_t    group_;
+        ///
+        /// @brief The key for tk_option; the offending character for errors concerning
+        /// short options, otherwise 0.
+        ///
+        int       key_;
+        char     *arg_;
+        ///
+        /// @brief Index into NativeTable::long_options_, or -1 for short options.
+        ///
+        int       long_index_;
+    };
+
+    ///
+    /// @class NativeLexer
+    /// @brief Walks through argv as \b getopt_long() does.
+    /// @details This is a faithful implementation of the GNU \b getopt_long() and
+    /// \b getopt_long_only() functions including the permutation of \b argv, but
+    /// it returns tokens referring to the option tables in NativeTable instead of
+    /// option characters.
+    ///
+    class NativeLexer
+    {
+      public:
+        ///
+        /// @brief Error messages are printed to \c err_stream; if it is NULL, none are printed.
+        /// @details With \c in_order, the options and the non-option arguments are
+        /// returned in the order of \c argv, as with ARGP_IN_ORDER, whatever the flags
+        /// of \c table are, and \c argv is never permuted.
+        ///
+        NativeLexer(const NativeTable &table, int argc, char **argv, FILE *err_stream
+                    , bool in_order = false);
+        ///
+        /// @brief Returns the next token; optind_ is updated as in \b getopt().
+        ///
+        void next(NativeToken &tok);
+
+        int   optind_;
+
+      private:
+        enum ordering_type { REQUIRE_ORDER, PERMUTE, RETURN_IN_ORDER };
+
+        void exchange();
+        bool isNonOption(int idx) const;
+        bool isShortOption(char c) const;
+        bool longOption(const char *prefix, NativeToken &tok);
+
+        const NativeTable &table_;
+        int            argc_;
+        char         **argv_;
+        FILE          *err_stream_;
+        bool           in_order_;
+        bool           initialized_;
+        ordering_type  ordering_;
+        char          *nextchar_;
+        int            first_nonopt_;
+        int            last_nonopt_;
+    };
+
+    ///
+    /// @struct NativeGroupState
+    /// @brief What NativeParser keeps for each group of NativeTable during a parse, as
+    /// \b argp_parse() does in its own "struct group".
+    ///
+    struct NativeGroupState {
+        void      *input_;
+        void     **child_inputs_;
+        void      *hook_;
+        unsigned   args_processed_;
+    };
+
+#ifdef ARGPP_HAVE_GLIBC_ARGP_LAYOUT
+    //------------------------------------------------------------------
+    // argp's helper functions such as argp_state_help() look up the input
+    // of each argp struct, which they pass to its help filter, in the
+    // groups which argp_state::pstate points to; they take pstate for the
+    // "struct parser" of argp-parse.c. So that a parser function may call
+    // them under the native engine, NativeParser fills in a copy of that
+    // struct, as far as they read it. The layout is private to glibc; the
+    // configure script only defines ARGPP_HAVE_GLIBC_ARGP_LAYOUT after it
+    // has checked that argp_parse() fills in these structs the same way.
+    //------------------------------------------------------------------
+
+    ///
+    /// @struct ArgpGetoptDataMirror
+    /// @brief Has the same layout as "struct _getopt_data" of getopt_int.h, which is part of
+    /// argp's parser struct (see ArgpParserMirror). It is never filled in.
+    ///
+    struct ArgpGetoptDataMirror {
+        int   optind;
+        int   opterr;
+        int   optopt;
+        char *optarg;
+        int   initialized;
+        char *nextchar;
+        int   ordering;
+#if defined(__GLIBC__) && (__GLIBC__ == 2) && (__GLIBC_MINOR__ < 26)
+        int   posixly_correct;
+#endif
+        int   first_nonopt;
+        int   last_nonopt;
+    };
+
+    ///
+    /// @struct ArgpGroupMirror
+    /// @brief Has the same layout as the private "struct group" of argp-parse.c.
+    /// @details NativeParser only fills in the argp struct, the parser function and the
+    /// input of each group; the engine itself uses NativeGroupState.
+    ///
+    struct ArgpGroupMirror {
+        argp_parser_t      parser;
+        const struct argp *argp;
+        char              *short_end;
+        unsigned           args_processed;
+        ArgpGroupMirror   *parent;
+        unsigned           parent_index;
+        void              *input;
+        void             **child_inputs;
+        void              *hook;
+    };
+
+    ///
+    /// @struct ArgpParserMirror
+    /// @brief Has the same layout as the private "struct parser" of argp-parse.c up to and
+    /// including the pointers to the groups. See ArgpGroupMirror.
+    ///
+    struct ArgpParserMirror {
+        const struct argp   *argp;
+        char                *short_opts;
+        void                *long_opts;
+        ArgpGetoptDataMirror opt_data;
+        ArgpGroupMirror     *groups;
+        ArgpGroupMirror     *egroup;
+        void               **child_inputs;
+        int                  try_getopt;
+    };
+#else
+    ///
+    /// @brief The size, in pointers, of what argp_state::pstate points to under the
+    /// native engine without ARGPP_HAVE_GLIBC_ARGP_LAYOUT.
+    /// @details It is all zeros, which is larger than argp's parser struct, so that
+    /// argp's helper functions find no groups in it whatever its layout: the help
+    /// filters which they call get NULL for their input, and the help texts of the
+    /// parsers are not filtered.
+    ///
+    const size_t ARGP_PSTATE_ZEROS = 64;
+#endif // ARGPP_HAVE_GLIBC_ARGP_LAYOUT
+
+    ///
+    /// @class NativeParser
+    /// @brief Does what \b argp_parse() does, using NativeLexer instead of \b getopt_long().
+    ///
+    class NativeParser
+    {
+      public:
+        ///
+        /// @brief The per-group state is allocated from \c arena.
+        ///
+        NativeParser(const NativeTable &table, ParseArena *arena);
+        ///
+        /// @brief Parses the command line.
+        /// @details The arguments and the return value are the same as for \b argp_parse().
+        /// If one of the default options such as --help asks for the program to exit,
+        /// ParseContext::argpp_should_exit_ is set and parse() returns immediately
+        /// without calling any more parser functions; the caller calls exit() then.
+        ///
+        error_t parse(int argc, char **argv, int *end_index, void *input);
+
+      private:
+        bool    wants(size_t group, int key) const;
+        error_t groupParse(size_t group, int key, char *arg);
+        error_t parseNext(NativeLexer &lexer, bool &arg_ebadkey);
+        error_t parseArg(char *val);
+        error_t parseOpt(const NativeToken &tok);
+        error_t finalize(error_t err, bool arg_ebadkey, int *end_index);
+        bool    shouldExit() const;
+
+        const NativeTable                                              &table_;
+        argp_state                                                      state_;
+        std::vector<NativeGroupState, ArenaAllocator<NativeGroupState> > groups_;
+        std::vector<void*, ArenaAllocator<void*> >                       child_inputs_;
+#ifdef ARGPP_HAVE_GLIBC_ARGP_LAYOUT
+        ArgpParserMirror                                                 pstate_;
+        std::vector<ArgpGroupMirror, ArenaAllocator<ArgpGroupMirror> >   argp_groups_;
+#else
+        void                                                            *pstate_[ARGP_PSTATE_ZEROS];
+#endif
+        bool                                                             try_getopt_;
+
+        NativeParser(const NativeParser &);
+        NativeParser& operator=(const NativeParser &);
+    };
+
+    ///
+    /// @brief Runs the native engine on the tree of argp structs whose root is \c ap.
+    /// @details The drop-in replacement for \b argp_parse(), with the same arguments.
+    /// All of the engine's memory comes from ParseContext::scratch(), which is released
+    /// before returning. \c input is the parser whose main_argp_ is \c ap; the lifecycle
+    /// keys of its tree are read when the tables are built.
+    ///
+    error_t nativeParse(const argp *ap, int argc, char **argv, unsigned flags, int *end_index, void *input);
+
+    ///
+    /// @brief Runs the native engine with tables which have been built beforehand.
+    /// @details Only the per-parse state is allocated, from ParseContext::scratch() of
+    /// the calling thread; \c table is not modified, so any number of threads can
+    /// use the same table at the same time.
+    ///
+    error_t nativeParse(const NativeTable &table, int argc, char **argv, int *end_index, void *input);
+
+    ///
+    /// @brief Returns true if \c arg is one of the default options which make argp print
+    /// something and exit, i.e. "-?" or "--help", "--usage" and their abbreviations,
+    /// and also "-V" or "--version" if \c with_version is true.
+    /// @details Abbreviations are resolved against all of the default options as argp
+    /// does, but without knowing the options of the program itself, so this only tells
+    /// whether \c arg may be a request for help; see the other overload.
+    ///
+    bool isHelpRequest(const char *arg, bool with_version);
+    ///
+    /// @brief Returns true if \c arg is "-?", "-V", "--help", "--usage" or "--version" or an
+    /// abbreviation of one of them once it has been resolved against all the options of
+    /// \c table, as getopt_long() would resolve it.
+    /// @details Unlike isHelpRequest(const char*, bool), an abbreviation which is ambiguous
+    /// because of an option of the program, such as "--v" with --verbose and --version,
+    /// or a short option which the program has taken for itself, is not a request for help.
+    /// So are "--help=PATTERN" and "--help-group=N" if they resolve to the hidden options
+    /// of the first group (see HELP_SEARCH_KEY).
+    ///
+    bool isHelpRequest(const char *arg, const NativeTable &table);
+    ///
+    /// @brief Returns true if getopt_long() would take \c argv[idx] as the argument of
+    /// the option in the element before it, e.g. "--help" in "-o --help" if -o takes an
+    /// argument, once the options have been resolved against \c table.
+    ///
+    bool isOptionArgument(const NativeTable &table, char **argv, int idx);
+
+  } // namespace impl
+} // namespace argpp
+
+
+#endif // ARGPPNATIVE_H
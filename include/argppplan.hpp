@@ -0,0 +1,225 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+
+
+#ifndef ARGPPPLAN_H
+#define ARGPPPLAN_H
+
+/**
+ * @file argppplan.hpp
+ * @brief Contains the implementation of argpp::ArgppPlan.
+ * @details Like argppbaseimpl.hpp, this header is only needed to build the library.
+ */
+
+#include "argppbaseimpl.hpp"
+#include "argppnative.hpp"
+
+namespace argpp {
+  namespace impl {
+
+    struct BatchLineState;
+    class BatchChunkQueue;
+
+    ///
+    /// @class ArgppPlanImpl
+    /// @brief Encapsulates the implementation details and data members of ArgppPlan.
+    /// @details Holds a copy of the argp structs which ArgppBaseImpl::prepareParserVecs()
+    /// sets up in the tree of parsers, with all of the strings they point to, so that
+    /// the plan does not depend on anything in the tree except for the parser objects
+    /// which are called back.
+    ///
+    class ArgppPlanImpl
+    {
+      public:
+        ///
+        /// @brief Compiles the tree whose root is \c root with the flags and the engine
+        /// which the ParseContext of the calling thread has.
+        ///
+        explicit ArgppPlanImpl(ArgppBase *root);
+        ~ArgppPlanImpl();
+        ///
+        /// @brief See documentation for ArgppPlan::parse().
+        /// @param err_stream : if not NULL, \b argp prints its error messages there.
+        ///
+        bool parse(int argc, char **argv, ArgppParseResult &result
+                   , FILE *err_stream = NULL) const;
+        ///
+        /// @brief See documentation for ArgppPlan::parseBatch().
+        ///
+        size_t parseBatch(const ArgppCommandLines &lines, ArgppBatchSink &sink) const;
+        ///
+        /// @brief See documentation for ArgppPlan::parseFile().
+        ///
+        bool parseFile(FILE *in, ArgppBatchSink &sink, unsigned threads) const;
+        ///
+        /// @brief Fills in \c child_inputs for the parser \c p as
+        /// ArgppBaseImpl::parserRouter() does with child_inputs_ otherwise.
+        ///
+        void setChildInputs(const ArgppBase *p, void **child_inputs) const;
+        ///
+        /// @brief Returns the tables of the native engine for the plan; they are
+        /// built whichever engine parse() uses.
+        ///
+        const NativeTable &table() const { return *table_; }
+        ///
+        /// @brief Returns the parser which owns the options of the group \c group
+        /// of table(), or NULL for the groups of the default options.
+        ///
+        ArgppBase *groupParser(size_t group) const { return group_parsers_[group]; }
+        ///
+        /// @brief Returns the parser which owns \c ap, one of the argp structs of the
+        /// plan, or NULL if there is none.
+        ///
+        ArgppBase *argpParser(const argp *ap) const;
+        ///
+        /// @brief Returns the sorted options of table() for the help.
+        /// @details The layout is built the first time it is asked for, which most
+        /// plans never are; with threads, std::call_once() builds it for all of
+        /// the threads sharing the plan, which only read it afterwards.
+        ///
+        const HelpLayout &helpLayout() const;
+
+      private:
+        ///
+        /// @brief The copy of the argp structs of one parser.
+        ///
+        struct PlanNode {
+            ArgppBase           *holder_;
+            argp                 argp_;
+            Argp_Option_Vec      options_;
+            Argp_Child_Vec       children_;
+            ///
+            /// @brief The indexes into nodes_ of the children.
+            ///
+            std::vector<size_t>  child_nodes_;
+            ///
+            /// @brief The parser objects of the children, in the same order.
+            ///
+            std::vector<void*>   child_inputs_;
+        };
+
+#ifdef ARGPP_HAVE_UNORDERED_MAP
+        typedef std::unordered_map<const ArgppBase*, size_t> PlanNodeIndex;
+#else
+        typedef std::map<const ArgppBase*, size_t>           PlanNodeIndex;
+#endif
+
+        void        addNode(ArgppBase *p);
+        const char *copyString(const char *s);
+        ///
+        /// @brief Fills in the result of a line of a batch which could not be parsed at all.
+        ///
+        static void setBadLine(ArgppParseResult &result, const char *msg);
+        ///
+        /// @brief Parses one line of a file; lines without any words are skipped.
+        /// @return Returns what \c sink returned, or true for a skipped line.
+        ///
+        bool parseLine(BatchLineState &st, const char *begin, const char *end
+                       , size_t line_no, ArgppBatchSink &sink) const;
+        ///
+        /// @brief Parses the chunks in \c queue until it is closed; each of the
+        /// threads of parseFileParallel() runs this.
+        ///
+        void parseChunks(BatchChunkQueue &queue) const;
+        ///
+        /// @brief Implements parseFile() for more than one thread.
+        ///
+        bool parseFileParallel(FILE *in, ArgppBatchSink &sink, unsigned threads) const;
+
+        ///
+        /// @brief One node for each parser, in pre-order; nodes_[0] is the root.
+        /// @details Nothing is added after the constructor has linked the nodes,
+        /// so the pointers into the vector stay valid.
+        ///
+        std::vector<PlanNode> nodes_;
+        ///
+        /// @brief Maps the parser objects to their nodes.
+        ///
+        PlanNodeIndex         index_;
+        ///
+        /// @brief Holds the copies of the strings.
+        ///
+        ParseArena            strings_;
+        unsigned              flags_;
+        ///
+        /// @brief The tables of the native engine, which ArgppEventReader uses as well.
+        ///
+        NativeTable          *table_;
+        ///
+        /// @brief True if parse() uses the native engine.
+        ///
+        bool                  native_;
+        ///
+        /// @brief The parser of each group of table_; see groupParser().
+        ///
+        std::vector<ArgppBase*> group_parsers_;
+        ///
+        /// @brief See helpLayout().
+        ///
+        mutable HelpLayout      help_layout_;
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+        mutable std::once_flag  help_once_;
+#endif
+
+        ArgppPlanImpl(const ArgppPlanImpl &);
+        ArgppPlanImpl& operator=(const ArgppPlanImpl &);
+    };
+
+    ///
+    /// @class ArgppEventReaderImpl
+    /// @brief Encapsulates the implementation details and data members of ArgppEventReader.
+    ///
+    class ArgppEventReaderImpl
+    {
+      public:
+        ArgppEventReaderImpl(const ArgppPlanImpl &plan, int argc, char **argv);
+        ///
+        /// @brief See documentation for ArgppEventReader::next().
+        ///
+        bool next(ArgppEvent &ev);
+        ///
+        /// @brief See documentation for ArgppEventReader::getIndex().
+        ///
+        int  index() const;
+        int  argc() const { return argc_; }
+
+      private:
+        const ArgppPlanImpl &plan_;
+        NativeLexer          lexer_;
+        int                  argc_;
+        char               **argv_;
+        ///
+        /// @brief The index of the next of the arguments left over once the lexer has
+        /// finished, i.e. the ones after "--"; -1 while the lexer is still running.
+        ///
+        int                  rest_;
+
+        ArgppEventReaderImpl(const ArgppEventReaderImpl &);
+        ArgppEventReaderImpl& operator=(const ArgppEventReaderImpl &);
+    };
+
+  } // namespace impl
+} // namespace argpp
+
+
+#endif // ARGPPPLAN_H
@@ -0,0 +1,128 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+
+#ifndef ARGPPRESPONSE_H
+#define ARGPPRESPONSE_H
+
+/**
+ * @file argppresponse.hpp
+ * @brief Contains the expansion of response files (\c @file arguments).
+ * @details Like argppbaseimpl.hpp, this header is only needed to build the library.
+ */
+
+#include <string>
+#include <vector>
+#include "argpp.hpp"
+
+namespace argpp {
+  namespace impl {
+
+    ///
+    /// @class ResponseFiles
+    /// @brief Replaces the arguments of the form \c @path by the words in the file at \c path.
+    /// @details This follows the rules of GCC and the other GNU tools: the words are split
+    /// as by CommandLineSplitter, words beginning with \c @ are expanded in turn, and an
+    /// argument is left as it is if no file by that name can be opened. A relative path
+    /// is relative to the current directory, not to the file which names it.
+    ///
+    /// Each file is mapped into memory (privately, so the file itself is never changed)
+    /// and split in place, so the new \b argv points into the mappings and no word is
+    /// copied. Where \b mmap() is not available, or the file ends exactly at the end of a
+    /// page so that there is no room for the last NUL character, the file is read into
+    /// a buffer instead.
+    ///
+    class ResponseFiles
+    {
+      public:
+        ResponseFiles();
+        ~ResponseFiles();
+        ///
+        /// @brief Expands the response files in \c argv; argv[0] is never expanded.
+        /// @details If there are none, argv() returns \c argv itself. Anything from an
+        /// earlier call is released first.
+        /// @return Returns \b ARGPP_SUCCESS, or else an \c errno value; see errorPath()
+        /// and errorMessage().
+        ///
+        error_t expand(int argc, char **argv);
+        int    argc() const { return argc_; }
+        char **argv()       { return argv_; }
+        ///
+        /// @brief The file which could not be expanded.
+        ///
+        const std::string &errorPath() const { return error_path_; }
+        ///
+        /// @brief What went wrong with errorPath(), or NULL if \b strerror() says it.
+        ///
+        const char *errorMessage() const { return error_msg_; }
+        ///
+        /// @brief Unmaps the files and frees the buffers; the words are invalid afterwards.
+        ///
+        void release();
+
+      private:
+        ///
+        /// @brief The text of a file, either mapped or read.
+        ///
+        struct Buffer {
+            char  *data_;
+            size_t size_;
+            bool   mapped_;
+        };
+        ///
+        /// @brief Identifies a file while it is being expanded, to detect cycles.
+        ///
+        struct FileId {
+            unsigned long long dev_;
+            unsigned long long ino_;
+            std::string        path_;
+
+            bool operator==(const FileId &other) const {
+              return (ino_ != 0 && dev_ == other.dev_ && ino_ == other.ino_)
+                  || (path_ == other.path_);
+            }
+        };
+
+        error_t expandArg(char *arg);
+        error_t loadFile(const char *path, Buffer &buf);
+        error_t fail(const char *path, error_t e, const char *msg = NULL);
+
+        int                 argc_;
+        char              **argv_;
+        std::vector<char*>  words_;
+        std::vector<Buffer> buffers_;
+        ///
+        /// @brief The files being expanded, outermost first.
+        ///
+        std::vector<FileId> open_;
+        std::string         error_path_;
+        const char         *error_msg_;
+
+        ResponseFiles(const ResponseFiles &);
+        ResponseFiles& operator=(const ResponseFiles &);
+    };
+
+  } // namespace impl
+} // namespace argpp
+
+
+#endif // ARGPPRESPONSE_H
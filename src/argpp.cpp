@@ -21,11 +21,14 @@
    Free Software Foundation, Inc.
 */
 
+#include <algorithm>
+
 //-----------------------------------------------------
-// This header includes argpp.h, so we don't need to
-// include it again:
+// This header includes argppbaseimpl.hpp and argpp.h,
+// so we don't need to include them again:
 //-----------------------------------------------------
-#include "argppbaseimpl.hpp"
+#include "argppplan.hpp"
+#include "argppmulticall.hpp"
 
 namespace argpp {
 
@@ -53,6 +56,16 @@ namespace argpp {
     return impl::ArgppBaseImpl::parse();
   }
   //--------------------------------------------------------------------
+  bool ArgppBase::reparse(int argc, char **argv)
+  {
+    return impl::ArgppBaseImpl::reparse(argc, argv);
+  }
+  //--------------------------------------------------------------------
+  error_t ArgppBase::readNonOptionArgs(int fd, char delim, NonOptionArgFunc func, void *data)
+  {
+    return pimpl_->readNonOptionArgs(fd, delim, func, data);
+  }
+  //--------------------------------------------------------------------
   error_t ArgppBase::getErrorCodeFromArgp()
   {
     return impl::ArgppBaseImpl::getErrorCodeFromArgp();
@@ -68,6 +81,21 @@ namespace argpp {
     return impl::ArgppBaseImpl::setArgpParseFlags(flags);
   }
   //--------------------------------------------------------------------
+  bool ArgppBase::setParseEngine(argpp_parse_engine eng)
+  {
+    return impl::ArgppBaseImpl::setParseEngine(eng);
+  }
+  //--------------------------------------------------------------------
+  argpp_parse_engine ArgppBase::getParseEngine()
+  {
+    return impl::ArgppBaseImpl::getParseEngine();
+  }
+  //--------------------------------------------------------------------
+  void ArgppBase::setScratchBuffer(void *buf, size_t size)
+  {
+    impl::ArgppBaseImpl::setScratchBuffer(buf, size);
+  }
+  //--------------------------------------------------------------------
   bool ArgppBase::isParentValid(ArgppBase *parent)
   {
     return impl::ArgppBaseImpl::isParentValid(parent);
@@ -93,6 +121,16 @@ namespace argpp {
     impl::ArgppBaseImpl::installVersionHook(f);
   }
   //--------------------------------------------------------------------
+  bool ArgppBase::writePrebuiltHelp(FILE *out, const std::string &identifier)
+  {
+    return impl::ArgppBaseImpl::writePrebuiltHelp(out, identifier);
+  }
+  //--------------------------------------------------------------------
+  void ArgppBase::installPrebuiltHelp(const ArgppPrebuiltHelp *help, size_t n)
+  {
+    impl::ArgppBaseImpl::installPrebuiltHelp(help, n);
+  }
+  //--------------------------------------------------------------------
   void ArgppBase::setDomain(const std::string &dom)
   {
     impl::ArgppBaseImpl::setDomain(dom);
@@ -118,6 +156,21 @@ namespace argpp {
     impl::ArgppBaseImpl::argppStateHelp(state, stream, flags);
   }
   //--------------------------------------------------------------------
+  void ArgppBase::argppError(const argp_state *state, const std::string &errmsg, std::string &out)
+  {
+    impl::ArgppBaseImpl::argppError(state, errmsg, out);
+  }
+  //--------------------------------------------------------------------
+  void ArgppBase::argppUsage(const argp_state *state, std::string &out)
+  {
+    impl::ArgppBaseImpl::argppUsage(state, out);
+  }
+  //--------------------------------------------------------------------
+  void ArgppBase::argppStateHelp(const argp_state *state, std::string &out, unsigned flags)
+  {
+    impl::ArgppBaseImpl::argppStateHelp(state, out, flags);
+  }
+  //--------------------------------------------------------------------
   ArgppBase *ArgppBase::getRootInstance()
   {
     return impl::ArgppBaseImpl::getRootInstance();
@@ -162,6 +215,11 @@ namespace argpp {
     pimpl_->installHelpFilter();
   }
   //--------------------------------------------------------------------
+  void ArgppBase::clearHelpFilterCache()
+  {
+    pimpl_->clearHelpFilterCache();
+  }
+  //--------------------------------------------------------------------
   void ArgppBase::addChild(ArgppBase *pChild)
   {
     pimpl_->addChild(pChild);
@@ -200,6 +258,11 @@ namespace argpp {
     return pimpl_->findOption(key, opt);
   }
   //--------------------------------------------------------------------
+  bool ArgppBase::findOption(const std::string &long_name, ArgppOption &opt) const
+  {
+    return pimpl_->findOption(long_name, opt);
+  }
+  //--------------------------------------------------------------------
   unsigned int ArgppBase::childFlags() const
   {
     return pimpl_->childFlags();
@@ -250,6 +313,16 @@ namespace argpp {
     return pimpl_->getNonOptionArgs();
   }
   //--------------------------------------------------------------------
+  const ParsedOptionViews &ArgppBase::getParsedOptionViews() const
+  {
+    return pimpl_->getParsedOptionViews();
+  }
+  //--------------------------------------------------------------------
+  const NonOptionArgViews &ArgppBase::getNonOptionArgViews() const
+  {
+    return pimpl_->getNonOptionArgViews();
+  }
+  //--------------------------------------------------------------------
   ArgppBase *ArgppBase::getParent()
   {
     return pimpl_->getParent();
@@ -300,6 +373,21 @@ namespace argpp {
     pimpl_->addNonOptionArg(arg);
   }
   //--------------------------------------------------------------------
+  void ArgppBase::addParsedOption(const ParsedOptionView &opt)
+  {
+    pimpl_->addParsedOption(opt);
+  }
+  //--------------------------------------------------------------------
+  void ArgppBase::addNonOptionArg(const NonOptionArgView &arg)
+  {
+    pimpl_->addNonOptionArg(arg);
+  }
+  //--------------------------------------------------------------------
+  bool ArgppBase::setLifecycleKeys(unsigned keys)
+  {
+    return pimpl_->setLifecycleKeys(keys);
+  }
+  //--------------------------------------------------------------------
   error_t ArgppBase::genericParserImpl(int key, const char *arg, argp_state *state)
   {
     return pimpl_->genericParserImpl(key, arg, state);
@@ -335,6 +423,23 @@ namespace argpp {
     return pimpl_->isGrandChild(pChild);
   }
   //--------------------------------------------------------------------
+  bool ArgppBase::addSubcommand(const std::string &name
+                                , SubcommandFactory factory
+                                , const std::string &doc)
+  {
+    return pimpl_->addSubcommand(name, factory, doc);
+  }
+  //--------------------------------------------------------------------
+  ArgppBase *ArgppBase::getSubcommand() const
+  {
+    return pimpl_->getSubcommand();
+  }
+  //--------------------------------------------------------------------
+  const std::string &ArgppBase::getSubcommandName() const
+  {
+    return pimpl_->getSubcommandName();
+  }
+  //--------------------------------------------------------------------
   int ArgppBase::supportedOption(int key, const char *arg, std::string *long_name)
   {
     return pimpl_->supportedOption(key, arg, long_name);
@@ -350,5 +455,467 @@ namespace argpp {
     return impl::ArgppBaseImpl::getArgv();
   }
   //--------------------------------------------------------------------
+  int ArgppBase::getParsedArgc()
+  {
+    return impl::ArgppBaseImpl::getParsedArgc();
+  }
+  //--------------------------------------------------------------------
+  char **ArgppBase::getParsedArgv()
+  {
+    return impl::ArgppBaseImpl::getParsedArgv();
+  }
+  //--------------------------------------------------------------------
+  int ArgppBase::getArgvIndexAfterArgpParse()
+  {
+    return impl::ArgppBaseImpl::getArgvIndexAfterArgpParse();
+  }
+  //--------------------------------------------------------------------
+  void ArgppBase::setExpandResponseFiles(bool expand)
+  {
+    impl::ArgppBaseImpl::setExpandResponseFiles(expand);
+  }
+  //--------------------------------------------------------------------
+  bool ArgppBase::expandsResponseFiles()
+  {
+    return impl::ArgppBaseImpl::expandsResponseFiles();
+  }
+  //--------------------------------------------------------------------
+  void ArgppBase::setStopAtFirstNonOption(bool stop)
+  {
+    impl::ArgppBaseImpl::setStopAtFirstNonOption(stop);
+  }
+  //--------------------------------------------------------------------
+  bool ArgppBase::stopsAtFirstNonOption()
+  {
+    return impl::ArgppBaseImpl::stopsAtFirstNonOption();
+  }
+  //--------------------------------------------------------------------
+  int ArgppBase::getRemainingArgc()
+  {
+    return impl::ArgppBaseImpl::getRemainingArgc();
+  }
+  //--------------------------------------------------------------------
+  char **ArgppBase::getRemainingArgv()
+  {
+    return impl::ArgppBaseImpl::getRemainingArgv();
+  }
+  //--------------------------------------------------------------------
+
+  //--------------------------------------------------------------------
+  // ArgppParseResult:
+  //--------------------------------------------------------------------
+  ArgppParseResult::ArgppParseResult()
+    : parsed_          (false)
+    , retval_error_    (ARGPP_SUCCESS)
+    , error_code_      (0)
+    , arg_idx_         (0)
+    , help_called_     (false)
+    , error_msg_       ()
+    , parsed_views_    ()
+    , other_arg_views_ ()
+    , owned_strings_   ()
+    , parsed_options_  ()
+    , other_args_      ()
+  {}
+  //--------------------------------------------------------------------
+  void ArgppParseResult::clear()
+  {
+    parsed_       = false;
+    retval_error_ = ARGPP_SUCCESS;
+    error_code_   = 0;
+    arg_idx_      = 0;
+    help_called_  = false;
+    error_msg_.clear();
+    parsed_views_.clear();
+    other_arg_views_.clear();
+    owned_strings_.clear();
+    parsed_options_.clear();
+    other_args_.clear();
+  }
+  //--------------------------------------------------------------------
+  error_t ArgppParseResult::getRetvalErrorFromArgpParse() const
+  {
+    return parsed_ ? retval_error_ : ARGPP_ENODATA;
+  }
+  //--------------------------------------------------------------------
+  const ParsedOptions &ArgppParseResult::getParsedOptions() const
+  {
+    for (size_t i=parsed_options_.size(); i<parsed_views_.size(); ++i) {
+      const ParsedOptionView &v = parsed_views_[i];
+      parsed_options_.push_back(ParsedOption(v.key_, v.long_name_.str(), v.arg_.str()));
+    }
+    return parsed_options_;
+  }
+  //--------------------------------------------------------------------
+  const OtherArgs &ArgppParseResult::getNonOptionArgs() const
+  {
+    for (size_t i=other_args_.size(); i<other_arg_views_.size(); ++i) {
+      other_args_.push_back(other_arg_views_[i].arg_.str());
+    }
+    return other_args_;
+  }
+  //--------------------------------------------------------------------
+  ArgppStringView ArgppParseResult::ownString(const std::string &s)
+  {
+    if (s.empty()) {
+      return ArgppStringView();
+    }
+    owned_strings_.push_back(s);
+    return ArgppStringView(owned_strings_.back().data(), s.size());
+  }
+
+  //--------------------------------------------------------------------
+  // ArgppBatchSink:
+  //--------------------------------------------------------------------
+  ArgppBatchSink::~ArgppBatchSink()
+  {}
+  //--------------------------------------------------------------------
+  bool ArgppBatchSink::linesParsed(const ArgppBatchResults &lines)
+  {
+    return lines.replay(*this);
+  }
+
+  //--------------------------------------------------------------------
+  // ArgppBatchResults:
+  //--------------------------------------------------------------------
+  // Makes room for n more elements in v. Reserving only what is needed
+  // would copy everything again for each batch which is appended, so
+  // the capacity is at least doubled:
+  //--------------------------------------------------------------------
+  template <typename T>
+  static void reserveMore(std::vector<T> &v, size_t n)
+  {
+    if (v.size() + n > v.capacity()) {
+      v.reserve(std::max(v.size() + n, 2 * v.capacity()));
+    }
+  }
+  //--------------------------------------------------------------------
+  const size_t ArgppBatchResults::NPOS;
+  //--------------------------------------------------------------------
+  ArgppBatchResults::ArgppBatchResults()
+    : lines_      ()
+    , options_    ()
+    , args_       ()
+    , names_      ()
+    , name_index_ ()
+    , pool_       ()
+  {}
+  //--------------------------------------------------------------------
+  bool ArgppBatchResults::lineParsed(size_t line, const ArgppParseResult &result)
+  {
+    const ParsedOptionViews &opts = result.getParsedOptionViews();
+    const NonOptionArgViews &args = result.getNonOptionArgViews();
+
+    Line ln;
+    ln.line_         = line;
+    ln.retval_error_ = result.getRetvalErrorFromArgpParse();
+    ln.error_code_   = result.getErrorCodeFromArgp();
+    ln.argv_index_   = result.getArgvIndexAfterArgpParse();
+    ln.help_entered_ = result.wasHelpEntered();
+    ln.first_option_ = options_.size();
+    ln.num_options_  = opts.size();
+    ln.first_arg_    = args_.size();
+    ln.num_args_     = args.size();
+    ln.error_msg_    = addString(ArgppStringView(result.getErrorMessage().data()
+                                                 , result.getErrorMessage().size()));
+    lines_.push_back(ln);
+
+    for (ParsedOptionViews::const_iterator
+         cit  = opts.begin();
+         cit != opts.end();
+         ++cit) {
+      Option opt;
+      opt.key_        = cit->key_;
+      opt.name_       = addName(cit->long_name_);
+      opt.arg_        = addString(cit->arg_);
+      opt.argv_index_ = cit->argv_index_;
+      options_.push_back(opt);
+    }
+    for (NonOptionArgViews::const_iterator
+         cit  = args.begin();
+         cit != args.end();
+         ++cit) {
+      Arg arg;
+      arg.arg_        = addString(cit->arg_);
+      arg.argv_index_ = cit->argv_index_;
+      args_.push_back(arg);
+    }
+    return true;
+  }
+  //--------------------------------------------------------------------
+  bool ArgppBatchResults::linesParsed(const ArgppBatchResults &lines)
+  {
+    const size_t first_option = options_.size();
+    const size_t first_arg    = args_.size();
+    const size_t first_char   = pool_.size();
+
+    //---------------------------------------------------
+    // The names are numbered in the order in which they
+    // were first seen, so they must be looked up again:
+    //---------------------------------------------------
+    std::vector<size_t> names(lines.names_.size());
+    for (size_t i=0; i<lines.names_.size(); ++i) {
+      names[i] = addName(ArgppStringView(lines.names_[i].data(), lines.names_[i].size()));
+    }
+
+    reserveMore(lines_, lines.lines_.size());
+    for (Lines::const_iterator
+         cit  = lines.lines_.begin();
+         cit != lines.lines_.end();
+         ++cit) {
+      Line ln = *cit;
+      ln.first_option_ += first_option;
+      ln.first_arg_    += first_arg;
+      if (ln.error_msg_.offset_ != NPOS) {
+        ln.error_msg_.offset_ += first_char;
+      }
+      lines_.push_back(ln);
+    }
+    reserveMore(options_, lines.options_.size());
+    for (Options::const_iterator
+         cit  = lines.options_.begin();
+         cit != lines.options_.end();
+         ++cit) {
+      Option opt = *cit;
+      if (opt.name_ != NPOS) {
+        opt.name_ = names[opt.name_];
+      }
+      if (opt.arg_.offset_ != NPOS) {
+        opt.arg_.offset_ += first_char;
+      }
+      options_.push_back(opt);
+    }
+    reserveMore(args_, lines.args_.size());
+    for (Args::const_iterator
+         cit  = lines.args_.begin();
+         cit != lines.args_.end();
+         ++cit) {
+      Arg arg = *cit;
+      if (arg.arg_.offset_ != NPOS) {
+        arg.arg_.offset_ += first_char;
+      }
+      args_.push_back(arg);
+    }
+    pool_.append(lines.pool_);
+    return true;
+  }
+  //--------------------------------------------------------------------
+  bool ArgppBatchResults::replay(ArgppBatchSink &sink) const
+  {
+    ArgppParseResult result;
+    for (Lines::const_iterator
+         cit  = lines_.begin();
+         cit != lines_.end();
+         ++cit) {
+      result.clear();
+      result.parsed_       = true;
+      result.retval_error_ = cit->retval_error_;
+      result.error_code_   = cit->error_code_;
+      result.arg_idx_      = cit->argv_index_;
+      result.help_called_  = cit->help_entered_;
+      result.error_msg_    = getString(cit->error_msg_).str();
+      for (size_t i=0; i<cit->num_options_; ++i) {
+        const Option &opt = options_[cit->first_option_ + i];
+        ArgppStringView name;
+        if (opt.name_ != NPOS) {
+          name = ArgppStringView(names_[opt.name_].data(), names_[opt.name_].size());
+        }
+        result.parsed_views_.push_back(
+              ParsedOptionView(opt.key_, name, getString(opt.arg_), opt.argv_index_));
+      }
+      for (size_t i=0; i<cit->num_args_; ++i) {
+        const Arg &arg = args_[cit->first_arg_ + i];
+        result.other_arg_views_.push_back(NonOptionArgView(getString(arg.arg_), arg.argv_index_));
+      }
+      if (!sink.lineParsed(cit->line_, result)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  //--------------------------------------------------------------------
+  void ArgppBatchResults::clear()
+  {
+    lines_.clear();
+    options_.clear();
+    args_.clear();
+    names_.clear();
+    name_index_.clear();
+    pool_.clear();
+  }
+  //--------------------------------------------------------------------
+  ArgppStringView ArgppBatchResults::getString(const StringRef &ref) const
+  {
+    if (ref.offset_ == NPOS) {
+      return ArgppStringView();
+    }
+    return ArgppStringView(pool_.data() + ref.offset_, ref.size_);
+  }
+  //--------------------------------------------------------------------
+  ArgppBatchResults::StringRef ArgppBatchResults::addString(ArgppStringView s)
+  {
+    StringRef retval;
+    if (s.data_) {
+      retval.offset_ = pool_.size();
+      retval.size_   = s.size_;
+      pool_.append(s.data_, s.size_);
+    }
+    return retval;
+  }
+  //--------------------------------------------------------------------
+  size_t ArgppBatchResults::addName(ArgppStringView s)
+  {
+    if (s.empty()) {
+      return NPOS;
+    }
+    std::string name(s.data_, s.size_);
+    std::map<std::string, size_t>::const_iterator cit = name_index_.find(name);
+    if (cit != name_index_.end()) {
+      return cit->second;
+    }
+    names_.push_back(name);
+    name_index_.insert(std::make_pair(name, names_.size() - 1));
+    return names_.size() - 1;
+  }
+
+  //--------------------------------------------------------------------
+  // ArgppPlan:
+  //--------------------------------------------------------------------
+  ArgppPlan::ArgppPlan(ArgppBase *root)
+    : pimpl_(NULL)
+  {
+    if (!root) {
+      root = ArgppBase::getRootInstance();
+    }
+    if (root) {
+      pimpl_ = new impl::ArgppPlanImpl(root);
+    }
+  }
+  //--------------------------------------------------------------------
+  ArgppPlan::~ArgppPlan()
+  {
+    delete pimpl_;
+  }
+  //--------------------------------------------------------------------
+  bool ArgppPlan::parse(int argc, char **argv, ArgppParseResult &result) const
+  {
+    if (!pimpl_) {
+      result.clear();
+      return false;
+    }
+    return pimpl_->parse(argc, argv, result);
+  }
+  //--------------------------------------------------------------------
+  size_t ArgppPlan::parseBatch(const ArgppCommandLines &lines, ArgppBatchSink &sink) const
+  {
+    return pimpl_ ? pimpl_->parseBatch(lines, sink) : 0;
+  }
+  //--------------------------------------------------------------------
+  bool ArgppPlan::parseFile(FILE *in, ArgppBatchSink &sink, unsigned threads) const
+  {
+    return pimpl_ && in && pimpl_->parseFile(in, sink, threads);
+  }
+  //--------------------------------------------------------------------
+  bool ArgppPlan::parseFile(const std::string &path, ArgppBatchSink &sink, unsigned threads) const
+  {
+    if (!pimpl_) {
+      return false;
+    }
+    FILE *in = fopen(path.c_str(), "r");
+    if (!in) {
+      return false;
+    }
+    bool retval = false;
+    try {
+      retval = pimpl_->parseFile(in, sink, threads);
+    } catch (...) {
+      fclose(in);
+      throw;
+    }
+    fclose(in);
+    return retval;
+  }
+
+  //--------------------------------------------------------------------
+  // ArgppEventReader:
+  //--------------------------------------------------------------------
+  ArgppEventReader::ArgppEventReader(const ArgppPlan &plan, int argc, char **argv)
+    : pimpl_(NULL)
+  {
+    if (plan.pimpl_) {
+      pimpl_ = new impl::ArgppEventReaderImpl(*plan.pimpl_, argc, argv);
+    }
+  }
+  //--------------------------------------------------------------------
+  ArgppEventReader::~ArgppEventReader()
+  {
+    delete pimpl_;
+  }
+  //--------------------------------------------------------------------
+  bool ArgppEventReader::next(ArgppEvent &ev)
+  {
+    if (!pimpl_) {
+      ev = ArgppEvent();
+      return false;
+    }
+    return pimpl_->next(ev);
+  }
+  //--------------------------------------------------------------------
+  int ArgppEventReader::getIndex() const
+  {
+    return pimpl_ ? pimpl_->index() : 0;
+  }
+  //--------------------------------------------------------------------
+  int ArgppEventReader::getArgc() const
+  {
+    return pimpl_ ? pimpl_->argc() : 0;
+  }
+
+  //--------------------------------------------------------------------
+  // ArgppMultiCall:
+  //--------------------------------------------------------------------
+  ArgppMultiCall::ArgppMultiCall()
+    : pimpl_(new impl::ArgppMultiCallImpl)
+  {}
+  //--------------------------------------------------------------------
+  ArgppMultiCall::ArgppMultiCall(const ArgppApplet *applets, size_t count)
+    : pimpl_(new impl::ArgppMultiCallImpl)
+  {
+    if (applets) {
+      pimpl_->addTable(applets, count);
+    }
+  }
+  //--------------------------------------------------------------------
+  ArgppMultiCall::~ArgppMultiCall()
+  {
+    delete pimpl_;
+  }
+  //--------------------------------------------------------------------
+  bool ArgppMultiCall::addApplet(const std::string &name
+                                 , AppletFactory factory
+                                 , const std::string &doc)
+  {
+    return pimpl_->addApplet(name, factory, doc);
+  }
+  //--------------------------------------------------------------------
+  const ArgppApplet *ArgppMultiCall::findApplet(const char *name) const
+  {
+    return pimpl_->findApplet(name);
+  }
+  //--------------------------------------------------------------------
+  ArgppBase *ArgppMultiCall::createParser(int argc, char **argv) const
+  {
+    return pimpl_->createParser(argc, argv);
+  }
+  //--------------------------------------------------------------------
+  size_t ArgppMultiCall::size() const
+  {
+    return pimpl_->applets_.size();
+  }
+  //--------------------------------------------------------------------
+  const ArgppApplet &ArgppMultiCall::operator[](size_t i) const
+  {
+    return pimpl_->applets_[i];
+  }
 
 } // namespace argpp
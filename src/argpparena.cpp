@@ -0,0 +1,138 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+#include "argpparena.hpp"
+
+namespace argpp {
+  namespace impl {
+
+//--------------------------------------------------------------------
+// The size of the first block taken from the heap:
+//--------------------------------------------------------------------
+static const size_t FIRST_HEAP_BLOCK = 1024;
+
+#ifdef ARGPP_HAVE_PMR
+
+//--------------------------------------------------------------------
+ParseArena::ParseArena()
+  : res_ (new (storage_) std::pmr::monotonic_buffer_resource(FIRST_HEAP_BLOCK))
+{}
+//--------------------------------------------------------------------
+ParseArena::~ParseArena()
+{
+  res_->~monotonic_buffer_resource();
+}
+//--------------------------------------------------------------------
+void ParseArena::setBuffer(void *buf, size_t size)
+{
+  //---------------------------------------------------
+  // The initial buffer of a monotonic_buffer_resource
+  // can only be given to its constructor:
+  //---------------------------------------------------
+  res_->~monotonic_buffer_resource();
+  if (buf && size) {
+    res_ = new (storage_) std::pmr::monotonic_buffer_resource(buf, size);
+  } else {
+    res_ = new (storage_) std::pmr::monotonic_buffer_resource(FIRST_HEAP_BLOCK);
+  }
+}
+//--------------------------------------------------------------------
+void *ParseArena::allocate(size_t size)
+{
+  return res_->allocate(size ? size : 1, ALIGNMENT);
+}
+//--------------------------------------------------------------------
+void ParseArena::release()
+{
+  res_->release();
+}
+
+#else // !ARGPP_HAVE_PMR
+
+//--------------------------------------------------------------------
+ParseArena::ParseArena()
+  : buf_       (NULL)
+  , buf_size_  (0)
+  , cur_       (NULL)
+  , end_       (NULL)
+  , blocks_    (NULL)
+  , next_size_ (FIRST_HEAP_BLOCK)
+{}
+//--------------------------------------------------------------------
+ParseArena::~ParseArena()
+{
+  release();
+}
+//--------------------------------------------------------------------
+void ParseArena::setBuffer(void *buf, size_t size)
+{
+  buf_      = buf;
+  buf_size_ = buf ? size : 0;
+  release();
+}
+//--------------------------------------------------------------------
+void *ParseArena::allocate(size_t size)
+{
+  size = size ? (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT : ALIGNMENT;
+
+  size_t pad = cur_
+      ? (ALIGNMENT - reinterpret_cast<size_t>(cur_) % ALIGNMENT) % ALIGNMENT
+      : 0;
+
+  if (!cur_ || static_cast<size_t>(end_ - cur_) < pad + size) {
+    //-----------------------------------------------
+    // The block header is padded so that the memory
+    // following it is aligned:
+    //-----------------------------------------------
+    size_t header = (sizeof(Block) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    while (next_size_ < size + header) {
+      next_size_ *= 2;
+    }
+    Block *b = static_cast<Block*>(::operator new(next_size_));
+    b->next_ = blocks_;
+    blocks_  = b;
+    cur_     = reinterpret_cast<char*>(b) + header;
+    end_     = reinterpret_cast<char*>(b) + next_size_;
+    next_size_ *= 2;
+    pad = 0;
+  }
+  void *p = cur_ + pad;
+  cur_ += pad + size;
+  return p;
+}
+//--------------------------------------------------------------------
+void ParseArena::release()
+{
+  while (blocks_) {
+    Block *b = blocks_;
+    blocks_ = b->next_;
+    ::operator delete(b);
+  }
+  cur_       = static_cast<char*>(buf_);
+  end_       = cur_ ? cur_ + buf_size_ : NULL;
+  next_size_ = FIRST_HEAP_BLOCK;
+}
+
+#endif // ARGPP_HAVE_PMR
+
+} // namespace impl
+} // namespace argpp
@@ -21,72 +21,80 @@
    Free Software Foundation, Inc.
 */
 #include <algorithm>
-#include "argppbaseimpl.hpp"
-
+#include <cerrno>
+#include <cstring>
 #ifdef _WIN32
-#  define ARGPP_DIR_SEPARATOR '\\'
+#  include <io.h>
 #else
-#  define ARGPP_DIR_SEPARATOR '/'
+#  include <unistd.h>
 #endif
+#include "argppnative.hpp"
+#include "argppplan.hpp"
 
 namespace argpp {
   namespace impl {
 
-#ifdef ARGPP_HAVE_UNIQUE_PTR
-    typedef std::unique_ptr<argpp::ArgppBase> DeleteHelper;
-#else
-///
-/// @class DeleteHelper
-/// @brief The DeleteHelper class facilitates destruction of the singleton
-/// root instance (an ArgppBase pointer).
-/// @details Since it is defined as a static variable in the argppbaseimpl.cpp file,
-/// its destructor calls the destructor of the root instance which destroys
-/// all of its children recursively (via the destructor of the pimpl_ member
-/// it contains).
-///
-class DeleteHelper {
-  public:
-    ///
-    /// @brief The defaul constructor sets the pointer member initially to NULL.
-    ///
-    DeleteHelper() : p_(NULL) {}
-    explicit DeleteHelper(ArgppBase *p) : p_(p) {}
-
-    ~DeleteHelper() { if (p_) delete p_; }
-
-    ArgppBase *get() { return p_; }
-
-    const ArgppBase *get() const { return p_; }
-
-    ArgppBase * operator->() { return p_; }
-
-    const ArgppBase * operator->() const { return p_; }
+//-----------------------------------------------------------------------------
+// Whether getopt takes an element of argv for an option rather than for
+// a non-option argument:
+//-----------------------------------------------------------------------------
+static bool optionLike(const char *a)
+{
+  return a && a[0] == '-' && a[1] != '\0';
+}
 
-    void reset(ArgppBase *p = NULL) {
-      if (p_) {
-        delete p_;
+//-----------------------------------------------------------------------------
+// Works out from state->next alone which element of argv the option which
+// getopt has just handed over came from, as the index it will have once argv
+// has been permuted: that of the argument if the option has one, otherwise
+// that of the option itself. Called by parserRouter() for every option.
+//
+// getopt stays on a cluster of short options such as "-abc" until its last
+// option, so an option without an argument is in the element before "next"
+// unless it is in such a cluster. The non-options which getopt skipped to
+// get to the option are those between where "next" was before and the
+// option; with any skipped earlier on, they are moved behind the option.
+//-----------------------------------------------------------------------------
+static int trackOption(ParseContext &ctx, int key, const char *arg, const argp_state *state)
+{
+  char     **argv  = state->argv;
+  const int  next  = state->next;
+  const int  prev  = ctx.seen_next_ > 1 ? ctx.seen_next_ : 1;
+  const char *cluster = ctx.short_cluster_;
+  int first = next - 1;
+  int idx   = next - 1;
+
+  ctx.short_cluster_ = NULL;
+  if (arg) {
+    for (int i=next-1; i>=0 && i>=next-2; --i) {
+      const char *a = argv[i];
+      if (a && arg >= a && arg <= a + strlen(a)) {
+        idx   = i;
+        first = (arg == a) ? i - 1 : i;
+        break;
       }
-      p_ = p;
     }
+  } else if (cluster && static_cast<unsigned char>(*cluster) == key) {
+    if (cluster[1] != '\0') {
+      first = idx = next;
+      ctx.short_cluster_ = cluster + 1;
+    }
+  } else if (next < state->argc && !(next - 1 >= prev && optionLike(argv[next - 1]))) {
+    const char *a = argv[next];
+    if (a[0] == '-' && a[1] != '-' && static_cast<unsigned char>(a[1]) == key && a[2] != '\0') {
+      first = idx = next;
+      ctx.short_cluster_ = a + 2;
+    }
+  }
 
-    explicit operator bool() const { return p_ != NULL; }
-  private:
-    ArgppBase *p_;
-    //---------------------------
-    // These are not implemented:
-    //---------------------------
-    ///
-    /// @brief The copy constructor is not implemented.
-    ///
-    DeleteHelper(const DeleteHelper& other);
-    ///
-    /// @brief The copy assignment operator is not implemented.
-    ///
-    DeleteHelper& operator=(const DeleteHelper& other);
-};
-#endif
-
-static DeleteHelper gRootInstance;
+  for (int i=prev; i<first && i<state->argc; ++i) {
+    if (!optionLike(argv[i])) {
+      ++ctx.skipped_args_;
+    }
+  }
+  idx -= ctx.skipped_args_;
+  return idx >= 0 ? idx + ctx.argv_offset_ : -1;
+}
 
 //--------------------------------------------------------------------
 // For delimiting the argp vectors:
@@ -95,31 +103,189 @@ static const char *       NULL_CSTRING     = "";
 static const argp_child   NULL_ARGP_CHILD  = argp_child();
 static const argp_option  NULL_ARGP_OPTION = argp_option();
 
+//--------------------------------------------------------------------
+// What the help of a parser with subcommands shows for them:
+//--------------------------------------------------------------------
+static const char *SUBCOMMAND_HEADER   = "Commands:";
+static const char *SUBCOMMAND_ARGS_DOC = "COMMAND [ARG...]";
+
+//--------------------------------------------------------------------
+// The hidden options behind "--help=PATTERN" and "--help-group=N",
+// which the parser at the top of a parse adds to its own. Coming
+// before argp's default options, "help" takes the place of argp's
+// --help, which takes no argument. --help-group is an alias of it, so
+// that "--hel" is not ambiguous; helpSearch() tells them apart by the
+// name on the command line, and takes the N of "--help-group N" from
+// argv itself, since for getopt the argument is optional. If the
+// program has an option named "help" itself, the last entry stands
+// alone and getopt requires its argument:
+//--------------------------------------------------------------------
+static const argp_option HELP_SEARCH_OPTIONS[] = {
+  { "help",       HELP_SEARCH_KEY, "PATTERN", OPTION_HIDDEN | OPTION_ARG_OPTIONAL, NULL, 0 },
+  { "help-group", HELP_SEARCH_KEY, NULL,      OPTION_HIDDEN | OPTION_ALIAS,        NULL, 0 },
+  { "help-group", HELP_SEARCH_KEY, "N",       OPTION_HIDDEN,                       NULL, 0 }
+};
+
+//--------------------------------------------------------------------
+// Whether the option which getopt has just handed over to helpSearch()
+// was given as --help-group, the only one of the two names which is
+// longer than "help", whatever the abbreviation. The name is in the
+// element before "next", or before the argument if getopt took the
+// next element for it:
+//--------------------------------------------------------------------
+static bool namesHelpGroup(const char *arg, const argp_state *state)
+{
+  int i = state->next - 1;
+  if (arg && arg == state->argv[i] && i > 0) {
+    --i;
+  }
+  const char *elem = state->argv[i];
+  const char *name = elem + strspn(elem, "-");
+  return strcspn(name, "=") > strlen("help");
+}
+
 static std::string  gBugAddress;
 static std::string  gProgramVersion;
 
 //--------------------------------------------------------------------
 // Static data members:
 //--------------------------------------------------------------------
-int           ArgppBaseImpl::argc_                    = 0;
-char **       ArgppBaseImpl::argv_                    = NULL;
-unsigned int  ArgppBaseImpl::argp_flags_              = 0;
-error_t       ArgppBaseImpl::error_code_from_argp_    = 0;
-error_t       ArgppBaseImpl::retval_error_            = 0;
-bool          ArgppBaseImpl::parsed_                  = false;
-bool          ArgppBaseImpl::argpp_should_exit_       = false;
-bool          ArgppBaseImpl::root_has_parsed_options_ = true;
-bool          ArgppBaseImpl::root_has_nonopt_args_    = true;
-std::string   ArgppBaseImpl::argp_domain_;
-bool          ArgppBaseImpl::help_called_             = false;
-size_t        ArgppBaseImpl::help_max_blk_size_       = 16384;
 const char   *ArgppBaseImpl::help_max_env_name_       = "ARGPP_MAX_HELP_TEXT";
+
+//--------------------------------------------------------------------
+// ParseContext:
+//--------------------------------------------------------------------
+ParseContext::ParseContext()
+  : selections_              (0)
+  , root_                    ()
+  , parsed_                  (false)
+  , root_has_parsed_options_ (true)
+  , root_has_nonopt_args_    (true)
+  , argp_flags_              (0)
+  , argpp_should_exit_       (false)
+  , error_code_from_argp_    (0)
+  , retval_error_            (0)
+  , argp_domain_             ()
+  , argc_                    (0)
+  , argv_                    (NULL)
+  , help_called_             (false)
+  , vecs_ready_              (false)
+  , help_max_blk_size_       (16384)
+  , engine_                  (ARGPP_DEFAULT_PARSE_ENGINE)
+  , plan_                    (NULL)
+  , result_                  (NULL)
+  , err_stream_              (NULL)
+  , expand_response_files_   (false)
+  , response_files_          ()
+  , stop_at_first_arg_       (false)
+  , hand_off_index_          (-1)
+  , subcommand_owner_        (NULL)
+  , argv_offset_             (0)
+  , seen_next_               (0)
+  , skipped_args_            (0)
+  , short_cluster_           (NULL)
+  , option_index_            (-1)
+  , help_layout_             ()
+{}
+//--------------------------------------------------------------------
+// The context selected on a thread, which is given up when the thread
+// ends; without thread_local support there is only one selection for
+// the whole process, as in earlier releases:
+//--------------------------------------------------------------------
+class ParseContext::Selection
+{
+  public:
+    Selection() : ctx_(NULL) {}
+    ~Selection() { ParseContext::reselect(ctx_, NULL); }
+
+    ParseContext *ctx_;
+
+  private:
+    Selection(const Selection &);
+    Selection& operator=(const Selection &);
+};
+//--------------------------------------------------------------------
+ParseContext::Selection &ParseContext::selection()
+{
+  //------------------------------------------------------------
+  // The registry is made first, so that it still exists when
+  // the selection of the last thread destroys its tree:
+  //------------------------------------------------------------
+  ArgppBaseImpl::registry();
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+  ArgppBaseImpl::registryMutex();
+#endif
+  static ARGPP_THREAD_LOCAL Selection sel;
+  return sel;
+}
+//--------------------------------------------------------------------
+ParseContext &ParseContext::current()
+{
+  Selection &sel = selection();
+  if (!sel.ctx_) {
+    reselect(sel.ctx_, new ParseContext);
+  }
+  return *sel.ctx_;
+}
+//--------------------------------------------------------------------
+void ParseContext::select(ParseContext *ctx)
+{
+  reselect(selection().ctx_, ctx);
+}
+//--------------------------------------------------------------------
+void ParseContext::reselect(ParseContext *&selected, ParseContext *ctx)
+{
+  ParseContext *dropped = NULL;
+  {
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+    std::lock_guard<std::mutex> lock(ArgppBaseImpl::registryMutex());
+#endif
+    if (ctx) {
+      ++ctx->selections_;
+    }
+    if (selected && --selected->selections_ == 0) {
+      dropped = selected;
+    }
+    selected = ctx;
+  }
+  //------------------------------------------------
+  // The tree is destroyed without holding the lock,
+  // since its destructors take it:
+  //------------------------------------------------
+  delete dropped;
+}
+//--------------------------------------------------------------------
+ParseContext &ParseContext::of(const argp_state *state)
+{
+  ParseContext &plans = forPlans();
+  if (plans.plan_) {
+    return plans;
+  }
+  if (state && state->input) {
+    return *ArgppBaseImpl::implOf(static_cast<ArgppBase*>(state->input))->ctx_;
+  }
+  return current();
+}
+//--------------------------------------------------------------------
+ParseContext &ParseContext::forPlans()
+{
+  static ARGPP_THREAD_LOCAL ParseContext ctx;
+  return ctx;
+}
+//--------------------------------------------------------------------
+ParseArena &ParseContext::scratch()
+{
+  static ARGPP_THREAD_LOCAL ParseArena arena;
+  return arena;
+}
+
 //--------------------------------------------------------------------
 // Static member functions:
 //--------------------------------------------------------------------
 error_t ArgppBaseImpl::parserRouter(int key, char *arg, argp_state *state) {
 
-  static error_t retval = ARGPP_UNKNOWN;
+  error_t retval = ARGPP_UNKNOWN;
+  ParseContext &ctx = ParseContext::of(state);
   //-----------------------------------------------------------------
   // Put everything in a separate scope so that locals are cleaned up
   // if we have to call exit():
@@ -136,6 +302,16 @@ error_t ArgppBaseImpl::parserRouter(int key, char *arg, argp_state *state) {
       ArgppBase     *pThis = static_cast<ArgppBase*>(state->input);
       ArgppBaseImpl *p = pThis->pimpl_;
 
+      //-------------------------------------------------------------------------
+      // argp offers every lifecycle key to every parser; those which a parser
+      // doesn't implement (see ArgppBase::setLifecycleKeys()) are declined as
+      // the native engine does, which doesn't pass them on at all:
+      //-------------------------------------------------------------------------
+      const unsigned int lk = lifecycleKey(key);
+      if (lk && !(p->lifecycle_keys_ & lk)) {
+        return ARGPP_UNKNOWN;
+      }
+
       switch (key) {
         case ARGP_KEY_INIT:
           //-------------------------------------------------------------------------
@@ -150,20 +326,29 @@ error_t ArgppBaseImpl::parserRouter(int key, char *arg, argp_state *state) {
           // own, they do the same by setting up their child_inputs when parserRouter
           // is called with key == ARGP_KEY_INIT.
           //
-          // We depend on the sorting order of std::map, which uses the address of
-          // the POD argp_child vector's element as the key, as well as the C++
-          // standard's guarantee that elements of a vector are stored in contiguous
-          // memory. The map's value element (member "second") contains the "this"
-          // pointers to the corresponding children.
+          // Argp numbers the child_inputs[] in the order of the children of the
+          // argp struct, which is the order of children_vec_; child_inputs_ holds
+          // the "this" pointers of the corresponding children in the same order.
+          //
+          // A plan keeps its own copy of the children, since the
+          // tree may have changed after it was compiled. A batch parsed
+          // with a plan collects the error messages of each line, so
+          // argp must print them to the batch's stream.
           //-------------------------------------------------------------------------
-        {
-          size_t len = p->map_of_children_.size();
-          MapOfChildren::const_iterator cit = p->map_of_children_.begin();
-          for(size_t i=0; i<len; ++i, ++cit)
-          {
-            state->child_inputs[i] = static_cast<void*>(cit->second);
+          if (ctx.plan_) {
+            ctx.plan_->setChildInputs(pThis, state->child_inputs);
+            if (ctx.err_stream_) {
+              state->err_stream = ctx.err_stream_;
+            }
+          } else {
+            size_t len = p->child_inputs_.size();
+            for(size_t i=0; i<len; ++i)
+            {
+              state->child_inputs[i] = static_cast<void*>(p->child_inputs_[i]);
+            }
           }
-        }
+          ctx.skipped_args_  = 0;
+          ctx.short_cluster_ = NULL;
           //-----------------------------------------
           // Let the derived class do some additional
           // initialization work here, if any:
@@ -177,7 +362,22 @@ error_t ArgppBaseImpl::parserRouter(int key, char *arg, argp_state *state) {
           retval = pThis->finiImpl(state);
           break;
         case ARGP_KEY_ARG:
-          retval = pThis->keyArgImpl(arg, state);
+          if (!ctx.plan_ && p->selectSubcommand(arg)) {
+            ctx.subcommand_owner_ = pThis;
+          }
+          if (!ctx.plan_ && (ctx.subcommand_owner_ || ctx.stop_at_first_arg_)) {
+            //-----------------------------------------
+            // Leave this argument and everything after
+            // it in argv for the subcommand or for
+            // getRemainingArgv(); argp reads nothing
+            // more:
+            //-----------------------------------------
+            ctx.hand_off_index_ = state->next - 1;
+            state->next = state->argc;
+            retval = ARGPP_SUCCESS;
+          } else {
+            retval = pThis->keyArgImpl(arg, state);
+          }
           break;
         case ARGP_KEY_ARGS:
           retval = pThis->keyArgsImpl(state);
@@ -192,72 +392,113 @@ error_t ArgppBaseImpl::parserRouter(int key, char *arg, argp_state *state) {
           retval = pThis->keyEndImpl(state);
           break;
         default:
-          retval = pThis->parserImpl(key, arg, state);
+          ctx.option_index_ = trackOption(ctx, key, arg, state);
+          if (key == HELP_SEARCH_KEY && p->answersHelpSearch()) {
+            retval = helpSearch(arg, state);
+          } else {
+            retval = pThis->parserImpl(key, arg, state);
+          }
           break;
       }
+      ctx.seen_next_ = state->next;
     }
   }
   //------------------------------------------------------
   // This is where we can safely call exit() if necessary:
   //------------------------------------------------------
-  if (argpp_should_exit_) {
+  if (ctx.argpp_should_exit_) {
+    int status = ctx.error_code_from_argp_;
     clearAllParsers();
-    exit(error_code_from_argp_);
+    exit(status);
   }
   return retval;
 }
 
+//--------------------------------------------------------------------
+unsigned int ArgppBaseImpl::lifecycleKey(int key)
+{
+  switch (key) {
+    case ARGP_KEY_ARGS:    return lk_more_args;
+    case ARGP_KEY_NO_ARGS: return lk_no_args;
+    case ARGP_KEY_END:     return lk_end;
+    case ARGP_KEY_SUCCESS: return lk_success;
+    case ARGP_KEY_ERROR:   return lk_error;
+    case ARGP_KEY_FINI:    return lk_fini;
+    default:               return 0;
+  }
+}
+
+//--------------------------------------------------------------------
+bool HelpFilterKeyLess::operator()(const HelpFilterKey &a, const HelpFilterKey &b) const
+{
+  if (a.first != b.first) {
+    return a.first < b.first;
+  }
+  if (!a.second || !b.second) {
+    return !a.second && b.second;
+  }
+  return strcmp(a.second, b.second) < 0;
+}
+
 //--------------------------------------------------------------------
 char *ArgppBaseImpl::helpFilter(int key, const char *text, void *input)
 {
-  //-------------------------------------------------------
-  // If the derived class does not return a different string,
-  // we have to return the string passed in the "text"
-  // argument, but first cast away its const qualifier:
-  //-------------------------------------------------------
-  char *retval = const_cast<char*>(text);
-
-  //-------------------------------------------------------
-  // These are used in the code which calls malloc()
-  // later on (that is, if the derived implementation of
-  // helpFilterImpl() returns a string we have to copy):
-  //-------------------------------------------------------
-  static const size_t DEFAULT_MEM_BLK_SIZE = 8;
-  static const size_t MAX_BLK_SIZE = ArgppBaseImpl::help_max_blk_size_;
-
-  if (input) {
-    ArgppBase * pThis = static_cast<ArgppBase*>(input);
-    std::string newtxt = pThis->helpFilterImpl(key, text);
-
-    if (!newtxt.empty() && (!text || newtxt.compare(text) != 0)) {
-      //-------------------------------
-      // argp wants a malloc'ed string:
-      //-------------------------------
-      size_t memsize = DEFAULT_MEM_BLK_SIZE;
-      size_t len = newtxt.size();
-
-      if (len < MAX_BLK_SIZE) {
-        // This allocates slightly more memory than
-        // the actual required length plus the
-        // terminating '\0' char:
-        ++len;
-        while (memsize < len) {
-          memsize += DEFAULT_MEM_BLK_SIZE;
-        }
-        --len;
-        void *pmem = malloc(memsize);
-        if (pmem) {
-          char *pTarget = static_cast<char*>(pmem);
-          const char *pBegin = newtxt.c_str();
-          const char *pEnd   = pBegin + len;
-          std::copy(pBegin, pEnd, pTarget);
-          pTarget[len] = '\0';
-          retval = pTarget;
-        }
-      }
+  const char *filtered = filteredText(key, text, input);
+  if (filtered == text) {
+    //-------------------------------------------------------
+    // We have to return the string passed in the "text"
+    // argument, but first cast away its const qualifier:
+    //-------------------------------------------------------
+    return const_cast<char*>(text);
+  }
+  //-------------------------------
+  // argp wants a malloc'ed string:
+  //-------------------------------
+  size_t size = strlen(filtered) + 1;
+  char  *copy = static_cast<char*>(malloc(size));
+  if (!copy) {
+    return const_cast<char*>(text);
+  }
+  memcpy(copy, filtered, size);
+  return copy;
+}
+
+//--------------------------------------------------------------------
+ArgppBase *ArgppBaseImpl::argpOwner(ArgppBase *p, const argp *ap)
+{
+  ArgppBaseImpl *impl = p->pimpl_;
+  if (&impl->main_argp_ == ap) {
+    return p;
+  }
+  for (size_t i=0; i<impl->children_.size(); ++i) {
+    ArgppBase *found = argpOwner(impl->children_[i], ap);
+    if (found) {
+      return found;
     }
   }
-  return retval;
+  return NULL;
+}
+
+//--------------------------------------------------------------------
+void *ArgppBaseImpl::argpInput(const argp *ap, const argp_state *state)
+{
+  if (!state || !ap) {
+    return NULL;
+  }
+  ParseContext &ctx = ParseContext::of(state);
+  if (ctx.plan_) {
+    return ctx.plan_->argpParser(ap);
+  }
+  return ctx.root_ ? argpOwner(ctx.root_.get(), ap) : NULL;
+}
+
+//--------------------------------------------------------------------
+const char *ArgppBaseImpl::filteredText(int key, const char *text, void *input)
+{
+  if (!input) {
+    return text;
+  }
+  return static_cast<ArgppBase*>(input)->pimpl_->filterText(key, text);
 }
 
 //-----------------------------------------------------------------------------
@@ -269,8 +510,11 @@ ArgppBaseImpl::ArgppBaseImpl(
     , ArgppBase *parent
     , ArgppBase *holder)
   : installed_help_filter_         (false)
+  , lifecycle_keys_                (lk_all)
   , holder_                        (holder)
   , holders_parent_                (parent)
+  , ctx_                           (parent ? implOf(parent)->ctx_ : &ParseContext::current())
+  , listed_                        (false)
   , main_argp_                     ()
   , child_argp_                    ()
   , children_vec_                  ()
@@ -284,60 +528,66 @@ ArgppBaseImpl::ArgppBaseImpl(
   , child_header_is_empty_cstring_ (false)
   , child_group_                   (0)
   , children_                      ()
-  , map_of_children_               ()
+  , child_inputs_                  ()
+  , subcommands_                   ()
+  , selected_subcommand_           (NO_SUBCOMMAND)
+  , is_subcommand_                 (false)
   , options_                       ()
+  , key_index_                     ()
+  , name_index_                    ()
+  , help_filter_cache_             ()
+  , help_filter_texts_             ()
+  , parsed_views_                  ()
+  , other_arg_views_               ()
+  , strings_                       ()
   , parsed_options_                ()
   , other_args_                    ()
 {
-  if (!parent) {
-    argc_ = argc;
-    argv_ = argv;
-  }
-  //-----------------------------------------------
-  // check the environment variable
-  // "ARGPP_MAX_HELP_TEXT":
-  //-----------------------------------------------
-  char *pMaxHelpText = getenv(ArgppBaseImpl::help_max_env_name_);
-  if (pMaxHelpText) {
-    size_t maxlen = strtoul(pMaxHelpText, NULL, 10);
-    if (maxlen) {
-      ArgppBaseImpl::help_max_blk_size_ = maxlen;
-    }
+  {
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+    std::lock_guard<std::mutex> lock(registryMutex());
+#endif
+    registry().insert(holder);
   }
+  ParseContext &ctx = *ctx_;
+
   //-----------------------------------------------
-  // Set "help_called_" if one of the special options
-  // was entered:
+  // The children share the command line of the root
+  // instance, so only the root looks at it and at the
+  // environment:
   //-----------------------------------------------
-  std::string arg;
-  for (int i=1; i<argc; ++i) {
-    arg = argv[i];
-    if ((arg == "-?")
-        || (arg == "--h")
-        || (arg == "--he")
-        || (arg == "--hel")
-        || (arg == "--help")
-
-        || ((arg == "-V")         && !gProgramVersion.empty())
-        || ((arg == "--ve")       && !gProgramVersion.empty())
-        || ((arg == "--ver")      && !gProgramVersion.empty())
-        || ((arg == "--vers")     && !gProgramVersion.empty())
-        || ((arg == "--versi")    && !gProgramVersion.empty())
-        || ((arg == "--versio")   && !gProgramVersion.empty())
-        || ((arg == "--version")  && !gProgramVersion.empty())
-
-        || (arg == "--u")
-        || (arg == "--us")
-        || (arg == "--usa")
-        || (arg == "--usag")
-        || (arg == "--usage")) {
-      help_called_ = true;
+  if (!parent) {
+    ctx.argc_ = argc;
+    ctx.argv_ = argv;
+    //-----------------------------------------------
+    // check the environment variable
+    // "ARGPP_MAX_HELP_TEXT":
+    //-----------------------------------------------
+    char *pMaxHelpText = getenv(ArgppBaseImpl::help_max_env_name_);
+    if (pMaxHelpText) {
+      size_t maxlen = strtoul(pMaxHelpText, NULL, 10);
+      if (maxlen) {
+        ctx.help_max_blk_size_ = maxlen;
+      }
     }
+    //-----------------------------------------------
+    // Set "help_called_" if one of the special options
+    // was entered:
+    //-----------------------------------------------
+    ctx.help_called_ = helpRequested(argc, argv, NULL);
   }
+  treeChanged(ctx);
 }
 
 //-----------------------------------------------------------------------------
 ArgppBaseImpl::~ArgppBaseImpl()
 {
+  {
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+    std::lock_guard<std::mutex> lock(registryMutex());
+#endif
+    registry().erase(holder_);
+  }
   if (!children_.empty()) {
     for (ArgppChildren::iterator
          it = children_.begin();
@@ -354,15 +604,16 @@ ArgppBaseImpl::~ArgppBaseImpl()
 //-----------------------------------------------------------------------------
 error_t ArgppBaseImpl::getRetvalErrorFromArgpParse()
 {
-  if (parsed_) {
-    return retval_error_;
+  ParseContext &ctx = ParseContext::current();
+  if (ctx.parsed_) {
+    return ctx.retval_error_;
   }
   return ARGPP_ENODATA;
 }
 //-----------------------------------------------------------------------------
 error_t ArgppBaseImpl::getErrorCodeFromArgp()
 {
-  return error_code_from_argp_;
+  return ParseContext::of(NULL).error_code_from_argp_;
 }
 
 //-----------------------------------------------------------------------------
@@ -383,6 +634,7 @@ bool ArgppBaseImpl::isOptionEnd(const argp_option *opt)
       && (opt->name  == NULL);
 }
 
+
 //-----------------------------------------------------------------------------
 void ArgppBaseImpl::argppError(const argp_state *state, const std::string &errmsg)
 {
@@ -390,65 +642,57 @@ void ArgppBaseImpl::argppError(const argp_state *state, const std::string &errms
 
   if (state) {
     unsigned int f = state->flags;
-    std::string prg_name;
-    std::string msg;
 
     if (state->err_stream) {
       stream = state->err_stream;
     } else {
       stream = stderr;
     }
-
-    if (state->name) {
-      prg_name = state->name;
-    } else if (state->argv && state->argv[0]) {
-      std::string n = state->argv[0];
-      size_t pos = n.rfind(ARGPP_DIR_SEPARATOR);
-      if (pos != std::string::npos) {
-        prg_name = n.substr(pos+1);
-      } else {
-        prg_name = n;
-      }
-    }
-    //--------------------------------------
-    // strip off the './' due to program
-    // invocation from the shell, if any:
-    //--------------------------------------
-    if (prg_name.substr(0,2) == "./") {
-      prg_name = prg_name.substr(2);
-    }
-    msg = prg_name + ": " + errmsg + "\n";
-    fputs(msg.c_str(), stream);
+    fputs(errorLine(state, errmsg).c_str(), stream);
 
     //--------------------------------------------------------
-    // Prevent argp_state_help() from calling exit() so as not
-    // to leak memory in the errmsg argument to this function:
+    // renderHelp() does not call exit(), so as not to leak
+    // memory in the errmsg argument to this function:
     //--------------------------------------------------------
-    struct argp_state s = { state->root_argp
-            , state->argc
-            , state->argv
-            , state->next
-            , state->flags | ARGP_NO_EXIT
-            , state->arg_num
-            , state->quoted
-            , state->input
-            , state->child_inputs
-            , state->hook
-            , state->name
-            , state->err_stream
-            , state->out_stream
-            , state->pstate};
+    renderHelp(state, stream, ARGP_HELP_STD_ERR);
 
-    argp_state_help (&s, stream, ARGP_HELP_STD_ERR);
-
-    error_code_from_argp_ = 1;
+    ParseContext &ctx = ParseContext::of(state);
+    ctx.error_code_from_argp_ = 1;
 
     if ((f & ARGP_NO_EXIT) == 0) {
-      argpp_should_exit_ = true;
+      ctx.argpp_should_exit_ = true;
     }
   }
 }
 //-----------------------------------------------------------------------------
+std::string ArgppBaseImpl::errorLine(const argp_state *state, const std::string &errmsg)
+{
+  std::string prg_name;
+
+  if (state->name) {
+    prg_name = state->name;
+  } else {
+    prg_name = programName(state->argv);
+  }
+  //--------------------------------------
+  // strip off the './' due to program
+  // invocation from the shell, if any:
+  //--------------------------------------
+  if (prg_name.substr(0,2) == "./") {
+    prg_name = prg_name.substr(2);
+  }
+  return prg_name + ": " + errmsg + "\n";
+}
+//-----------------------------------------------------------------------------
+void ArgppBaseImpl::argppError(const argp_state *state, const std::string &errmsg
+                               , std::string &out)
+{
+  if (state) {
+    out += errorLine(state, errmsg);
+    formatHelp(state, ARGP_HELP_STD_ERR, out);
+  }
+}
+//-----------------------------------------------------------------------------
 void ArgppBaseImpl::argppFailure(const argp_state *state, int status, int errnum, const std::string &errmsg)
 {
   //-------------------------------------------------
@@ -474,10 +718,11 @@ void ArgppBaseImpl::argppFailure(const argp_state *state, int status, int errnum
             , state->pstate};
     argp_failure(&s, status, errnum, "%s", errmsg.c_str());
 
+    ParseContext &ctx = ParseContext::of(state);
     if ((f & ARGP_NO_EXIT) == 0) {
-      argpp_should_exit_ = true;
+      ctx.argpp_should_exit_ = true;
     }
-    error_code_from_argp_ = status;
+    ctx.error_code_from_argp_ = status;
   }
 }
 //-----------------------------------------------------------------------------
@@ -485,25 +730,12 @@ void ArgppBaseImpl::argppUsage(const argp_state *state)
 {
   if (state) {
     unsigned int f = state->flags;
-    struct argp_state s = { state->root_argp
-            , state->argc
-            , state->argv
-            , state->next
-            , state->flags | ARGP_NO_EXIT
-            , state->arg_num
-            , state->quoted
-            , state->input
-            , state->child_inputs
-            , state->hook
-            , state->name
-            , state->err_stream
-            , state->out_stream
-            , state->pstate };
-    argp_state_help(&s, stderr, ARGP_HELP_STD_USAGE);
+    renderHelp(state, stderr, ARGP_HELP_STD_USAGE);
+    ParseContext &ctx = ParseContext::of(state);
     if ((f & ARGP_NO_EXIT) == 0) {
-      argpp_should_exit_ = true;
+      ctx.argpp_should_exit_ = true;
     }
-    error_code_from_argp_ = argp_err_exit_status;
+    ctx.error_code_from_argp_ = argp_err_exit_status;
   }
 }
 //-----------------------------------------------------------------------------
@@ -511,31 +743,38 @@ void ArgppBaseImpl::argppStateHelp(const argp_state *state, FILE *stream, unsign
 {
   if (state) {
     unsigned int f = state->flags;
-    struct argp_state s = { state->root_argp
-            , state->argc
-            , state->argv
-            , state->next
-            , state->flags | ARGP_NO_EXIT
-            , state->arg_num
-            , state->quoted
-            , state->input
-            , state->child_inputs
-            , state->hook
-            , state->name
-            , state->err_stream
-            , state->out_stream
-            , state->pstate };
-    argp_state_help(&s, stream, flags);
+    renderHelp(state, stream, flags);
     if ((f & ARGP_NO_EXIT) == 0) {
-      argpp_should_exit_ = true;
+      ParseContext::of(state).argpp_should_exit_ = true;
     }
   }
 }
 //-----------------------------------------------------------------------------
+void ArgppBaseImpl::argppUsage(const argp_state *state, std::string &out)
+{
+  formatHelp(state, ARGP_HELP_STD_USAGE, out);
+}
+//-----------------------------------------------------------------------------
+void ArgppBaseImpl::argppStateHelp(const argp_state *state, std::string &out, unsigned flags)
+{
+  formatHelp(state, flags, out);
+}
+//-----------------------------------------------------------------------------
 void ArgppBaseImpl::clearAllParsers()
 {
-  gRootInstance.reset();
-  parsed_ = false;
+  ParseContext &ctx = ParseContext::current();
+  ctx.root_.reset();
+  ctx.parsed_         = false;
+  ctx.vecs_ready_     = false;
+  ctx.help_layout_.clear();
+  ctx.hand_off_index_ = -1;
+  ctx.response_files_.release();
+}
+//-----------------------------------------------------------------------------
+void ArgppBaseImpl::treeChanged(ParseContext &ctx)
+{
+  ctx.vecs_ready_ = false;
+  ctx.help_layout_.clear();
 }
 //-----------------------------------------------------------------------------
 bool ArgppBaseImpl::flagOk(unsigned &val, argpp_parse_flag chk)
@@ -566,21 +805,35 @@ bool ArgppBaseImpl::internalFlagCheck(unsigned &val, unsigned chk)
 //-----------------------------------------------------------------------------
 ArgppBase *ArgppBaseImpl::getRootInstance()
 {
-  return gRootInstance.get();
+  return ParseContext::current().root_.get();
 }
 //-----------------------------------------------------------------------------
 int ArgppBaseImpl::getArgvIndexAfterArgpParse()
 {
-  if (parsed_ && gRootInstance) {
-    return gRootInstance->pimpl_->argp_flags_;
+  ParseContext &ctx = ParseContext::current();
+  if (ctx.parsed_ && ctx.root_) {
+    return ctx.root_->pimpl_->arg_idx_;
   }
   return 0;
 }
 //-----------------------------------------------------------------------------
 void ArgppBaseImpl::installArgppRootInstance(ArgppBase *pInstance)
 {
-  if (pInstance && !gRootInstance) {
-    gRootInstance.reset(pInstance);
+  ParseContext &ctx = ParseContext::current();
+  if (!pInstance || !pInstance->pimpl_ || ctx.root_) {
+    return;
+  }
+  //-----------------------------------------------
+  // The root instance of a tree made on another
+  // thread makes this thread select its context:
+  //-----------------------------------------------
+  ParseContext *own = pInstance->pimpl_->ctx_;
+  if (own != &ctx) {
+    if (own->root_.get() == pInstance) {
+      ParseContext::select(own);
+    }
+  } else {
+    ctx.root_.reset(pInstance);
   }
 }
 //-----------------------------------------------------------------------------
@@ -611,6 +864,30 @@ void ArgppBaseImpl::installVersionHook(VersionFunc f)
   argp_program_version_hook = f;
 }
 //-----------------------------------------------------------------------------
+bool ArgppBaseImpl::writePrebuiltHelp(FILE *out, const std::string &identifier)
+{
+  ParseContext &ctx = ParseContext::current();
+  ArgppBase* root = ctx.root_.get();
+
+  if (!root || !root->pimpl_ || !out || identifier.empty()) {
+    return false;
+  }
+  //-----------------------------------------------
+  // The texts are formatted for the tree a parse
+  // would see, with argp's own options on top:
+  //-----------------------------------------------
+  root->pimpl_->prepareParserVecs();
+  ctx.vecs_ready_ = true;
+  NativeTable table(&root->pimpl_->main_argp_, ctx.argp_flags_, NULL);
+  return impl::writePrebuiltHelp(out, identifier.c_str(), table.rootArgp()
+                                 , programName(ctx.argv_));
+}
+//-----------------------------------------------------------------------------
+void ArgppBaseImpl::installPrebuiltHelp(const ArgppPrebuiltHelp *help, size_t n)
+{
+  impl::installPrebuiltHelp(help, n);
+}
+//-----------------------------------------------------------------------------
 bool ArgppBaseImpl::isParentValid(ArgppBase *parent)
 {
   bool retval = false;
@@ -627,30 +904,314 @@ bool ArgppBaseImpl::isParentValid(ArgppBase *parent)
 bool ArgppBaseImpl::parse()
 {
   bool retval = false;
-  ArgppBase* root = ArgppBase::getRootInstance();
+  ParseContext &ctx = ParseContext::current();
+  ArgppBase* root = ctx.root_.get();
 
-  if (root && root->pimpl_ && !parsed_) {
+  if (root && root->pimpl_ && !ctx.parsed_) {
     ArgppBaseImpl *p = root->pimpl_;
-    p->prepareParserVecs();
-    error_t e = argp_parse( &p->main_argp_
-                            ,  argc_
-                            ,  argv_
-                            ,  p->argp_flags_
-                            , &p->arg_idx_
-                            ,  root);
-    p->retval_error_ = e;
+    if (!ctx.vecs_ready_) {
+      p->prepareParserVecs();
+      ctx.vecs_ready_ = true;
+    }
+    int    argc = ctx.argc_;
+    char **argv = ctx.argv_;
+    if (ctx.expand_response_files_) {
+      if (!expandResponseFiles(argc, argv)) {
+        return false;
+      }
+      argc = ctx.response_files_.argc();
+      argv = ctx.response_files_.argv();
+    }
+    ctx.help_called_ = helpRequested(argc, argv, &p->main_argp_);
+    //-----------------------------------------------
+    // Each subcommand which is selected parses the
+    // rest of argv in turn, with its name in the
+    // place of the program name:
+    //-----------------------------------------------
+    ArgppBase  *top  = root;
+    int         base = 0;
+    std::string name = programName(argv);
+    error_t     e    = ARGPP_SUCCESS;
+
+    for (;;) {
+      char *token = argv[base];
+      if (base > 0) {
+        argv[base] = &name[0];
+      }
+      ctx.argv_offset_ = base;
+      e = parseStage(top, argc - base, argv + base);
+      argv[base]       = token;
+      ctx.argv_offset_ = 0;
+
+      if (e != ARGPP_SUCCESS || !ctx.subcommand_owner_) {
+        break;
+      }
+      ArgppBase *sub = ctx.subcommand_owner_->pimpl_->instantiateSubcommand();
+      if (!sub) {
+        e = ENOMEM;
+        break;
+      }
+      base += ctx.hand_off_index_;
+      name += ' ';
+      name += argv[base];
+      top   = sub;
+    }
+    if (top != root) {
+      p->arg_idx_ = base + top->pimpl_->arg_idx_;
+    }
+    if (ctx.stop_at_first_arg_) {
+      //-----------------------------------------------
+      // Nothing was handed off if argv ended, maybe
+      // with "--"; --help etc. after the hand-off were
+      // meant for someone else:
+      //-----------------------------------------------
+      ctx.hand_off_index_ = ctx.hand_off_index_ < 0 ? argc : base + ctx.hand_off_index_;
+      p->arg_idx_         = ctx.hand_off_index_;
+      ctx.help_called_    = helpRequested(ctx.hand_off_index_, argv, &p->main_argp_);
+    }
+    ctx.retval_error_ = e;
     retval = (e == ARGPP_SUCCESS);
-    parsed_ = true;
+    ctx.parsed_ = true;
   }
   return retval;
 }
 //-----------------------------------------------------------------------------
+error_t ArgppBaseImpl::parseStage(ArgppBase *top, int argc, char **argv)
+{
+  ParseContext &ctx = ParseContext::current();
+  ArgppBaseImpl *p = top->pimpl_;
+
+  if (top != ctx.root_.get()) {
+    p->prepareParserVecs();
+  }
+  //-----------------------------------------------
+  // Stopping at the first non-option only works if
+  // getopt doesn't look for options beyond it:
+  //-----------------------------------------------
+  unsigned flags = ctx.argp_flags_;
+  if (ctx.stop_at_first_arg_ || p->hasSubcommands()) {
+    flags |= ARGP_IN_ORDER;
+  }
+  ctx.hand_off_index_   = -1;
+  ctx.subcommand_owner_ = NULL;
+
+  error_t e = ARGPP_SUCCESS;
+  if (ctx.engine_ == eng_native) {
+    e = nativeParse(&p->main_argp_
+                    ,  argc
+                    ,  argv
+                    ,  flags
+                    , &p->arg_idx_
+                    ,  top);
+    //--------------------------------------------------
+    // The native engine does not call exit() by itself
+    // when --help, --version etc. were given or after an
+    // error; it has cleaned up when it gets back here:
+    //--------------------------------------------------
+    if (ctx.argpp_should_exit_) {
+      int status = ctx.error_code_from_argp_;
+      clearAllParsers();
+      exit(status);
+    }
+  } else {
+    e = argp_parse( &p->main_argp_
+                    ,  argc
+                    ,  argv
+                    ,  flags
+                    , &p->arg_idx_
+                    ,  top);
+  }
+  return e;
+}
+//-----------------------------------------------------------------------------
+bool ArgppBaseImpl::expandResponseFiles(int argc, char **argv)
+{
+  ParseContext &ctx = ParseContext::current();
+  ResponseFiles &rf = ctx.response_files_;
+
+  error_t e = rf.expand(argc, argv);
+  if (e == ARGPP_SUCCESS) {
+    return true;
+  }
+
+  //---------------------------------------------
+  // argp never gets to see the command line, so
+  // we report the error as argp_failure() would:
+  //---------------------------------------------
+  if ((ctx.argp_flags_ & ARGP_NO_ERRS) == 0) {
+    fprintf(stderr, "%s: @%s: %s\n"
+            , programName(argv)
+            , rf.errorPath().c_str()
+            , rf.errorMessage() ? rf.errorMessage() : strerror(e));
+  }
+  ctx.retval_error_         = e;
+  ctx.error_code_from_argp_ = e;
+  ctx.parsed_               = true;
+  if ((ctx.argp_flags_ & ARGP_NO_EXIT) == 0) {
+    clearAllParsers();
+    exit(argp_err_exit_status);
+  }
+  return false;
+}
+//-----------------------------------------------------------------------------
+int ArgppBaseImpl::getParsedArgc()
+{
+  ParseContext &ctx = ParseContext::current();
+  return ctx.response_files_.argv() ? ctx.response_files_.argc() : ctx.argc_;
+}
+//-----------------------------------------------------------------------------
+char **ArgppBaseImpl::getParsedArgv()
+{
+  ParseContext &ctx = ParseContext::current();
+  return ctx.response_files_.argv() ? ctx.response_files_.argv() : ctx.argv_;
+}
+//-----------------------------------------------------------------------------
+int ArgppBaseImpl::getRemainingArgc()
+{
+  ParseContext &ctx = ParseContext::current();
+  if (ctx.parsed_ && ctx.hand_off_index_ >= 0) {
+    return getParsedArgc() - ctx.hand_off_index_;
+  }
+  return 0;
+}
+//-----------------------------------------------------------------------------
+char **ArgppBaseImpl::getRemainingArgv()
+{
+  ParseContext &ctx = ParseContext::current();
+  if (ctx.parsed_ && ctx.hand_off_index_ >= 0) {
+    return getParsedArgv() + ctx.hand_off_index_;
+  }
+  return NULL;
+}
+//-----------------------------------------------------------------------------
+bool ArgppBaseImpl::reparse(int argc, char **argv)
+{
+  bool retval = false;
+  ParseContext &ctx = ParseContext::current();
+  ArgppBase* root = ctx.root_.get();
+
+  if (root && root->pimpl_) {
+    root->pimpl_->clearResults();
+    ctx.argc_                 = argc;
+    ctx.argv_                 = argv;
+    ctx.parsed_               = false;
+    ctx.retval_error_         = ARGPP_SUCCESS;
+    ctx.error_code_from_argp_ = 0;
+    ctx.argpp_should_exit_    = false;
+    retval = parse();
+  }
+  return retval;
+}
+//-----------------------------------------------------------------------------
+bool ArgppBaseImpl::helpRequested(int argc, char **argv
+                                  , const argp *root, const NativeTable *table)
+{
+  //---------------------------------------------------
+  // The first character rules out most arguments, and
+  // everything after "--" is an argument:
+  //---------------------------------------------------
+  const bool   with_version = !gProgramVersion.empty();
+  NativeTable *own_table    = NULL;
+  bool         retval       = false;
+
+  for (int i=1; i<argc && !retval; ++i) {
+    const char *arg = argv[i];
+    if (arg[0] != '-') {
+      continue;
+    }
+    if (arg[1] == '-' && !arg[2]) {
+      break;
+    }
+    if (isHelpRequest(arg, with_version) || isHelpSearch(arg)) {
+      //---------------------------------------------
+      // The program's own options may take the name
+      // or the abbreviation; the table is only built
+      // when it is needed:
+      //---------------------------------------------
+      if (!table && root) {
+        own_table = new NativeTable(root, ParseContext::current().argp_flags_, NULL);
+        table     = own_table;
+      }
+      retval = !table || (isHelpRequest(arg, *table) && !isOptionArgument(*table, argv, i));
+    }
+  }
+  delete own_table;
+  return retval;
+}
+//-----------------------------------------------------------------------------
+error_t ArgppBaseImpl::helpSearch(const char *arg, argp_state *state)
+{
+  ParseContext &ctx = ParseContext::of(state);
+  ctx.help_called_  = true;
+
+  const bool group = namesHelpGroup(arg, state);
+  if (group && !arg) {
+    if (state->next >= state->argc) {
+      argppError(state, "option '--help-group' requires an argument");
+      return EINVAL;
+    }
+    arg = state->argv[state->next++];
+  }
+
+  if (!arg) {
+    //-----------------------------------------------
+    // Plain "--help", which argp's own option would
+    // have answered:
+    //-----------------------------------------------
+    renderHelp(state, state->out_stream, ARGP_HELP_STD_HELP);
+  } else {
+    //-----------------------------------------------
+    // A search which finds nothing is an error, as
+    // is a group which is not a number:
+    //-----------------------------------------------
+    HelpSearch search;
+    if (!makeHelpSearch(arg, group, search)) {
+      argppError(state, std::string("invalid help group `") + arg + "'");
+      return EINVAL;
+    }
+    if (!renderHelpSearch(state, state->out_stream, search)) {
+      argppError(state, group
+                 ? std::string("no options in group ") + arg
+                 : std::string("no options match `") + arg + "'");
+      return EINVAL;
+    }
+  }
+  if ((state->flags & (ARGP_NO_ERRS | ARGP_NO_EXIT)) == 0) {
+    ctx.argpp_should_exit_    = true;
+    ctx.error_code_from_argp_ = 0;
+  }
+  return ARGPP_SUCCESS;
+}
+//-----------------------------------------------------------------------------
+const char *ArgppBaseImpl::baseName(const char *path)
+{
+  const char *slash = strrchr(path, ARGPP_DIR_SEPARATOR);
+  return slash ? slash + 1 : path;
+}
+//-----------------------------------------------------------------------------
+const char *ArgppBaseImpl::programName(char **argv)
+{
+  return (argv && argv[0]) ? baseName(argv[0]) : "";
+}
+//-----------------------------------------------------------------------------
 bool ArgppBaseImpl::setArgpParseFlags(unsigned int flags)
 {
   bool retval = false;
   argpp_parse_flag chk = fl_all_check;
   if (flagOk(flags, chk)) {
-    argp_flags_ = flags;
+    ParseContext &ctx = ParseContext::current();
+    ctx.argp_flags_ = flags;
+    treeChanged(ctx);
+    retval = true;
+  }
+  return retval;
+}
+//-----------------------------------------------------------------------------
+bool ArgppBaseImpl::setParseEngine(argpp_parse_engine eng)
+{
+  bool retval = false;
+  if (eng == eng_argp || eng == eng_native) {
+    ParseContext::current().engine_ = eng;
     retval = true;
   }
   return retval;
@@ -658,17 +1219,19 @@ bool ArgppBaseImpl::setArgpParseFlags(unsigned int flags)
 //-----------------------------------------------------------------------------
 unsigned int ArgppBaseImpl::getArgpParserFlags()
 {
-  return argp_flags_;
+  return ParseContext::current().argp_flags_;
 }
 //-----------------------------------------------------------------------------
 void ArgppBaseImpl::setDomain(const std::string &dom)
 {
-  argp_domain_ = dom;
+  ParseContext &ctx = ParseContext::current();
+  ctx.argp_domain_ = dom;
+  treeChanged(ctx);
 }
 //-----------------------------------------------------------------------------
 const std::string & ArgppBaseImpl::getDomain()
 {
-  return argp_domain_;
+  return ParseContext::current().argp_domain_;
 }
 
 //-----------------------------------------------------------------------------
@@ -676,14 +1239,22 @@ const std::string & ArgppBaseImpl::getDomain()
 //-----------------------------------------------------------------------------
 void ArgppBaseImpl::addChild(ArgppBase *pChild)
 {
-  if (pChild && !isChildOfThisParent(pChild)) {
+  //---------------------------------------------------
+  // A parser can't be its own child, nor the child of
+  // one of its descendants:
+  //---------------------------------------------------
+  if (pChild && pChild != holder_
+      && !isChildOfThisParent(pChild)
+      && !pChild->pimpl_->isGrandChild(holder_)) {
     ArgppBaseImpl *pc = pChild->pimpl_;
     if ( pc->holders_parent_
          && (pc->holders_parent_ != this->holder_)) {
       pc->holders_parent_->pimpl_->removeChild(pChild);
     }
     pc->holders_parent_ = this->holder_;
+    pc->listed_         = true;
     children_.push_back(pChild);
+    treeChanged(*ctx_);
   }
 }
 //-----------------------------------------------------------------------------
@@ -693,7 +1264,16 @@ bool ArgppBaseImpl::addOption(const ArgppOption &opt)
   unsigned int flags = opt.flags_;
   argpp_option_flag chk = opt_all_check;
   if (flagOk(flags, chk)) {
+    size_t idx = options_.size();
     options_.push_back(opt);
+    // insert() does not overwrite, so the first option added wins:
+    if (opt.key_) {
+      key_index_.insert(std::make_pair(opt.key_, idx));
+    }
+    if (!opt.long_name_.empty()) {
+      name_index_.insert(std::make_pair(opt.long_name_, idx));
+    }
+    treeChanged(*ctx_);
     retval = true;
   }
   return retval;
@@ -737,15 +1317,59 @@ bool ArgppBaseImpl::addOptions(const argp_option *ao, size_t len)
   return retval;
 }
 //-----------------------------------------------------------------------------
+ParseContext &ArgppBaseImpl::context() const
+{
+  ParseContext &plans = ParseContext::forPlans();
+  return plans.plan_ ? plans : *ctx_;
+}
+//-----------------------------------------------------------------------------
+ArgppBaseImpl *ArgppBaseImpl::resultsOwner(bool to_root)
+{
+  if (to_root) {
+    ArgppBase * root = ctx_->root_.get();
+    return (root && root->pimpl_) ? root->pimpl_ : NULL;
+  }
+  return this;
+}
+//-----------------------------------------------------------------------------
+ArgppStringView ArgppBaseImpl::ownString(const std::string &s)
+{
+  if (s.empty()) {
+    return ArgppStringView();
+  }
+  char *copy = static_cast<char*>(strings_.allocate(s.size() + 1));
+  memcpy(copy, s.c_str(), s.size() + 1);
+  return ArgppStringView(copy, s.size());
+}
+//-----------------------------------------------------------------------------
 void ArgppBaseImpl::addParsedOption(const ParsedOption &opt)
 {
-  if (root_has_parsed_options_) {
-    ArgppBase * root = getRootInstance();
-    if (root && root->pimpl_) {
-      root->pimpl_->parsed_options_.push_back(opt);
+  ParseContext &ctx = context();
+  if (ctx.result_) {
+    ArgppParseResult *r = ctx.result_;
+    r->parsed_views_.push_back(ParsedOptionView(opt.key_
+                                                , r->ownString(opt.long_name_)
+                                                , r->ownString(opt.arg_)));
+  } else {
+    ArgppBaseImpl *p = resultsOwner(ctx.root_has_parsed_options_);
+    if (p) {
+      p->parsed_views_.push_back(ParsedOptionView(opt.key_
+                                                  , p->ownString(opt.long_name_)
+                                                  , p->ownString(opt.arg_)));
     }
+  }
+}
+//-----------------------------------------------------------------------------
+void ArgppBaseImpl::addParsedOption(const ParsedOptionView &opt)
+{
+  ParseContext &ctx = context();
+  if (ctx.result_) {
+    ctx.result_->parsed_views_.push_back(opt);
   } else {
-    parsed_options_.push_back(opt);
+    ArgppBaseImpl *p = resultsOwner(ctx.root_has_parsed_options_);
+    if (p) {
+      p->parsed_views_.push_back(opt);
+    }
   }
 }
 //-----------------------------------------------------------------------------
@@ -757,26 +1381,69 @@ void ArgppBaseImpl::addParsedOption(int key, const std::string &ln, const std::s
 //-----------------------------------------------------------------------------
 void ArgppBaseImpl::addNonOptionArg(const std::string &arg)
 {
-  if (root_has_nonopt_args_) {
-    ArgppBase *root = getRootInstance();
-    if (root && root->pimpl_) {
-      root->pimpl_->other_args_.push_back(arg);
+  ParseContext &ctx = context();
+  if (ctx.result_) {
+    ArgppParseResult *r = ctx.result_;
+    r->other_arg_views_.push_back(NonOptionArgView(r->ownString(arg)));
+  } else {
+    ArgppBaseImpl *p = resultsOwner(ctx.root_has_nonopt_args_);
+    if (p) {
+      p->other_arg_views_.push_back(NonOptionArgView(p->ownString(arg)));
     }
+  }
+}
+//-----------------------------------------------------------------------------
+void ArgppBaseImpl::addNonOptionArg(const NonOptionArgView &arg)
+{
+  NonOptionArgViews *views = nonOptionArgSink();
+  if (views) {
+    views->push_back(arg);
+  }
+}
+//-----------------------------------------------------------------------------
+bool ArgppBaseImpl::setLifecycleKeys(unsigned keys)
+{
+  if (keys & ~static_cast<unsigned>(lk_all)) {
+    return false;
+  }
+  lifecycle_keys_ = keys;
+  return true;
+}
+//-----------------------------------------------------------------------------
+NonOptionArgViews *ArgppBaseImpl::nonOptionArgSink()
+{
+  ParseContext &ctx = context();
+  NonOptionArgViews *retval = NULL;
+  if (ctx.result_) {
+    retval = &ctx.result_->other_arg_views_;
   } else {
-    this->other_args_.push_back(arg);
+    ArgppBaseImpl *p = resultsOwner(ctx.root_has_nonopt_args_);
+    if (p) {
+      retval = &p->other_arg_views_;
+    }
   }
+  return retval;
 }
 //-----------------------------------------------------------------------------
 bool ArgppBaseImpl::findOption(int key, ArgppOption &opt) const
 {
   bool retval = false;
-  ArgppOption o;
-  o.key_ = key;
+  OptionKeyIndex::const_iterator cit = key_index_.find(key);
 
-  Opt_It_const cit = std::find(options_.begin(), options_.end(), o);
+  if (cit != key_index_.end()) {
+    opt = options_[cit->second];
+    retval = true;
+  }
+  return retval;
+}
+//-----------------------------------------------------------------------------
+bool ArgppBaseImpl::findOption(const std::string &long_name, ArgppOption &opt) const
+{
+  bool retval = false;
+  OptionNameIndex::const_iterator cit = name_index_.find(long_name);
 
-  if (cit != options_.end()) {
-    opt = *cit;
+  if (cit != name_index_.end()) {
+    opt = options_[cit->second];
     retval = true;
   }
   return retval;
@@ -786,24 +1453,140 @@ error_t ArgppBaseImpl::implKeyArg(const char *arg, argp_state *state)
 {
   if (arg && state) {
     //---------------------------------------------
-    // We copy the first arg to other_args_
-    // and "steal" the rest:
+    // We record the first arg in other_arg_views_
+    // and "steal" the rest; argp has already moved
+    // "next" past the first one. An arg which isn't
+    // in argv (see readNonOptionArgs()) may not
+    // outlive this call, so it is copied:
     //---------------------------------------------
-    addNonOptionArg(arg);
+    NonOptionArgViews *views = nonOptionArgSink();
+    if (views && state->argc >= state->next) {
+      views->reserve(views->size() + static_cast<size_t>(state->argc - state->next) + 1);
+    }
+    const int offset = ParseContext::of(state).argv_offset_;
+    if (state->next > 0 && state->argv && state->argv[state->next - 1] == arg) {
+      addNonOptionArg(NonOptionArgView(arg, offset + state->next - 1));
+    } else {
+      addNonOptionArg(std::string(arg));
+    }
     for (int i=state->next; i<state->argc; ++i) {
-      addNonOptionArg(state->argv[(size_t)i]);
+      addNonOptionArg(NonOptionArgView(state->argv[(size_t)i], offset + i));
     }
   }
   state->next = state->argc;
   return ARGPP_SUCCESS;
 }
 //-----------------------------------------------------------------------------
-error_t ArgppBaseImpl::genericParserImpl(int key, const char *arg, argp_state * /* unused */)
+// The size of the blocks read by readNonOptionArgs():
+//-----------------------------------------------------------------------------
+static const size_t NONOPT_READ_SIZE = 256 * 1024;
+//-----------------------------------------------------------------------------
+static long readBlock(int fd, char *buf, size_t size)
+{
+#ifdef _WIN32
+  return _read(fd, buf, static_cast<unsigned>(size));
+#else
+  return static_cast<long>(read(fd, buf, size));
+#endif
+}
+//-----------------------------------------------------------------------------
+// An argument which func or keyArgImpl() declines with ARGPP_DONT_CARE is
+// skipped; only a real error stops readNonOptionArgs():
+//-----------------------------------------------------------------------------
+static error_t nonOptionArgResult(error_t err)
+{
+  return (err == ARGPP_DONT_CARE) ? ARGPP_SUCCESS : err;
+}
+//-----------------------------------------------------------------------------
+error_t ArgppBaseImpl::readNonOptionArgs(int fd, char delim, NonOptionArgFunc func, void *data)
+{
+  ParseContext &ctx = *ctx_;
+
+  //---------------------------------------------
+  // keyArgImpl() gets a state for a command line
+  // with an empty argv, so that the default
+  // implementation takes nothing more from it:
+  //---------------------------------------------
+  ArgppBase *root = ctx.root_.get();
+  argp_state state;
+  memset(&state, 0, sizeof(state));
+  state.root_argp  = root ? &implOf(root)->main_argp_ : &main_argp_;
+  state.flags      = ctx.argp_flags_;
+  state.input      = holder_;
+  state.err_stream = stderr;
+  state.out_stream = stdout;
+  state.name       = const_cast<char*>(programName(ctx.argv_));
+
+  //---------------------------------------------
+  // buf[begin, end) holds what has been read but
+  // not handed on yet; it only grows if a single
+  // argument doesn't fit:
+  //---------------------------------------------
+  std::vector<char> buf(NONOPT_READ_SIZE + 1);
+  size_t begin  = 0;
+  size_t end    = 0;
+  bool   at_eof = false;
+  error_t retval = ARGPP_SUCCESS;
+
+  for (;;) {
+    char *d = NULL;
+    while (!retval
+           && (d = static_cast<char*>(memchr(&buf[begin], delim, end - begin))) != NULL) {
+      *d = '\0';
+      retval = nonOptionArgResult(func ? func(&buf[begin], data)
+                                       : holder_->keyArgImpl(&buf[begin], &state));
+      begin = static_cast<size_t>(d - &buf[0]) + 1;
+    }
+    if (retval) {
+      break;
+    }
+    if (at_eof) {
+      //-----------------------------------------
+      // The last argument without a delimiter;
+      // there is always room for the NUL:
+      //-----------------------------------------
+      if (begin < end) {
+        buf[end] = '\0';
+        retval = nonOptionArgResult(func ? func(&buf[begin], data)
+                                         : holder_->keyArgImpl(&buf[begin], &state));
+      }
+      break;
+    }
+
+    if (begin > 0) {
+      memmove(&buf[0], &buf[begin], end - begin);
+      end  -= begin;
+      begin = 0;
+    }
+    if (end == buf.size() - 1) {
+      buf.resize(2 * buf.size());
+    }
+    long got = readBlock(fd, &buf[end], buf.size() - 1 - end);
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      retval = errno;
+      break;
+    }
+    if (got == 0) {
+      at_eof = true;
+    } else {
+      end += static_cast<size_t>(got);
+    }
+  }
+  return retval;
+}
+//-----------------------------------------------------------------------------
+error_t ArgppBaseImpl::genericParserImpl(int key, const char *arg, argp_state *state)
 {
   error_t retval = ARGPP_DONT_CARE;
-  std::string ln;
-  if (supportedOption(key,arg,&ln) == ARGPP_OPTION_OK) {
-    addParsedOption(key,ln,arg ? std::string(arg) : std::string());
+  if (supportedOption(key,arg) == ARGPP_OPTION_OK) {
+    const std::string &ln = options_[key_index_.find(key)->second].long_name_;
+    addParsedOption(ParsedOptionView(key
+                                     , ArgppStringView(ln.data(), ln.size())
+                                     , ArgppStringView(arg)
+                                     , ParseContext::of(state).option_index_));
     retval = ARGPP_SUCCESS;
   }
   return retval;
@@ -831,11 +1614,18 @@ const ArgppBase *ArgppBaseImpl::getParent() const
 //-----------------------------------------------------------------------------
 const ParsedOptions &ArgppBaseImpl::getParsedOptions() const
 {
+  for (size_t i=parsed_options_.size(); i<parsed_views_.size(); ++i) {
+    const ParsedOptionView &v = parsed_views_[i];
+    parsed_options_.push_back(ParsedOption(v.key_, v.long_name_.str(), v.arg_.str()));
+  }
   return parsed_options_;
 }
 //-----------------------------------------------------------------------------
 const OtherArgs &ArgppBaseImpl::getNonOptionArgs() const
 {
+  for (size_t i=other_args_.size(); i<other_arg_views_.size(); ++i) {
+    other_args_.push_back(other_arg_views_[i].arg_.str());
+  }
   return other_args_;
 }
 //-----------------------------------------------------------------------------
@@ -843,42 +1633,268 @@ void ArgppBaseImpl::installHelpFilter()
 {
   main_argp_.help_filter = ArgppBaseImpl::helpFilter;
   installed_help_filter_ = true;
+  treeChanged(*ctx_);
 }
 //-----------------------------------------------------------------------------
-bool ArgppBaseImpl::isChildOfThisParent(ArgppBase *pChild) const
+void ArgppBaseImpl::clearHelpFilterCache()
 {
-  bool retval = false;
-  if (pChild && !children_.empty()) {
-    retval =
-        (std::find(children_.begin(), children_.end(), pChild)
-         != children_.end());
+  {
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+    std::lock_guard<std::mutex> lock(help_filter_mutex_);
+#endif
+    help_filter_cache_.clear();
+    help_filter_texts_.clear();
   }
-  return retval;
+  //-----------------------------------------------
+  // The help texts which were formatted with the
+  // old results are kept with the layout. This
+  // may be called from helpFilterImpl() while one
+  // is being formatted, so the layout stays:
+  //-----------------------------------------------
+  ctx_->help_layout_.clearTexts();
+}
+//-----------------------------------------------------------------------------
+const char *ArgppBaseImpl::filterText(int key, const char *text)
+{
+  {
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+    std::lock_guard<std::mutex> lock(help_filter_mutex_);
+#endif
+    HelpFilterCache::const_iterator it = help_filter_cache_.find(HelpFilterKey(key, text));
+    if (it != help_filter_cache_.end()) {
+      return it->second.changed_ ? it->second.text_.c_str() : text;
+    }
+  }
+
+  //-----------------------------------------------
+  // helpFilterImpl() is called without holding the
+  // lock, since it may call clearHelpFilterCache()
+  // or format a help text itself:
+  //-----------------------------------------------
+  HelpFilterResult result;
+  std::string      newtxt = holder_->helpFilterImpl(key, text);
+
+  result.changed_ = !newtxt.empty()
+                    && (!text || newtxt.compare(text) != 0)
+                    && newtxt.size() < ctx_->help_max_blk_size_;
+  if (result.changed_) {
+    result.text_.swap(newtxt);
+  }
+
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+  std::lock_guard<std::mutex> lock(help_filter_mutex_);
+#endif
+  //-----------------------------------------------
+  // If another thread got there first, its result
+  // is kept. The key refers to a copy of the text,
+  // which may be a temporary one:
+  //-----------------------------------------------
+  HelpFilterCache::const_iterator it = help_filter_cache_.find(HelpFilterKey(key, text));
+  if (it == help_filter_cache_.end()) {
+    const char *kept = NULL;
+    if (text) {
+      help_filter_texts_.push_back(text);
+      kept = help_filter_texts_.back().c_str();
+    }
+    it = help_filter_cache_.insert(std::make_pair(HelpFilterKey(key, kept), result)).first;
+  }
+  return it->second.changed_ ? it->second.text_.c_str() : text;
+}
+//-----------------------------------------------------------------------------
+bool ArgppBaseImpl::isChildOfThisParent(ArgppBase *pChild) const
+{
+  return isRegistered(pChild) && (listedParent(pChild) == holder_);
 }
 //-----------------------------------------------------------------------------
 bool ArgppBaseImpl::isGrandChild(ArgppBase *pChild) const
 {
+  //---------------------------------------------------
+  // Follow the parents up from pChild, which takes as
+  // many steps as pChild is deep in the tree:
+  //---------------------------------------------------
   bool retval = false;
-  if (!children_.empty()) {
-    retval = isChildOfThisParent(pChild);
-    if (!retval) {
-      Child_It_const cit = children_.begin();
-      while (cit != children_.end()) {
-        retval = (*cit)->isGrandChild(pChild);
-        if (retval) break;
-        ++cit;
-      }
+  if (isRegistered(pChild)) {
+    for (const ArgppBase *p = listedParent(pChild); p && !retval; p = listedParent(p)) {
+      retval = (p == holder_);
     }
   }
   return retval;
 }
 //-----------------------------------------------------------------------------
+ArgppBase *ArgppBaseImpl::listedParent(const ArgppBase *p)
+{
+  return p->pimpl_->listed_ ? p->pimpl_->holders_parent_ : NULL;
+}
+//-----------------------------------------------------------------------------
+ParserRegistry &ArgppBaseImpl::registry()
+{
+  static ParserRegistry parsers;
+  return parsers;
+}
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+//-----------------------------------------------------------------------------
+std::mutex &ArgppBaseImpl::registryMutex()
+{
+  static std::mutex mutex;
+  return mutex;
+}
+#endif
+//-----------------------------------------------------------------------------
+bool ArgppBaseImpl::isRegistered(const ArgppBase *p)
+{
+  if (!p) {
+    return false;
+  }
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+  std::lock_guard<std::mutex> lock(registryMutex());
+#endif
+  const ParserRegistry &parsers = registry();
+  return parsers.find(p) != parsers.end();
+}
+//-----------------------------------------------------------------------------
+bool ArgppBaseImpl::addSubcommand(const std::string &name
+                                  , SubcommandFactory factory
+                                  , const std::string &doc)
+{
+  if (name.empty() || !factory) {
+    return false;
+  }
+  Subcommands::iterator it = std::lower_bound(subcommands_.begin(), subcommands_.end()
+                                              , name.c_str(), subcommandNameLess);
+  if (it != subcommands_.end() && it->name_ == name) {
+    return false;
+  }
+  Subcommand sc;
+  sc.name_    = name;
+  sc.doc_     = doc;
+  sc.factory_ = factory;
+  sc.order_   = subcommands_.size();
+  sc.parser_  = NULL;
+  subcommands_.insert(it, sc);
+  selected_subcommand_ = NO_SUBCOMMAND;
+  treeChanged(*ctx_);
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool ArgppBaseImpl::subcommandNameLess(const Subcommand &sc, const char *name)
+{
+  return strcmp(sc.name_.c_str(), name) < 0;
+}
+//-----------------------------------------------------------------------------
+ArgppBase *ArgppBaseImpl::getSubcommand() const
+{
+  return selected_subcommand_ < subcommands_.size()
+      ? subcommands_[selected_subcommand_].parser_ : NULL;
+}
+//-----------------------------------------------------------------------------
+const std::string &ArgppBaseImpl::getSubcommandName() const
+{
+  static const std::string none;
+  return getSubcommand() ? subcommands_[selected_subcommand_].name_ : none;
+}
+//-----------------------------------------------------------------------------
+bool ArgppBaseImpl::hasSubcommands() const
+{
+  if (!subcommands_.empty()) {
+    return true;
+  }
+  for (Child_It_const
+       cit  = children_.begin();
+       cit != children_.end();
+       ++cit) {
+    if (!(*cit)->pimpl_->is_subcommand_ && (*cit)->pimpl_->hasSubcommands()) {
+      return true;
+    }
+  }
+  return false;
+}
+//-----------------------------------------------------------------------------
+bool ArgppBaseImpl::hasLongOption(const char *name) const
+{
+  for (Opt_It_const
+       cit  = options_.begin();
+       cit != options_.end();
+       ++cit) {
+    if (!(cit->flags_ & opt_is_doc) && cit->long_name_ == name) {
+      return true;
+    }
+  }
+  for (Child_It_const
+       cit  = children_.begin();
+       cit != children_.end();
+       ++cit) {
+    if (!(*cit)->pimpl_->is_subcommand_ && (*cit)->pimpl_->hasLongOption(name)) {
+      return true;
+    }
+  }
+  return false;
+}
+//-----------------------------------------------------------------------------
+bool ArgppBaseImpl::answersHelpSearch() const
+{
+  return !holders_parent_ || is_subcommand_;
+}
+//-----------------------------------------------------------------------------
+bool ArgppBaseImpl::selectSubcommand(const char *name)
+{
+  selected_subcommand_ = NO_SUBCOMMAND;
+  if (name) {
+    Subcommands::const_iterator cit = std::lower_bound(subcommands_.begin(), subcommands_.end()
+                                                       , name, subcommandNameLess);
+    if (cit != subcommands_.end() && cit->name_ == name) {
+      selected_subcommand_ = static_cast<size_t>(cit - subcommands_.begin());
+      return true;
+    }
+  }
+  return false;
+}
+//-----------------------------------------------------------------------------
+ArgppBase *ArgppBaseImpl::instantiateSubcommand()
+{
+  if (selected_subcommand_ >= subcommands_.size()) {
+    return NULL;
+  }
+  Subcommand &sc = subcommands_[selected_subcommand_];
+  if (!sc.parser_) {
+    //---------------------------------------------
+    // The factory adds the new parser to our
+    // children; from now on, setupChildren()
+    // leaves it out of our argp struct:
+    //---------------------------------------------
+    sc.parser_ = sc.factory_(holder_);
+    if (!sc.parser_) {
+      return NULL;
+    }
+    sc.parser_->pimpl_->is_subcommand_ = true;
+    treeChanged(*ctx_);
+  }
+  return sc.parser_;
+}
+//-----------------------------------------------------------------------------
 void ArgppBaseImpl::prepareParserVecs()
 {
   setupOptions();
   setupChildren();
 }
 //-----------------------------------------------------------------------------
+void ArgppBaseImpl::clearResults()
+{
+  parsed_views_.clear();
+  other_arg_views_.clear();
+  strings_.release();
+  parsed_options_.clear();
+  other_args_.clear();
+  arg_idx_ = 0;
+  selected_subcommand_ = NO_SUBCOMMAND;
+
+  for (Child_It_const
+       cit  = children_.begin();
+       cit != children_.end();
+       ++cit) {
+    (*cit)->pimpl_->clearResults();
+  }
+}
+//-----------------------------------------------------------------------------
 void ArgppBaseImpl::removeChild(ArgppBase *pChild)
 {
   if ( pChild->getParent() == holder_
@@ -889,6 +1905,8 @@ void ArgppBaseImpl::removeChild(ArgppBase *pChild)
                     , pChild);
     if (it != children_.end()) {
       children_.erase(it);
+      pChild->pimpl_->listed_ = false;
+      treeChanged(*ctx_);
     }
   }
 }
@@ -899,6 +1917,7 @@ bool ArgppBaseImpl::setChildFlags(unsigned int flags)
   // if there is no parent, then this isn't a child:
   if (retval && holders_parent_) {
     child_argp_.flags = flags;
+    treeChanged(*ctx_);
   }
   return retval;
 }
@@ -907,6 +1926,7 @@ void ArgppBaseImpl::setChildHeader(const std::string &header, bool use_empty_cst
 {
   child_header_ = header;
   child_header_is_empty_cstring_ = use_empty_cstring;
+  treeChanged(*ctx_);
 }
 //-----------------------------------------------------------------------------
 void ArgppBaseImpl::setDocMessage(const std::string &msg)
@@ -929,12 +1949,14 @@ void ArgppBaseImpl::setDocMessage(const std::string &msg)
       pre_doc_msg_ = doc_msg_;
     }
   }
+  treeChanged(*ctx_);
 }
 //-----------------------------------------------------------------------------
 void ArgppBaseImpl::setGroup(int group)
 {
   if (holders_parent_ != NULL) {
     child_argp_.group = group;
+    treeChanged(*ctx_);
   }
 }
 //-----------------------------------------------------------------------------
@@ -971,6 +1993,7 @@ void ArgppBaseImpl::syncDocMsg()
   } else {
     doc_msg_ = pre_doc_msg_;
   }
+  treeChanged(*ctx_);
 }
 //-----------------------------------------------------------------------------
 void ArgppBaseImpl::setupChildren()
@@ -989,9 +2012,21 @@ void ArgppBaseImpl::setupChildren()
   // I know, it's paranoid, but...
   //---------------------------------------------------
   children_vec_.clear();
+  child_inputs_.clear();
+
+  // the +1 is for the terminator:
+  children_vec_.reserve(len_children + 1);
+  child_inputs_.reserve(len_children);
 
   for (size_t i=0; i<len_children; ++i) {
 
+    //-----------------------------------------------
+    // The parsers of subcommands are set up when they
+    // are selected, and parsed on their own:
+    //-----------------------------------------------
+    if (children_[i]->pimpl_->is_subcommand_) {
+      continue;
+    }
     children_[i]->pimpl_->prepareParserVecs();
 
     //-----------------------------------------------
@@ -1000,13 +2035,11 @@ void ArgppBaseImpl::setupChildren()
     children_vec_.push_back(children_[i]->pimpl_->child_argp_);
 
     //-----------------------------------------------
-    // Map the "this" pointers so that parserRouter()
-    // can find the right objects later:
+    // Keep the "this" pointers in the same order so
+    // that parserRouter() can find the right objects
+    // later:
     //-----------------------------------------------
-    argp_child* ac = &children_vec_[i];
-    ArgppBase*  pc = children_[i];
-
-    map_of_children_.insert(std::make_pair(ac, pc));
+    child_inputs_.push_back(children_[i]);
   }
 
   //---------------------------------------------------------
@@ -1024,11 +2057,11 @@ void ArgppBaseImpl::setupChildren()
     //-----------------------------------------------
     // Use the flags from the parent if ours are 0,
     // unless root is our parent in which case we use
-    // the static member argp_flags_:
+    // the flags stored in the ParseContext:
     //-----------------------------------------------
     if (!child_argp_.flags) {
       if (!holders_parent_->pimpl_->holders_parent_) {
-        child_argp_.flags = static_cast<int>(argp_flags_);
+        child_argp_.flags = static_cast<int>(ctx_->argp_flags_);
       } else {
         child_argp_.flags = holders_parent_->childFlags();
       }
@@ -1042,11 +2075,13 @@ void ArgppBaseImpl::setupChildren()
   // do the main_argp_ now:
   main_argp_.options     = option_vec_.empty()    ? NULL : &option_vec_[0];
   main_argp_.parser      = parserRouter;
-  main_argp_.args_doc    = usage_msg_.empty()     ? NULL : usage_msg_.c_str();
+  main_argp_.args_doc    = !usage_msg_.empty()    ? usage_msg_.c_str()
+                         : !subcommands_.empty()  ? SUBCOMMAND_ARGS_DOC : NULL;
   main_argp_.doc         = doc_msg_.empty()       ? NULL : doc_msg_.c_str();
   main_argp_.children    = children_vec_.empty()  ? NULL : &children_vec_[0];
   main_argp_.help_filter = installed_help_filter_ ? helpFilter : NULL;
-  main_argp_.argp_domain = argp_domain_.empty()   ? NULL : argp_domain_.c_str();
+  const std::string &dom = ctx_->argp_domain_;
+  main_argp_.argp_domain = dom.empty()            ? NULL : dom.c_str();
 }
 //-----------------------------------------------------------------------------
 void ArgppBaseImpl::setupOptions()
@@ -1058,6 +2093,7 @@ void ArgppBaseImpl::setupOptions()
   // I know, it's paranoid, but...
   //---------------------------------------------------
   option_vec_.clear();
+  option_vec_.reserve(len_opts + (subcommands_.empty() ? 0 : subcommands_.size() + 1) + 2 + 1);
 
   for (size_t i=0; i<len_opts; ++i) {
     opt.name  = options_[i].long_name_.empty() ? NULL : options_[i].long_name_.c_str();
@@ -1070,6 +2106,48 @@ void ArgppBaseImpl::setupOptions()
     option_vec_.push_back(opt);
   }
 
+  //---------------------------------------------------
+  // The subcommands are listed in the help as
+  // documentation entries under a header of their own:
+  //---------------------------------------------------
+  if (!subcommands_.empty()) {
+    opt     = NULL_ARGP_OPTION;
+    opt.doc = SUBCOMMAND_HEADER;
+    option_vec_.push_back(opt);
+
+    //-------------------------------------------------
+    // subcommands_ is sorted by name; the help lists
+    // them in the order in which they were added:
+    //-------------------------------------------------
+    const size_t first = option_vec_.size();
+    option_vec_.resize(first + subcommands_.size(), NULL_ARGP_OPTION);
+
+    for (Subcommands::const_iterator
+         cit  = subcommands_.begin();
+         cit != subcommands_.end();
+         ++cit) {
+      argp_option &sub = option_vec_[first + cit->order_];
+      sub.name  = cit->name_.c_str();
+      sub.flags = OPTION_DOC | OPTION_NO_USAGE;
+      sub.doc   = cit->doc_.empty() ? NULL : cit->doc_.c_str();
+    }
+  }
+
+  //---------------------------------------------------
+  // --help=PATTERN and --help-group=N, unless the tree
+  // has options of the same names:
+  //---------------------------------------------------
+  if (answersHelpSearch() && !(ctx_->argp_flags_ & ARGP_NO_HELP)) {
+    const bool help  = !hasLongOption("help");
+    const bool group = !hasLongOption("help-group");
+    if (help) {
+      option_vec_.push_back(HELP_SEARCH_OPTIONS[0]);
+    }
+    if (group) {
+      option_vec_.push_back(HELP_SEARCH_OPTIONS[help ? 1 : 2]);
+    }
+  }
+
   if (!option_vec_.empty()) {
     option_vec_.push_back(NULL_ARGP_OPTION);
   }
@@ -1078,19 +2156,18 @@ void ArgppBaseImpl::setupOptions()
 int ArgppBaseImpl::supportedOption(int key, const char *arg, std::string *long_name)
 {
   int retval = ARGPP_OPTION_UNKNOWN;
-  ArgppOption opt;
-  opt.key_ = key;
-  Opt_It_const cit = std::find(options_.begin(), options_.end(), opt);
-  if (cit != options_.end()) {
+  OptionKeyIndex::const_iterator idx = key_index_.find(key);
+  if (idx != key_index_.end()) {
+    const ArgppOption &opt = options_[idx->second];
     // check the flags:
-    bool arg_required = !cit->arg_.empty()
-        && !(cit->flags_ & OPTION_ARG_OPTIONAL);
+    bool arg_required = !opt.arg_.empty()
+        && !(opt.flags_ & OPTION_ARG_OPTIONAL);
     if (arg_required && !arg) {
       retval = ARGPP_OPTION_NEEDS_ARG;
     } else {
       retval = ARGPP_OPTION_OK;
       if (long_name) {
-        *long_name = cit->long_name_;
+        *long_name = opt.long_name_;
       }
     }
   }
@@ -1100,6 +2177,7 @@ int ArgppBaseImpl::supportedOption(int key, const char *arg, std::string *long_n
 void ArgppBaseImpl::setUsageMessage(const std::string &msg)
 {
   usage_msg_ = msg;
+  treeChanged(*ctx_);
 }
 //-----------------------------------------------------------------------------
 
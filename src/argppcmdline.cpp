@@ -0,0 +1,139 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+#include <cstring>
+#include "argppcmdline.hpp"
+
+namespace argpp {
+  namespace impl {
+
+//--------------------------------------------------------------------
+static bool isBlank(char c)
+{
+  return (c == ' ') || (c == '\t') || (c == '\n')
+      || (c == '\r') || (c == '\v') || (c == '\f');
+}
+
+//--------------------------------------------------------------------
+CommandLineSplitter::CommandLineSplitter()
+  : words_ ()
+  , argv_  (1, static_cast<char*>(NULL))
+  , error_ (NULL)
+{}
+//--------------------------------------------------------------------
+bool CommandLineSplitter::split(const char *begin, const char *end)
+{
+  words_.assign(begin, end);
+  words_.push_back('\0');
+  argv_.clear();
+
+  char *text = &words_[0];
+  error_ = splitInPlace(text, text + (end - begin), argv_);
+  if (error_) {
+    argv_.clear();
+  }
+  argv_.push_back(NULL);
+  return error_ == NULL;
+}
+//--------------------------------------------------------------------
+const char *CommandLineSplitter::splitInPlace(char *begin, char *end, std::vector<char*> &words)
+{
+  //---------------------------------------------------
+  // Each character read yields at most one character
+  // written, so w never overtakes p; the NUL after a
+  // word is written once the blank which ends it has
+  // been read:
+  //---------------------------------------------------
+  char *p = begin;
+  char *w = begin;
+
+  for (;;) {
+    while (p < end && isBlank(*p)) {
+      ++p;
+    }
+    if (p < end && *p == '#') {
+      while (p < end && *p != '\n') {
+        ++p;
+      }
+      continue;
+    }
+    if (p == end) {
+      break;
+    }
+
+    words.push_back(w);
+    while (p < end && !isBlank(*p)) {
+      char c = *p++;
+      if (c == '\\') {
+        //-------------------------------------------
+        // A backslash at the very end is kept, as
+        // there is no next line to continue with:
+        //-------------------------------------------
+        if (p == end) {
+          *w++ = c;
+        } else if (*p == '\n') {
+          ++p;
+        } else {
+          *w++ = *p++;
+        }
+      } else if (c == '\'') {
+        char *q = static_cast<char*>(memchr(p, '\'', static_cast<size_t>(end - p)));
+        if (!q) {
+          return "unterminated single quote";
+        }
+        memmove(w, p, static_cast<size_t>(q - p));
+        w += q - p;
+        p  = q + 1;
+      } else if (c == '"') {
+        bool closed = false;
+        while (p < end) {
+          char d = *p++;
+          if (d == '"') {
+            closed = true;
+            break;
+          }
+          if (d == '\\' && p < end && *p == '\n') {
+            ++p;
+            continue;
+          }
+          if (d == '\\' && p < end && *p && strchr("$`\"\\", *p)) {
+            d = *p++;
+          }
+          *w++ = d;
+        }
+        if (!closed) {
+          return "unterminated double quote";
+        }
+      } else {
+        *w++ = c;
+      }
+    }
+    if (p < end) {
+      ++p;
+    }
+    *w++ = '\0';
+  }
+  return NULL;
+}
+
+} // namespace impl
+} // namespace argpp
@@ -0,0 +1,2168 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <clocale>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+#ifdef __GLIBC__
+#  include <libintl.h>
+#endif
+#include "argpphelp.hpp"
+#include "argppnative.hpp"
+#include "argppplan.hpp"
+
+namespace argpp {
+  namespace impl {
+
+//--------------------------------------------------------------------
+// The size of the buffer of the stream and how much room printf()
+// asks for, as in argp-fmtstream.c. Since the text which has been
+// flushed can't be wrapped any more, these determine where long
+// lines are broken, and must not be changed:
+//--------------------------------------------------------------------
+static const size_t INIT_BUF_SIZE      = 200;
+static const size_t PRINTF_SIZE_GUESS  = 150;
+//--------------------------------------------------------------------
+// Room past the end of the buffer for the line break which argp puts
+// after a word that ends right at the end of the text:
+//--------------------------------------------------------------------
+static const size_t BUF_SLACK          = 2;
+
+//--------------------------------------------------------------------
+// The formatting parameters which can be set with the environment
+// variable ARGP_HELP_FMT ("struct uparams" in argp-help.c):
+//--------------------------------------------------------------------
+struct HelpParams {
+  int dup_args_;
+  int dup_args_note_;
+  int short_opt_col_;
+  int long_opt_col_;
+  int doc_opt_col_;
+  int opt_doc_col_;
+  int header_col_;
+  int usage_indent_;
+  int rmargin_;
+  bool valid_;
+};
+
+static HelpParams params = { 0, 1, 2, 6, 2, 29, 1, 12, 79, false };
+
+struct HelpParamName {
+  const char *name_;
+  bool        is_bool_;
+  int HelpParams::*member_;
+};
+
+static const HelpParamName PARAM_NAMES[] = {
+  { "dup-args",      true,  &HelpParams::dup_args_      },
+  { "dup-args-note", true,  &HelpParams::dup_args_note_ },
+  { "short-opt-col", false, &HelpParams::short_opt_col_ },
+  { "long-opt-col",  false, &HelpParams::long_opt_col_  },
+  { "doc-opt-col",   false, &HelpParams::doc_opt_col_   },
+  { "opt-doc-col",   false, &HelpParams::opt_doc_col_   },
+  { "header-col",    false, &HelpParams::header_col_    },
+  { "usage-indent",  false, &HelpParams::usage_indent_  },
+  { "rmargin",       false, &HelpParams::rmargin_       },
+  { NULL,            false, NULL                        }
+};
+
+//--------------------------------------------------------------------
+static const char *domainText(const char *domain, const char *msgid)
+{
+#ifdef __GLIBC__
+  return msgid ? dgettext(domain, msgid) : NULL;
+#else
+  (void)domain;
+  return msgid;
+#endif
+}
+
+//--------------------------------------------------------------------
+static const char *rootDomain(const argp_state *state)
+{
+  return state ? state->root_argp->argp_domain : NULL;
+}
+
+//--------------------------------------------------------------------
+// Checks the columns against the right margin; the parameters are
+// only taken over if they are all consistent:
+//--------------------------------------------------------------------
+static void validateParams(const argp_state *state, const HelpParams &p)
+{
+  for (const HelpParamName *n = PARAM_NAMES; n->name_; ++n) {
+    if (n->is_bool_ || n->member_ == &HelpParams::rmargin_) {
+      continue;
+    }
+    if (p.*(n->member_) >= p.rmargin_) {
+      argp_failure(state, 0, 0
+                   , domainText(rootDomain(state)
+                                , "ARGP_HELP_FMT: %s value is less than or equal to %s")
+                   , "rmargin", n->name_);
+      return;
+    }
+  }
+  params        = p;
+  params.valid_ = true;
+}
+
+//--------------------------------------------------------------------
+// Reads ARGP_HELP_FMT as argp does, with the same messages. As with
+// argp, the parameters are read once, or each time until the variable
+// is set to something valid:
+//--------------------------------------------------------------------
+static void fillInParams(const argp_state *state)
+{
+  const char *var = getenv("ARGP_HELP_FMT");
+  HelpParams  p   = params;
+
+  if (!var) {
+    return;
+  }
+  while (*var) {
+    while (isspace(static_cast<unsigned char>(*var))) {
+      ++var;
+    }
+    if (isalpha(static_cast<unsigned char>(*var))) {
+      const char *arg     = var;
+      bool        unspec  = false;
+      int         val     = 0;
+
+      while (isalnum(static_cast<unsigned char>(*arg)) || *arg == '-' || *arg == '_') {
+        ++arg;
+      }
+      size_t var_len = arg - var;
+
+      while (isspace(static_cast<unsigned char>(*arg))) {
+        ++arg;
+      }
+      if (*arg == '\0' || *arg == ',') {
+        unspec = true;
+      } else if (*arg == '=') {
+        ++arg;
+        while (isspace(static_cast<unsigned char>(*arg))) {
+          ++arg;
+        }
+      }
+
+      if (unspec) {
+        if (var[0] == 'n' && var[1] == 'o' && var[2] == '-') {
+          val      = 0;
+          var     += 3;
+          var_len -= 3;
+        } else {
+          val = 1;
+        }
+      } else if (isdigit(static_cast<unsigned char>(*arg))) {
+        val = atoi(arg);
+        while (isdigit(static_cast<unsigned char>(*arg))) {
+          ++arg;
+        }
+        while (isspace(static_cast<unsigned char>(*arg))) {
+          ++arg;
+        }
+      }
+
+      const HelpParamName *n = PARAM_NAMES;
+      for (; n->name_; ++n) {
+        if (strlen(n->name_) == var_len && strncmp(var, n->name_, var_len) == 0) {
+          if (unspec && !n->is_bool_) {
+            argp_failure(state, 0, 0
+                         , domainText(rootDomain(state)
+                                      , "%.*s: ARGP_HELP_FMT parameter requires a value")
+                         , static_cast<int>(var_len), var);
+          } else {
+            p.*(n->member_) = val;
+          }
+          break;
+        }
+      }
+      if (!n->name_) {
+        argp_failure(state, 0, 0
+                     , domainText(rootDomain(state), "%.*s: Unknown ARGP_HELP_FMT parameter")
+                     , static_cast<int>(var_len), var);
+      }
+      var = arg;
+      if (*var == ',') {
+        ++var;
+      }
+    } else if (*var) {
+      argp_failure(state, 0, 0
+                   , domainText(rootDomain(state), "Garbage in ARGP_HELP_FMT: %s"), var);
+      break;
+    }
+  }
+  validateParams(state, p);
+}
+
+//--------------------------------------------------------------------
+// The properties of options, as in argp.h:
+//--------------------------------------------------------------------
+static bool oend(const argp_option *o)
+{
+  return !o->key && !o->name && !o->doc && !o->group;
+}
+static bool oshort(const argp_option *o)
+{
+  return !(o->flags & OPTION_DOC)
+      && o->key > 0 && o->key <= UCHAR_MAX && isprint(o->key);
+}
+static bool oalias(const argp_option *o)   { return (o->flags & OPTION_ALIAS)  != 0; }
+static bool ovisible(const argp_option *o) { return (o->flags & OPTION_HIDDEN) == 0; }
+static bool odoc(const argp_option *o)     { return (o->flags & OPTION_DOC)    != 0; }
+
+//--------------------------------------------------------------------
+// Applies the help filter of ap, if any. The caller passes the result
+// to HelpLayout::releaseText():
+//--------------------------------------------------------------------
+static const char *filterDoc(const char *doc, int key, const argp *ap, const argp_state *state)
+{
+  if (ap && ap->help_filter) {
+    return HelpLayout::filterText(ap, key, doc, HelpLayout::argpInput(ap, state));
+  }
+  return doc;
+}
+
+//--------------------------------------------------------------------
+// If an OPTION_DOC entry has a name beginning with '-', it is sorted
+// as if it were a real option:
+//--------------------------------------------------------------------
+static bool canonDocOption(const char **name)
+{
+  while (isspace(static_cast<unsigned char>(**name))) {
+    ++*name;
+  }
+  bool non_opt = (**name != '-');
+  while (**name && !isalnum(static_cast<unsigned char>(**name))) {
+    ++*name;
+  }
+  return non_opt;
+}
+
+//--------------------------------------------------------------------
+// The order of the groups: 0, 1, 2, ..., n, -m, ..., -2, -1:
+//--------------------------------------------------------------------
+static int groupCmp(int group1, int group2)
+{
+  if ((group1 < 0 && group2 < 0) || (group1 >= 0 && group2 >= 0)) {
+    return group1 - group2;
+  }
+  return group2 - group1;
+}
+
+//--------------------------------------------------------------------
+// The text of the help, wrapped as by argp's fmtstream. The text is
+// collected in a small buffer and wrapped when it is flushed, which
+// is done in the same places as argp does it, so that the lines are
+// broken in the same places too. What has been flushed is appended
+// to a string instead of being written.
+//--------------------------------------------------------------------
+class HelpStream
+{
+  public:
+    HelpStream(std::string &out, size_t lmargin, size_t rmargin, long wmargin)
+      : out_        (out)
+      , storage_    (INIT_BUF_SIZE + BUF_SLACK)
+      , lmargin_    (lmargin)
+      , rmargin_    (rmargin)
+      , wmargin_    (wmargin)
+      , point_offs_ (0)
+      , point_col_  (0)
+    {
+      buf_ = &storage_[0];
+      p_   = buf_;
+      end_ = buf_ + INIT_BUF_SIZE;
+    }
+    ~HelpStream()
+    {
+      update();
+      out_.append(buf_, p_ - buf_);
+    }
+
+    void write(const char *str, size_t len)
+    {
+      if (p_ + len <= end_ || ensure(len)) {
+        memcpy(p_, str, len);
+        p_ += len;
+      }
+    }
+    void puts(const char *str)
+    {
+      size_t len = strlen(str);
+      if (len) {
+        write(str, len);
+      }
+    }
+    void putc(char c)
+    {
+      if (p_ < end_ || ensure(1)) {
+        *p_++ = c;
+      }
+    }
+    void printf(const char *fmt, ...)
+    {
+      size_t size_guess = PRINTF_SIZE_GUESS;
+      size_t avail;
+      int    out;
+      do {
+        if (!ensure(size_guess)) {
+          return;
+        }
+        va_list args;
+        va_start(args, fmt);
+        avail = end_ - p_;
+        out   = vsnprintf(p_, avail, fmt, args);
+        va_end(args);
+        if (out < 0) {
+          return;
+        }
+        if (static_cast<size_t>(out) >= avail) {
+          size_guess = out + 1;
+        }
+      } while (static_cast<size_t>(out) >= avail);
+      p_ += out;
+    }
+
+    size_t setLmargin(size_t m) { prepare(); size_t old = lmargin_; lmargin_ = m; return old; }
+    long   setWmargin(long m)   { prepare(); long   old = wmargin_; wmargin_ = m; return old; }
+    size_t lmargin() const { return lmargin_; }
+    size_t rmargin() const { return rmargin_; }
+    long   wmargin() const { return wmargin_; }
+    ///
+    /// @brief Returns the column the next character will be printed at.
+    ///
+    size_t point()
+    {
+      prepare();
+      return point_col_ >= 0 ? point_col_ : 0;
+    }
+
+  private:
+    void prepare()
+    {
+      if (static_cast<size_t>(p_ - buf_) > point_offs_) {
+        update();
+      }
+    }
+    bool ensure(size_t amount);
+    void update();
+
+    std::string      &out_;
+    std::vector<char> storage_;
+    char             *buf_;
+    char             *p_;
+    char             *end_;
+    size_t            lmargin_;
+    size_t            rmargin_;
+    ///
+    /// @brief The column to indent wrapped lines to, or -1 to truncate them.
+    ///
+    long              wmargin_;
+    ///
+    /// @brief How much of the buffer has been wrapped already.
+    ///
+    size_t            point_offs_;
+    ///
+    /// @brief The column at point_offs_, or -1 for column 0 without the left margin.
+    ///
+    long              point_col_;
+
+    HelpStream(const HelpStream &);
+    HelpStream& operator=(const HelpStream &);
+};
+
+//--------------------------------------------------------------------
+// Makes room for amount more characters, flushing the buffer if
+// needed (__argp_fmtstream_ensure):
+//--------------------------------------------------------------------
+bool HelpStream::ensure(size_t amount)
+{
+  if (static_cast<size_t>(end_ - p_) < amount) {
+    update();
+    out_.append(buf_, p_ - buf_);
+    p_          = buf_;
+    point_offs_ = 0;
+
+    if (static_cast<size_t>(end_ - buf_) < amount) {
+      storage_.resize(storage_.size() + amount);
+      buf_ = &storage_[0];
+      end_ = buf_ + storage_.size() - BUF_SLACK;
+      p_   = buf_;
+    }
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------
+// Wraps the text from point_offs_ to the end of the buffer
+// (__argp_fmtstream_update):
+//--------------------------------------------------------------------
+void HelpStream::update()
+{
+  char  *buf = buf_ + point_offs_;
+  char  *nl;
+  size_t len;
+
+  while (buf < p_) {
+    if (point_col_ == 0 && lmargin_ != 0) {
+      //-----------------------------------------------
+      // A new line; indent it to the left margin:
+      //-----------------------------------------------
+      const size_t pad = lmargin_;
+      if (p_ + pad < end_) {
+        memmove(buf + pad, buf, p_ - buf);
+        p_ += pad;
+        memset(buf, ' ', pad);
+        buf += pad;
+      } else {
+        out_.append(pad, ' ');
+      }
+      point_col_ = pad;
+    }
+
+    len = p_ - buf;
+    nl  = static_cast<char*>(memchr(buf, '\n', len));
+
+    if (point_col_ < 0) {
+      point_col_ = 0;
+    }
+
+    if (!nl) {
+      if (point_col_ + len < rmargin_) {
+        //-----------------------------------------------
+        // A partial line which fits:
+        //-----------------------------------------------
+        point_col_ += len;
+        break;
+      }
+      nl = p_;
+    } else if (point_col_ + (nl - buf) < static_cast<long>(rmargin_)) {
+      //-----------------------------------------------
+      // A full line which fits:
+      //-----------------------------------------------
+      point_col_ = 0;
+      buf        = nl + 1;
+      continue;
+    }
+
+    //-----------------------------------------------
+    // The line is too long:
+    //-----------------------------------------------
+    long r = static_cast<long>(rmargin_) - 1;
+
+    if (wmargin_ < 0) {
+      //-----------------------------------------------
+      // Truncate it:
+      //-----------------------------------------------
+      if (nl < p_) {
+        memmove(buf + (r - point_col_), nl, p_ - nl);
+        p_        -= buf + (r - point_col_) - nl;
+        point_col_ = 0;
+        buf       += r + 1;
+      } else {
+        point_col_ += len;
+        p_         -= point_col_ - r;
+        break;
+      }
+    } else {
+      //-----------------------------------------------
+      // Wrap it at the beginning of the word which
+      // crosses the right margin:
+      //-----------------------------------------------
+      long  i = r + 1 - point_col_;
+      char *nextline;
+
+      //-----------------------------------------------
+      // If the last word ends right at the margin, this
+      // looks at the character past the text, as argp
+      // does; it is a blank only if one was left there
+      // by text which has been flushed or moved:
+      //-----------------------------------------------
+      while (i >= 0
+             && (buf + i == end_ || !isblank(static_cast<unsigned char>(buf[i])))) {
+        --i;
+      }
+      nextline = buf + i + 1;
+
+      if (nextline > buf) {
+        //-------------------------------------------
+        // Swallow the blanks between the words:
+        //-------------------------------------------
+        if (i >= 0) {
+          do {
+            --i;
+          } while (i >= 0 && isblank(static_cast<unsigned char>(buf[i])));
+        }
+        nl = buf + i + 1;
+      } else {
+        //-------------------------------------------
+        // A single word longer than the line; it
+        // is left on an overlong line by itself.
+        // Like argp, this steps past the margin
+        // even if the word ends right there, and
+        // then breaks the line after the character
+        // following it:
+        //-------------------------------------------
+        char *p = buf + (r + 1 - point_col_);
+        do {
+          ++p;
+        } while (p < nl && !isblank(static_cast<unsigned char>(*p)));
+        if (p == nl) {
+          point_col_ = 0;
+          buf        = nl + 1;
+          continue;
+        }
+        nl = p;
+        //-------------------------------------------
+        // Like the word above, the blanks after it
+        // may run past the text:
+        //-------------------------------------------
+        do {
+          ++p;
+        } while (p < end_ + BUF_SLACK && isblank(static_cast<unsigned char>(*p)));
+        nextline = p;
+      }
+
+      if ((nextline == buf + len + 1
+           ? end_ - nl < wmargin_ + 1
+           : nextline - (nl + 1) < wmargin_)
+          && p_ > nextline) {
+        //-------------------------------------------
+        // The margin needs more blanks than were
+        // removed:
+        //-------------------------------------------
+        if (end_ - p_ > wmargin_ + 1) {
+          size_t mv = p_ - nextline;
+          memmove(nl + 1 + wmargin_, nextline, mv);
+          nextline = nl + 1 + wmargin_;
+          len      = nextline + mv - buf;
+          *nl++    = '\n';
+        } else {
+          out_.append(buf_, nl - buf_);
+          out_ += '\n';
+          len += buf - buf_;
+          nl = buf = buf_;
+        }
+      } else {
+        *nl++ = '\n';
+      }
+
+      if (nextline - nl >= wmargin_
+          || (nextline == buf + len + 1 && end_ - nextline >= wmargin_)) {
+        for (long j = 0; j < wmargin_; ++j) {
+          *nl++ = ' ';
+        }
+      } else {
+        out_.append(wmargin_, ' ');
+      }
+
+      //-----------------------------------------------
+      // If the line was broken at the end of the text,
+      // nextline may be past it, and the text is that
+      // much shorter; argp would move the text to before
+      // the start of the buffer if that were possible:
+      //-----------------------------------------------
+      if (nl < nextline && nextline < buf + len) {
+        memmove(nl, nextline, buf + len - nextline);
+      }
+      p_         = nl + (static_cast<ptrdiff_t>(len) - (nextline - buf));
+      if (p_ < buf_) {
+        p_ = buf_;
+      }
+      buf        = nl;
+      point_col_ = wmargin_ ? wmargin_ : -1;
+    }
+  }
+  point_offs_ = p_ - buf_;
+}
+
+//--------------------------------------------------------------------
+// HelpLayout:
+//--------------------------------------------------------------------
+struct HelpLayout::HelpState {
+  ///
+  /// @brief The previous entry printed, or NULL.
+  ///
+  const Entry *prev_entry_;
+  ///
+  /// @brief If set, a blank line is printed between the groups.
+  ///
+  bool         sep_groups_;
+  ///
+  /// @brief Set if the argument of a short option was left out because the
+  /// option has a long name too.
+  ///
+  bool         suppressed_dup_arg_;
+};
+
+struct HelpLayout::EntryState {
+  const Entry      *entry_;
+  HelpStream       *stream_;
+  HelpState        *hhstate_;
+  const argp       *root_;
+  ///
+  /// @brief True as long as nothing has been printed for the entry.
+  ///
+  bool              first_;
+  const argp_state *state_;
+};
+
+//--------------------------------------------------------------------
+HelpLayout::HelpLayout()
+  : key_           ()
+  , entries_       ()
+  , clusters_      ()
+  , short_options_ ()
+  , built_         (false)
+  , texts_         ()
+  , words_         ()
+  , groups_        ()
+  , indexed_       (false)
+  , fp_key_        ()
+  , fp_bug_address_()
+  , fp_            (0)
+  , fp_status_     (-1)
+{}
+//--------------------------------------------------------------------
+void HelpLayout::clear()
+{
+  key_.clear();
+  entries_.clear();
+  clusters_.clear();
+  short_options_.clear();
+  built_ = false;
+  texts_.clear();
+  words_.clear();
+  groups_.clear();
+  indexed_ = false;
+  fp_key_.clear();
+  fp_status_ = -1;
+}
+//--------------------------------------------------------------------
+void HelpLayout::clearTexts()
+{
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+#endif
+  texts_.clear();
+}
+//--------------------------------------------------------------------
+const char *HelpLayout::filterText(const argp *ap, int key, const char *text, void *input)
+{
+  if (ap->help_filter == ArgppBaseImpl::helpFilter) {
+    return ArgppBaseImpl::filteredText(key, text, input);
+  }
+  return (*ap->help_filter)(key, text, input);
+}
+//--------------------------------------------------------------------
+void HelpLayout::releaseText(const argp *ap, const char *filtered, const char *text)
+{
+  if (ap && filtered && filtered != text && ap->help_filter != ArgppBaseImpl::helpFilter) {
+    free(const_cast<char*>(filtered));
+  }
+}
+//--------------------------------------------------------------------
+void *HelpLayout::argpInput(const argp *ap, const argp_state *state)
+{
+  return ArgppBaseImpl::argpInput(ap, state);
+}
+//--------------------------------------------------------------------
+bool HelpLayout::keyMatches(const argp *ap, const std::vector<const void*> &key, size_t &pos)
+{
+  if (pos + 2 > key.size()
+      || key[pos] != static_cast<const void*>(ap->options)
+      || key[pos + 1] != static_cast<const void*>(ap->children)) {
+    return false;
+  }
+  pos += 2;
+  if (ap->children) {
+    for (const argp_child *child = ap->children; child->argp; ++child) {
+      if (pos >= key.size() || key[pos] != static_cast<const void*>(child->argp)) {
+        return false;
+      }
+      ++pos;
+      if (!keyMatches(child->argp, key, pos)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+//--------------------------------------------------------------------
+void HelpLayout::addKey(const argp *ap, std::vector<const void*> &key)
+{
+  key.push_back(ap->options);
+  key.push_back(ap->children);
+  if (ap->children) {
+    for (const argp_child *child = ap->children; child->argp; ++child) {
+      key.push_back(child->argp);
+      addKey(child->argp, key);
+    }
+  }
+}
+//--------------------------------------------------------------------
+bool HelpLayout::isFor(const argp *root) const
+{
+  size_t pos = 0;
+  return built_ && root && keyMatches(root, key_, pos) && pos == key_.size();
+}
+//--------------------------------------------------------------------
+// Adds the entries of ap and of its children in pre-order, which is
+// the order in which argp_hol() merges them. A short option is only
+// shown for the first entry which has it; seen has an element for
+// each character:
+//--------------------------------------------------------------------
+void HelpLayout::addArgp(const argp *ap, const argp *root, int cluster, bool *seen)
+{
+  const argp *owner = (ap == root) ? NULL : ap;
+
+  key_.push_back(ap->options);
+  key_.push_back(ap->children);
+
+  if (ap->options) {
+    int cur_group = 0;
+    const argp_option *o = ap->options;
+    while (!oend(o)) {
+      Entry e;
+      e.opt_     = o;
+      e.num_     = 0;
+      e.so_      = short_options_.size();
+      e.group_   = cur_group = o->group
+                             ? o->group
+                             : ((!o->name && !o->key) ? cur_group + 1 : cur_group);
+      e.cluster_ = cluster;
+      e.argp_    = owner;
+      do {
+        ++e.num_;
+        if (oshort(o) && !seen[static_cast<unsigned char>(o->key)]) {
+          seen[static_cast<unsigned char>(o->key)] = true;
+          short_options_ += static_cast<char>(o->key);
+        }
+        ++o;
+      } while (!oend(o) && oalias(o));
+      entries_.push_back(e);
+    }
+  }
+
+  if (ap->children) {
+    for (const argp_child *child = ap->children; child->argp; ++child) {
+      int child_cluster = cluster;
+      if (child->group || child->header) {
+        Cluster cl;
+        cl.header_ = child->header;
+        cl.index_  = static_cast<int>(child - ap->children);
+        cl.group_  = child->group;
+        cl.parent_ = cluster;
+        cl.argp_   = owner;
+        cl.depth_  = (cluster >= 0) ? clusters_[cluster].depth_ + 1 : 0;
+        child_cluster = static_cast<int>(clusters_.size());
+        clusters_.push_back(cl);
+      }
+      key_.push_back(child->argp);
+      addArgp(child->argp, root, child_cluster, seen);
+    }
+  }
+}
+//--------------------------------------------------------------------
+// Moves the first entry with the long option name into group
+// (hol_set_group):
+//--------------------------------------------------------------------
+void HelpLayout::setGroup(const char *name, int group)
+{
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    const argp_option *opt = entries_[i].opt_;
+    for (unsigned n = entries_[i].num_; n > 0; --n, ++opt) {
+      if (opt->name && ovisible(opt) && strcmp(opt->name, name) == 0) {
+        entries_[i].group_ = group;
+        return;
+      }
+    }
+  }
+}
+//--------------------------------------------------------------------
+void HelpLayout::build(const argp *root)
+{
+  if (!root || isFor(root)) {
+    return;
+  }
+  clear();
+
+  bool seen[UCHAR_MAX + 1];
+  memset(seen, 0, sizeof(seen));
+  addArgp(root, root, -1, seen);
+
+  //-----------------------------------------------
+  // If present, these options always come last:
+  //-----------------------------------------------
+  setGroup("help", -1);
+  setGroup("version", -1);
+
+  std::vector<Entry> tmp(entries_.size());
+  sort(0, entries_.size(), tmp);
+  built_ = true;
+}
+//--------------------------------------------------------------------
+// The merge sort of qsort() in glibc. The comparison is not a strict
+// weak ordering in every case, so the result depends on the algorithm,
+// and the entries must be sorted exactly as glibc does it:
+//--------------------------------------------------------------------
+void HelpLayout::sort(size_t first, size_t n, std::vector<Entry> &tmp)
+{
+  if (n <= 1) {
+    return;
+  }
+  size_t n1 = n / 2;
+  size_t n2 = n - n1;
+  sort(first, n1, tmp);
+  sort(first + n1, n2, tmp);
+
+  size_t b1 = first;
+  size_t b2 = first + n1;
+  size_t k  = 0;
+  while (n1 > 0 && n2 > 0) {
+    if (compare(entries_[b1], entries_[b2]) <= 0) {
+      tmp[k++] = entries_[b1++];
+      --n1;
+    } else {
+      tmp[k++] = entries_[b2++];
+      --n2;
+    }
+  }
+  while (n1 > 0) {
+    tmp[k++] = entries_[b1++];
+    --n1;
+  }
+  std::copy(tmp.begin(), tmp.begin() + k, entries_.begin() + first);
+}
+//--------------------------------------------------------------------
+int HelpLayout::baseCluster(int cl) const
+{
+  while (clusters_[cl].parent_ >= 0) {
+    cl = clusters_[cl].parent_;
+  }
+  return cl;
+}
+//--------------------------------------------------------------------
+// Returns true if cl1 is cl2 or one of its descendants:
+//--------------------------------------------------------------------
+bool HelpLayout::isChildCluster(int cl1, int cl2) const
+{
+  while (cl1 >= 0 && cl1 != cl2) {
+    cl1 = clusters_[cl1].parent_;
+  }
+  return cl1 == cl2;
+}
+//--------------------------------------------------------------------
+// Compares two clusters at the same depth: first their parents, then
+// their groups, and then their positions among the children, the
+// later child coming first:
+//--------------------------------------------------------------------
+int HelpLayout::compareCousins(int cl1, int cl2) const
+{
+  const Cluster &c1 = clusters_[cl1];
+  const Cluster &c2 = clusters_[cl2];
+  if (c1.parent_ != c2.parent_) {
+    int cmp = compareCousins(c1.parent_, c2.parent_);
+    if (cmp != 0) {
+      return cmp;
+    }
+  }
+  int cmp = groupCmp(c1.group_, c2.group_);
+  if (cmp != 0) {
+    return cmp;
+  }
+  return c2.index_ - c1.index_;
+}
+//--------------------------------------------------------------------
+// Compares two clusters with the same base cluster; the options of a
+// cluster come before those of its sub-clusters:
+//--------------------------------------------------------------------
+int HelpLayout::compareClusters(int cl1, int cl2) const
+{
+  if (clusters_[cl1].depth_ > clusters_[cl2].depth_) {
+    do {
+      cl1 = clusters_[cl1].parent_;
+    } while (clusters_[cl1].depth_ > clusters_[cl2].depth_);
+    int cmp = compareCousins(cl1, cl2);
+    return cmp ? cmp : 1;
+  } else if (clusters_[cl1].depth_ < clusters_[cl2].depth_) {
+    do {
+      cl2 = clusters_[cl2].parent_;
+    } while (clusters_[cl1].depth_ < clusters_[cl2].depth_);
+    int cmp = compareCousins(cl1, cl2);
+    return cmp ? cmp : -1;
+  }
+  return compareCousins(cl1, cl2);
+}
+//--------------------------------------------------------------------
+// Returns the first short option of the entry which is shown, or 0:
+//--------------------------------------------------------------------
+char HelpLayout::firstShort(const Entry &e) const
+{
+  const char        *so  = short_options_.c_str() + e.so_;
+  const argp_option *opt = e.opt_;
+  for (unsigned n = e.num_; n > 0; --n, ++opt) {
+    if (oshort(opt) && *so == opt->key) {
+      if (ovisible(opt)) {
+        return static_cast<char>(opt->key);
+      }
+      ++so;
+    }
+  }
+  return 0;
+}
+//--------------------------------------------------------------------
+static const char *firstLong(const argp_option *opt, unsigned num)
+{
+  for (; num > 0; --num, ++opt) {
+    if (opt->name && ovisible(opt)) {
+      return opt->name;
+    }
+  }
+  return NULL;
+}
+//--------------------------------------------------------------------
+// The order of the entries in the help (hol_entry_cmp):
+//--------------------------------------------------------------------
+int HelpLayout::compare(const Entry &e1, const Entry &e2) const
+{
+  //-----------------------------------------------
+  // The groups first; for an entry in a cluster,
+  // the group of its base cluster:
+  //-----------------------------------------------
+  int group1 = (e1.cluster_ >= 0) ? clusters_[baseCluster(e1.cluster_)].group_ : e1.group_;
+  int group2 = (e2.cluster_ >= 0) ? clusters_[baseCluster(e2.cluster_)].group_ : e2.group_;
+  int cmp    = groupCmp(group1, group2);
+  if (cmp != 0) {
+    return cmp;
+  }
+
+  //-----------------------------------------------
+  // The entries outside of the clusters come first,
+  // then the clusters are compared, and then the
+  // groups within the same cluster:
+  //-----------------------------------------------
+  cmp = (e1.cluster_ >= 0) - (e2.cluster_ >= 0);
+  if (cmp != 0) {
+    return cmp;
+  }
+  if (e1.cluster_ >= 0) {
+    cmp = compareClusters(e1.cluster_, e2.cluster_);
+    if (cmp != 0) {
+      return cmp;
+    }
+  }
+  cmp = groupCmp(e1.group_, e2.group_);
+  if (cmp != 0) {
+    return cmp;
+  }
+
+  //-----------------------------------------------
+  // Documentation options come after the real ones,
+  // except for those which look like options:
+  //-----------------------------------------------
+  const char *long1 = firstLong(e1.opt_, e1.num_);
+  const char *long2 = firstLong(e2.opt_, e2.num_);
+  int doc1 = odoc(e1.opt_) ? (long1 != NULL && canonDocOption(&long1)) : 0;
+  int doc2 = odoc(e2.opt_) ? (long2 != NULL && canonDocOption(&long2)) : 0;
+  cmp = doc1 - doc2;
+  if (cmp != 0) {
+    return cmp;
+  }
+
+  //-----------------------------------------------
+  // Then the first characters of the names,
+  // ignoring the case, and lower case first:
+  //-----------------------------------------------
+  int short1 = firstShort(e1);
+  int short2 = firstShort(e2);
+  unsigned char first1 = short1 ? short1 : long1 != NULL ? *long1 : 0;
+  unsigned char first2 = short2 ? short2 : long2 != NULL ? *long2 : 0;
+  cmp = tolower(first1) - tolower(first2);
+  if (cmp != 0) {
+    return cmp;
+  }
+  cmp = first2 - first1;
+  if (cmp != 0) {
+    return cmp;
+  }
+
+  //-----------------------------------------------
+  // Entries without a short option come first and
+  // are compared by their long names:
+  //-----------------------------------------------
+  cmp = (short1 != 0) - (short2 != 0);
+  if (cmp != 0) {
+    return cmp;
+  }
+  if (short1 == 0) {
+    cmp = (long1 != NULL) - (long2 != NULL);
+    if (cmp != 0) {
+      return cmp;
+    }
+    if (long1 != NULL) {
+      return strcasecmp(long1, long2);
+    }
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------------
+static void indentTo(HelpStream &fs, unsigned col)
+{
+  int needed = static_cast<int>(col) - static_cast<int>(fs.point());
+  while (needed-- > 0) {
+    fs.putc(' ');
+  }
+}
+//--------------------------------------------------------------------
+// Prints a space, or a newline if ensure more characters would
+// not fit on the line:
+//--------------------------------------------------------------------
+static void space(HelpStream &fs, size_t ensure)
+{
+  if (fs.point() + ensure >= fs.rmargin()) {
+    fs.putc('\n');
+  } else {
+    fs.putc(' ');
+  }
+}
+//--------------------------------------------------------------------
+// Prints the argument of an option:
+//--------------------------------------------------------------------
+static void optionArg(const argp_option *real, const char *req_fmt, const char *opt_fmt
+                      , const char *domain, HelpStream &fs)
+{
+  if (real->arg) {
+    if (real->flags & OPTION_ARG_OPTIONAL) {
+      fs.printf(opt_fmt, domainText(domain, real->arg));
+    } else {
+      fs.printf(req_fmt, domainText(domain, real->arg));
+    }
+  }
+}
+//--------------------------------------------------------------------
+// Prints the header of a group or a cluster on a line by itself:
+//--------------------------------------------------------------------
+void HelpLayout::header(const char *str, const argp *ap, EntryState &pest) const
+{
+  const char *tstr = domainText(ap->argp_domain, str);
+  const char *fstr = filterDoc(tstr, ARGP_KEY_HELP_HEADER, ap, pest.state_);
+
+  if (fstr) {
+    if (*fstr) {
+      if (pest.hhstate_->prev_entry_) {
+        pest.stream_->putc('\n');
+      }
+      indentTo(*pest.stream_, params.header_col_);
+      pest.stream_->setLmargin(params.header_col_);
+      pest.stream_->setWmargin(params.header_col_);
+      pest.stream_->puts(fstr);
+      pest.stream_->setLmargin(0);
+      pest.stream_->putc('\n');
+    }
+    pest.hhstate_->sep_groups_ = true;
+  }
+  HelpLayout::releaseText(ap, fstr, tstr);
+}
+//--------------------------------------------------------------------
+// Separates the names of an entry with commas. Before the first one,
+// prints the blank line between groups and the header of the cluster
+// if they are due:
+//--------------------------------------------------------------------
+void HelpLayout::comma(unsigned col, EntryState &pest) const
+{
+  if (pest.first_) {
+    const Entry *pe = pest.hhstate_->prev_entry_;
+    int          cl = pest.entry_->cluster_;
+
+    if (pest.hhstate_->sep_groups_ && pe && pest.entry_->group_ != pe->group_) {
+      pest.stream_->putc('\n');
+    }
+    if (cl >= 0 && clusters_[cl].header_ && *clusters_[cl].header_
+        && (!pe || (pe->cluster_ != cl && !isChildCluster(pe->cluster_, cl)))) {
+      long old_wm = pest.stream_->wmargin();
+      header(clusters_[cl].header_
+             , clusters_[cl].argp_ ? clusters_[cl].argp_ : pest.root_, pest);
+      pest.stream_->setWmargin(old_wm);
+    }
+    pest.first_ = false;
+  } else {
+    pest.stream_->puts(", ");
+  }
+  indentTo(*pest.stream_, col);
+}
+//--------------------------------------------------------------------
+// Prints the help for one entry (hol_entry_help):
+//--------------------------------------------------------------------
+void HelpLayout::entryHelp(const Entry &e, const argp *root, const argp_state *state
+                           , HelpStream &fs, HelpState &hhstate) const
+{
+  const argp_option *real = e.opt_;
+  const argp_option *opt;
+  const argp        *ap   = e.argp_ ? e.argp_ : root;
+  const char        *so   = short_options_.c_str() + e.so_;
+  const char        *dom  = state ? state->root_argp->argp_domain : NULL;
+  unsigned           num;
+  bool               have_long_opt = false;
+  size_t             old_lm = fs.setLmargin(0);
+  long               old_wm = fs.wmargin();
+  EntryState         pest;
+
+  pest.entry_   = &e;
+  pest.stream_  = &fs;
+  pest.hhstate_ = &hhstate;
+  pest.root_    = root;
+  pest.first_   = true;
+  pest.state_   = state;
+
+  if (!odoc(real)) {
+    for (opt = real, num = e.num_; num > 0; ++opt, --num) {
+      if (opt->name && ovisible(opt)) {
+        have_long_opt = true;
+        break;
+      }
+    }
+  }
+
+  //-----------------------------------------------
+  // The short options first:
+  //-----------------------------------------------
+  fs.setWmargin(params.short_opt_col_);
+  for (opt = real, num = e.num_; num > 0; ++opt, --num) {
+    if (oshort(opt) && opt->key == *so) {
+      if (ovisible(opt)) {
+        comma(params.short_opt_col_, pest);
+        fs.putc('-');
+        fs.putc(*so);
+        if (!have_long_opt || params.dup_args_) {
+          optionArg(real, " %s", "[%s]", dom, fs);
+        } else if (real->arg) {
+          hhstate.suppressed_dup_arg_ = true;
+        }
+      }
+      ++so;
+    }
+  }
+
+  //-----------------------------------------------
+  // Then the long options:
+  //-----------------------------------------------
+  if (odoc(real)) {
+    fs.setWmargin(params.doc_opt_col_);
+    for (opt = real, num = e.num_; num > 0; ++opt, --num) {
+      if (opt->name && *opt->name && ovisible(opt)) {
+        comma(params.doc_opt_col_, pest);
+        fs.puts(domainText(dom, opt->name));
+      }
+    }
+  } else {
+    fs.setWmargin(params.long_opt_col_);
+    for (opt = real, num = e.num_; num > 0; ++opt, --num) {
+      if (opt->name && ovisible(opt)) {
+        comma(params.long_opt_col_, pest);
+        fs.printf("--%s", opt->name);
+        optionArg(real, "=%s", "[=%s]", dom, fs);
+      }
+    }
+  }
+
+  //-----------------------------------------------
+  // And the documentation:
+  //-----------------------------------------------
+  fs.setLmargin(0);
+
+  if (pest.first_) {
+    if (!oshort(real) && !real->name) {
+      //-------------------------------------------
+      // A group header:
+      //-------------------------------------------
+      header(real->doc, ap, pest);
+    } else {
+      //-------------------------------------------
+      // All of the names are hidden or shadowed:
+      //-------------------------------------------
+      fs.setLmargin(old_lm);
+      fs.setWmargin(old_wm);
+      return;
+    }
+  } else {
+    const char *tstr = real->doc ? domainText(dom, real->doc) : NULL;
+    const char *fstr = filterDoc(tstr, real->key, ap, state);
+    if (fstr && *fstr) {
+      unsigned col = static_cast<unsigned>(fs.point());
+
+      fs.setLmargin(params.opt_doc_col_);
+      fs.setWmargin(params.opt_doc_col_);
+
+      if (col > static_cast<unsigned>(params.opt_doc_col_ + 3)) {
+        fs.putc('\n');
+      } else if (col >= static_cast<unsigned>(params.opt_doc_col_)) {
+        fs.puts("   ");
+      } else {
+        indentTo(fs, params.opt_doc_col_);
+      }
+      fs.puts(fstr);
+    }
+    releaseText(ap, fstr, tstr);
+    fs.setLmargin(0);
+    fs.putc('\n');
+  }
+  hhstate.prev_entry_ = &e;
+
+  fs.setLmargin(old_lm);
+  fs.setWmargin(old_wm);
+}
+//--------------------------------------------------------------------
+// Prints the list of options (hol_help):
+//--------------------------------------------------------------------
+void HelpLayout::help(const argp *root, const argp_state *state
+                      , const std::vector<size_t> *selected, HelpStream &fs) const
+{
+  HelpState hhstate = { NULL, false, false };
+
+  if (selected) {
+    for (size_t i = 0; i < selected->size(); ++i) {
+      entryHelp(entries_[(*selected)[i]], root, state, fs, hhstate);
+    }
+  } else {
+    for (size_t i = 0; i < entries_.size(); ++i) {
+      entryHelp(entries_[i], root, state, fs, hhstate);
+    }
+  }
+
+  if (hhstate.suppressed_dup_arg_ && params.dup_args_note_) {
+    const char *tstr = domainText(rootDomain(state)
+        , "Mandatory or optional arguments to long options are also mandatory or "
+          "optional for any corresponding short options.");
+    const char *fstr = filterDoc(tstr, ARGP_KEY_HELP_DUP_ARGS_NOTE
+                                 , state ? state->root_argp : NULL, state);
+    if (fstr && *fstr) {
+      fs.putc('\n');
+      fs.puts(fstr);
+      fs.putc('\n');
+    }
+    releaseText(state ? state->root_argp : NULL, fstr, tstr);
+  }
+}
+//--------------------------------------------------------------------
+// Prints the options in the usage text (hol_usage): first the short
+// options without arguments, then those with arguments, and then
+// the long options:
+//--------------------------------------------------------------------
+void HelpLayout::usage(const argp *root, HelpStream &fs) const
+{
+  if (entries_.empty()) {
+    return;
+  }
+  std::string no_arg;
+
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    const Entry       &e    = entries_[i];
+    const argp_option *real = e.opt_;
+    const argp_option *opt  = real;
+    const char        *so   = short_options_.c_str() + e.so_;
+    for (unsigned n = e.num_; n > 0; --n, ++opt) {
+      if (oshort(opt) && *so == opt->key) {
+        if (!oalias(opt)) {
+          real = opt;
+        }
+        if (ovisible(opt)
+            && !(opt->arg || real->arg)
+            && !((opt->flags | real->flags) & OPTION_NO_USAGE)) {
+          no_arg += static_cast<char>(opt->key);
+        }
+        ++so;
+      }
+    }
+  }
+  if (!no_arg.empty()) {
+    fs.printf(" [-%s]", no_arg.c_str());
+  }
+
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    const Entry       &e    = entries_[i];
+    const argp_option *real = e.opt_;
+    const argp_option *opt  = real;
+    const char        *so   = short_options_.c_str() + e.so_;
+    const char        *dom  = (e.argp_ ? e.argp_ : root)->argp_domain;
+    for (unsigned n = e.num_; n > 0; --n, ++opt) {
+      if (oshort(opt) && *so == opt->key) {
+        if (!oalias(opt)) {
+          real = opt;
+        }
+        if (ovisible(opt)) {
+          const char *arg   = opt->arg ? opt->arg : real->arg;
+          int         flags = opt->flags | real->flags;
+          if (arg && !(flags & OPTION_NO_USAGE)) {
+            arg = domainText(dom, arg);
+            if (flags & OPTION_ARG_OPTIONAL) {
+              fs.printf(" [-%c[%s]]", opt->key, arg);
+            } else {
+              //---------------------------------------
+              // Wrap the line here so that it is not
+              // wrapped at the space in the middle:
+              //---------------------------------------
+              space(fs, 6 + strlen(arg));
+              fs.printf("[-%c %s]", opt->key, arg);
+            }
+          }
+        }
+        ++so;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    const Entry       &e    = entries_[i];
+    const argp_option *real = e.opt_;
+    const argp_option *opt  = real;
+    const char        *dom  = (e.argp_ ? e.argp_ : root)->argp_domain;
+    for (unsigned n = e.num_; n > 0; --n, ++opt) {
+      if (opt->name) {
+        if (!oalias(opt)) {
+          real = opt;
+        }
+        if (ovisible(opt)) {
+          const char *arg   = opt->arg;
+          int         flags = opt->flags | real->flags;
+          if (!arg && !(flags & OPTION_NO_USAGE)) {
+            arg = real->arg;
+          }
+          if (!(flags & OPTION_NO_USAGE)) {
+            if (arg) {
+              arg = domainText(dom, arg);
+              if (flags & OPTION_ARG_OPTIONAL) {
+                fs.printf(" [--%s[=%s]]", opt->name, arg);
+              } else {
+                fs.printf(" [--%s=%s]", opt->name, arg);
+              }
+            } else {
+              fs.printf(" [--%s]", opt->name);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+//--------------------------------------------------------------------
+// Returns the number of args_doc strings with more than one line in
+// the tree of ap, i.e. of the alternatives of the usage text:
+//--------------------------------------------------------------------
+static size_t argsLevels(const argp *ap)
+{
+  size_t levels = 0;
+  if (ap->args_doc && strchr(ap->args_doc, '\n')) {
+    ++levels;
+  }
+  if (ap->children) {
+    for (const argp_child *child = ap->children; child->argp; ++child) {
+      levels += argsLevels(child->argp);
+    }
+  }
+  return levels;
+}
+//--------------------------------------------------------------------
+// Prints the non-option arguments of the tree of ap for the current
+// alternative, and advances to the next one (argp_args_usage). Returns
+// true as long as there are more alternatives:
+//--------------------------------------------------------------------
+static bool argsUsage(const argp *ap, const argp_state *state
+                      , char *&levels, bool advance, HelpStream &fs)
+{
+  char       *our_level = levels;
+  bool        multiple  = false;
+  const char *tdoc      = domainText(ap->argp_domain, ap->args_doc);
+  const char *fdoc      = filterDoc(tdoc, ARGP_KEY_HELP_ARGS_DOC, ap, state);
+  const char *nl        = NULL;
+  bool        more      = false;
+
+  if (fdoc) {
+    const char *cp = fdoc;
+    nl = cp + strcspn(cp, "\n");
+    if (*nl != '\0') {
+      multiple = true;
+      //-----------------------------------------------
+      // argp goes past the end of the text if the help
+      // filter returned fewer lines than last time:
+      //-----------------------------------------------
+      for (int i = 0; i < *our_level && *nl != '\0'; ++i) {
+        cp = nl + 1;
+        nl = cp + strcspn(cp, "\n");
+      }
+      ++levels;
+    }
+    space(fs, 1 + nl - cp);
+    fs.write(cp, nl - cp);
+    more = (*nl != '\0');
+  }
+  HelpLayout::releaseText(ap, fdoc, tdoc);
+
+  if (ap->children) {
+    for (const argp_child *child = ap->children; child->argp; ++child) {
+      advance = !argsUsage(child->argp, state, levels, advance, fs);
+    }
+  }
+
+  if (advance && multiple) {
+    if (more) {
+      ++*our_level;
+      advance = false;
+    } else if (*our_level > 0) {
+      *our_level = 0;
+    }
+  }
+  return !advance;
+}
+//--------------------------------------------------------------------
+// Prints the doc strings of the tree of ap: the parts before the '\v'
+// if post is false, otherwise the parts after it (argp_doc). Returns
+// true if anything was printed:
+//--------------------------------------------------------------------
+static bool argpDoc(const argp *ap, const argp_state *state
+                    , bool post, bool pre_blank, bool first_only, HelpStream &fs)
+{
+  const char  *text;
+  const char  *inp_text;
+  size_t       inp_text_limit = 0;
+  void        *input    = NULL;
+  bool         anything = false;
+  const char  *doc      = domainText(ap->argp_domain, ap->doc);
+  std::string  copy;
+
+  if (doc) {
+    const char *vt = strchr(doc, '\v');
+    inp_text       = post ? (vt ? vt + 1 : NULL) : doc;
+    inp_text_limit = (!post && vt) ? static_cast<size_t>(vt - doc) : 0;
+  } else {
+    inp_text = NULL;
+  }
+
+  if (ap->help_filter) {
+    if (inp_text_limit) {
+      copy.assign(inp_text, inp_text_limit);
+      inp_text = copy.c_str();
+    }
+    input = HelpLayout::argpInput(ap, state);
+    text  = HelpLayout::filterText(ap, post ? ARGP_KEY_HELP_POST_DOC : ARGP_KEY_HELP_PRE_DOC
+                                   , inp_text, input);
+  } else {
+    text = inp_text;
+  }
+
+  if (text) {
+    if (pre_blank) {
+      fs.putc('\n');
+    }
+    if (text == inp_text && inp_text_limit) {
+      fs.write(inp_text, inp_text_limit);
+    } else {
+      fs.puts(text);
+    }
+    if (fs.point() > fs.lmargin()) {
+      fs.putc('\n');
+    }
+    anything = true;
+  }
+  if (ap->help_filter) {
+    HelpLayout::releaseText(ap, text, inp_text);
+  }
+
+  if (post && ap->help_filter) {
+    text = HelpLayout::filterText(ap, ARGP_KEY_HELP_EXTRA, NULL, input);
+    if (text) {
+      if (anything || pre_blank) {
+        fs.putc('\n');
+      }
+      fs.puts(text);
+      HelpLayout::releaseText(ap, text, NULL);
+      if (fs.point() > fs.lmargin()) {
+        fs.putc('\n');
+      }
+      anything = true;
+    }
+  }
+
+  if (ap->children) {
+    for (const argp_child *child = ap->children; child->argp && !(first_only && anything); ++child) {
+      anything |= argpDoc(child->argp, state, post, anything || pre_blank, first_only, fs);
+    }
+  }
+  return anything;
+}
+//--------------------------------------------------------------------
+// Formats the help as _help() in argp-help.c does:
+//--------------------------------------------------------------------
+void HelpLayout::render(const argp *root, const argp_state *state, unsigned flags
+                        , const char *name, std::string &out) const
+{
+  bool anything = false;
+
+  if (!params.valid_) {
+    fillInParams(state);
+  }
+
+  HelpStream fs(out, 0, params.rmargin_, 0);
+
+  if (flags & (ARGP_HELP_USAGE | ARGP_HELP_SHORT_USAGE)) {
+    //-----------------------------------------------
+    // One "Usage:" line for each alternative of the
+    // args_doc strings:
+    //-----------------------------------------------
+    bool              first_pattern = true;
+    bool              more_patterns;
+    std::vector<char> pattern_levels(argsLevels(root) + 1, 0);
+
+    do {
+      long  old_wm = fs.setWmargin(params.usage_indent_);
+      char *levels = &pattern_levels[0];
+
+      fs.printf("%s %s"
+                , domainText(root->argp_domain, first_pattern ? "Usage:" : "  or: ")
+                , name);
+
+      //-------------------------------------------
+      // The left margin is set as well, since the
+      // usage of the options is wrapped by hand:
+      //-------------------------------------------
+      size_t old_lm = fs.setLmargin(params.usage_indent_);
+
+      if (flags & ARGP_HELP_SHORT_USAGE) {
+        if (!entries_.empty()) {
+          fs.puts(domainText(root->argp_domain, " [OPTION...]"));
+        }
+      } else {
+        usage(root, fs);
+        flags |= ARGP_HELP_SHORT_USAGE;
+      }
+
+      more_patterns = argsUsage(root, state, levels, true, fs);
+
+      fs.setWmargin(old_wm);
+      fs.setLmargin(old_lm);
+      fs.putc('\n');
+      anything = true;
+
+      first_pattern = false;
+    } while (more_patterns);
+  }
+
+  if (flags & ARGP_HELP_PRE_DOC) {
+    anything |= argpDoc(root, state, false, false, true, fs);
+  }
+
+  if (flags & ARGP_HELP_SEE) {
+    fs.printf(domainText(root->argp_domain
+                         , "Try `%s --help' or `%s --usage' for more information.\n")
+              , name, name);
+    anything = true;
+  }
+
+  if (flags & ARGP_HELP_LONG) {
+    if (!entries_.empty()) {
+      if (anything) {
+        fs.putc('\n');
+      }
+      help(root, state, NULL, fs);
+      anything = true;
+    }
+  }
+
+  if (flags & ARGP_HELP_POST_DOC) {
+    anything |= argpDoc(root, state, true, anything, false, fs);
+  }
+
+  if ((flags & ARGP_HELP_BUG_ADDR) && argp_program_bug_address) {
+    if (anything) {
+      fs.putc('\n');
+    }
+    fs.printf(domainText(root->argp_domain, "Report bugs to %s.\n"), argp_program_bug_address);
+  }
+}
+
+//--------------------------------------------------------------------
+bool HelpLayout::TextKey::operator<(const TextKey &other) const
+{
+  if (flags_ != other.flags_) {
+    return flags_ < other.flags_;
+  }
+  if (has_inputs_ != other.has_inputs_) {
+    return !has_inputs_;
+  }
+  int cmp = name_.compare(other.name_);
+  if (cmp == 0) {
+    cmp = bug_address_.compare(other.bug_address_);
+  }
+  if (cmp == 0) {
+    cmp = help_fmt_.compare(other.help_fmt_);
+  }
+  if (cmp == 0) {
+    cmp = messages_.compare(other.messages_);
+  }
+  return cmp < 0;
+}
+//--------------------------------------------------------------------
+// Appends what the translations of the messages depend on to out:
+//--------------------------------------------------------------------
+static void messagesKey(std::string &out)
+{
+#if defined(__GLIBC__) && defined(LC_MESSAGES)
+  const char *loc = setlocale(LC_MESSAGES, NULL);
+  out += loc ? loc : "";
+  out += '\n';
+  const char *language = getenv("LANGUAGE");
+  out += language ? language : "";
+  out += '\n';
+  const char *domain = textdomain(NULL);
+  out += domain ? domain : "";
+#else
+  (void)out;
+#endif
+}
+//--------------------------------------------------------------------
+const std::string &HelpLayout::text(const argp *root, const argp_state *state, unsigned flags
+                                    , const char *name) const
+{
+  //-----------------------------------------------
+  // The exit flags don't change the text:
+  //-----------------------------------------------
+  TextKey key;
+  key.flags_      = flags & ~(ARGP_HELP_EXIT_ERR | ARGP_HELP_EXIT_OK);
+  key.has_inputs_ = state != NULL;
+  key.name_       = name ? name : "";
+  if ((flags & ARGP_HELP_BUG_ADDR) && argp_program_bug_address) {
+    key.bug_address_ = argp_program_bug_address;
+  }
+  const char *help_fmt = getenv("ARGP_HELP_FMT");
+  if (help_fmt) {
+    key.help_fmt_ = help_fmt;
+  }
+  messagesKey(key.messages_);
+
+  {
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+#endif
+    TextCache::const_iterator cit = texts_.find(key);
+    if (cit != texts_.end()) {
+      return cit->second;
+    }
+  }
+
+  //-----------------------------------------------
+  // Formatted without holding the lock, since the
+  // help filters may be slow. If another thread
+  // got there first, its text is the same:
+  //-----------------------------------------------
+  std::string out;
+  render(root, state, key.flags_, name, out);
+
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+#endif
+  std::pair<TextCache::iterator, bool> ins = texts_.insert(std::make_pair(key, std::string()));
+  if (ins.second) {
+    ins.first->second.swap(out);
+  }
+  return ins.first->second;
+}
+
+//--------------------------------------------------------------------
+// Adds the words of str for the entry with the given index: the runs
+// of letters and digits, in lower case, and if whole is set, all of
+// str as well, so that a pattern with a '-' matches a long name:
+//--------------------------------------------------------------------
+static void addWords(const char *str, size_t entry, bool whole
+                     , std::vector<std::pair<std::string, size_t> > &words)
+{
+  std::string word;
+
+  if (whole) {
+    for (const char *p = str; *p; ++p) {
+      word += static_cast<char>(tolower(static_cast<unsigned char>(*p)));
+    }
+    words.push_back(std::make_pair(word, entry));
+    word.clear();
+  }
+  for (const char *p = str; ; ++p) {
+    unsigned char c = static_cast<unsigned char>(*p);
+    if (c && isalnum(c)) {
+      word += static_cast<char>(tolower(c));
+      continue;
+    }
+    if (!word.empty()) {
+      words.push_back(std::make_pair(word, entry));
+      word.clear();
+    }
+    if (!c) {
+      break;
+    }
+  }
+}
+//--------------------------------------------------------------------
+void HelpLayout::buildIndex() const
+{
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    const Entry       &e = entries_[i];
+    const argp_option *o = e.opt_;
+
+    bool visible = false;
+    for (unsigned n = 0; n < e.num_; ++n, ++o) {
+      if (!ovisible(o)) {
+        continue;
+      }
+      visible = true;
+      if (o->name) {
+        addWords(o->name, i, !odoc(o), words_);
+      }
+      if (o->doc) {
+        addWords(o->doc, i, false, words_);
+      }
+    }
+    //-----------------------------------------------
+    // An entry of hidden options, such as those of
+    // --help-group itself, is not in any group:
+    //-----------------------------------------------
+    if (visible) {
+      groups_.push_back(GroupIndex(e.group_, i));
+    }
+  }
+  std::sort(words_.begin(), words_.end());
+  words_.erase(std::unique(words_.begin(), words_.end()), words_.end());
+  std::sort(groups_.begin(), groups_.end());
+  indexed_ = true;
+}
+//--------------------------------------------------------------------
+// Puts the indexes of the entries which match search into selected,
+// in the order of entries_. A pattern matches the words which begin
+// with it, ignoring case and the dashes in front of it:
+//--------------------------------------------------------------------
+void HelpLayout::findMatches(const HelpSearch &search, std::vector<size_t> &selected) const
+{
+  if (search.pattern_) {
+    std::string pat;
+    const char *p = search.pattern_;
+    while (*p == '-') {
+      ++p;
+    }
+    for (; *p; ++p) {
+      pat += static_cast<char>(tolower(static_cast<unsigned char>(*p)));
+    }
+    std::vector<WordIndex>::const_iterator cit
+        = std::lower_bound(words_.begin(), words_.end(), WordIndex(pat, 0));
+    for (; cit != words_.end() && cit->first.compare(0, pat.size(), pat) == 0; ++cit) {
+      selected.push_back(cit->second);
+    }
+  } else {
+    std::vector<GroupIndex>::const_iterator cit
+        = std::lower_bound(groups_.begin(), groups_.end(), GroupIndex(search.group_, 0));
+    for (; cit != groups_.end() && cit->first == search.group_; ++cit) {
+      selected.push_back(cit->second);
+    }
+  }
+  std::sort(selected.begin(), selected.end());
+  selected.erase(std::unique(selected.begin(), selected.end()), selected.end());
+}
+//--------------------------------------------------------------------
+bool HelpLayout::renderMatches(const argp *root, const argp_state *state
+                               , const HelpSearch &search, std::string &out) const
+{
+  std::vector<size_t> selected;
+  {
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+#endif
+    if (!indexed_) {
+      buildIndex();
+    }
+    findMatches(search, selected);
+  }
+  if (selected.empty()) {
+    return false;
+  }
+
+  if (!params.valid_) {
+    fillInParams(state);
+  }
+  HelpStream fs(out, 0, params.rmargin_, 0);
+  help(root, state, &selected, fs);
+  return true;
+}
+
+//--------------------------------------------------------------------
+// The table installed by ArgppBase::installPrebuiltHelp(), which is
+// shared by all threads, like the global variables of argp:
+//--------------------------------------------------------------------
+static const ArgppPrebuiltHelp *prebuilt_help     = NULL;
+static size_t                   num_prebuilt_help = 0;
+
+//--------------------------------------------------------------------
+// The texts which ArgppBase::writePrebuiltHelp() writes: those of
+// --help, --usage, argp_usage() and argp_error():
+//--------------------------------------------------------------------
+static const unsigned PREBUILT_FLAGS[] = {
+  ARGP_HELP_STD_HELP  & ~ARGP_HELP_EXIT_OK,
+  ARGP_HELP_USAGE,
+  ARGP_HELP_STD_USAGE & ~ARGP_HELP_EXIT_ERR,
+  ARGP_HELP_STD_ERR   & ~ARGP_HELP_EXIT_ERR
+};
+
+//--------------------------------------------------------------------
+// FNV-1a over everything a help text is formatted from, apart from the
+// program name and the flags:
+//--------------------------------------------------------------------
+class HelpFingerprint
+{
+  public:
+    HelpFingerprint()
+      : hash_ (14695981039346656037ULL)
+    {}
+    void add(const void *data, size_t size)
+    {
+      const unsigned char *p = static_cast<const unsigned char*>(data);
+      for (size_t i=0; i<size; ++i) {
+        hash_ ^= p[i];
+        hash_ *= 1099511628211ULL;
+      }
+    }
+    void add(int val)
+    {
+      add(&val, sizeof(val));
+    }
+    ///
+    /// @brief NULL and "" are told apart.
+    ///
+    void add(const char *str)
+    {
+      add(str ? 1 : 0);
+      if (str) {
+        add(str, strlen(str) + 1);
+      }
+    }
+    ///
+    /// @brief Adds ap and its children in pre-order; returns false if one of
+    /// them has a help filter, since its texts can't be known in advance.
+    ///
+    bool addArgp(const argp *ap)
+    {
+      if (ap->help_filter) {
+        return false;
+      }
+      add(ap->args_doc);
+      add(ap->doc);
+      add(ap->argp_domain);
+      if (ap->options) {
+        for (const argp_option *o = ap->options; !oend(o); ++o) {
+          add(o->name);
+          add(o->key);
+          add(o->arg);
+          add(o->flags);
+          add(o->doc);
+          add(o->group);
+        }
+      }
+      add(-1);
+      if (ap->children) {
+        for (const argp_child *c = ap->children; c->argp; ++c) {
+          add(c->flags);
+          add(c->header);
+          add(c->group);
+          if (!addArgp(c->argp)) {
+            return false;
+          }
+        }
+      }
+      add(-1);
+      return true;
+    }
+    void addParams()
+    {
+      add(params.dup_args_);
+      add(params.dup_args_note_);
+      add(params.short_opt_col_);
+      add(params.long_opt_col_);
+      add(params.doc_opt_col_);
+      add(params.opt_doc_col_);
+      add(params.header_col_);
+      add(params.usage_indent_);
+      add(params.rmargin_);
+      add(argp_program_bug_address);
+    }
+    unsigned long long value() const { return hash_; }
+
+  private:
+    unsigned long long hash_;
+};
+
+//--------------------------------------------------------------------
+// Returns false if the texts of the tree of root can't be prebuilt:
+//--------------------------------------------------------------------
+static bool helpFingerprint(const argp *root, const argp_state *state
+                            , unsigned long long &value)
+{
+  if (!params.valid_) {
+    fillInParams(state);
+  }
+  HelpFingerprint fp;
+  if (!fp.addArgp(root)) {
+    return false;
+  }
+  fp.addParams();
+  value = fp.value();
+  return true;
+}
+//--------------------------------------------------------------------
+bool HelpLayout::fingerprint(const argp *root, const argp_state *state
+                             , unsigned long long &value) const
+{
+  const char *bug_address = argp_program_bug_address ? argp_program_bug_address : "";
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+  std::lock_guard<std::mutex> lock(cache_mutex_);
+#endif
+  size_t pos = 0;
+  if (fp_status_ < 0 || !keyMatches(root, fp_key_, pos) || pos != fp_key_.size()
+      || fp_bug_address_ != bug_address) {
+    fp_key_.clear();
+    addKey(root, fp_key_);
+    fp_bug_address_ = bug_address;
+    fp_status_      = helpFingerprint(root, state, fp_) ? 1 : 0;
+  }
+  value = fp_;
+  return fp_status_ > 0;
+}
+
+//--------------------------------------------------------------------
+// The prebuilt texts are not translated:
+//--------------------------------------------------------------------
+static bool translating()
+{
+#if defined(__GLIBC__) && defined(LC_MESSAGES)
+  const char *loc = setlocale(LC_MESSAGES, NULL);
+  return loc && strcmp(loc, "C") != 0 && strcmp(loc, "POSIX") != 0;
+#else
+  return false;
+#endif
+}
+
+//--------------------------------------------------------------------
+// The prebuilt text which can be written instead of formatting the
+// help of state with flags, or NULL:
+//--------------------------------------------------------------------
+static const ArgppPrebuiltHelp *findPrebuilt(const argp_state *state, unsigned flags)
+{
+  if (!prebuilt_help) {
+    return NULL;
+  }
+  flags &= ~(ARGP_HELP_EXIT_ERR | ARGP_HELP_EXIT_OK);
+  const char *name = state->name ? state->name : "";
+
+  const ArgppPrebuiltHelp *found = NULL;
+  for (size_t i=0; i<num_prebuilt_help && !found; ++i) {
+    const ArgppPrebuiltHelp &ph = prebuilt_help[i];
+    if (ph.flags_ == flags && ph.name_ && strcmp(ph.name_, name) == 0) {
+      found = &ph;
+    }
+  }
+  if (!found || translating()) {
+    return NULL;
+  }
+  //-----------------------------------------------
+  // The fingerprint is kept with the layout, which
+  // need not have been built:
+  //-----------------------------------------------
+  ParseContext      &ctx    = ParseContext::of(state);
+  const argp        *root   = state->root_argp;
+  const HelpLayout  &layout = (ctx.plan_ && ctx.plan_->helpLayout().isFor(root))
+                              ? ctx.plan_->helpLayout() : ctx.help_layout_;
+  unsigned long long fp     = 0;
+  if (!layout.fingerprint(root, state, fp) || fp != found->fingerprint_) {
+    return NULL;
+  }
+  return found;
+}
+
+//--------------------------------------------------------------------
+// Writes str as a C string literal, broken into one literal per line:
+//--------------------------------------------------------------------
+static void writeLiteral(FILE *out, const std::string &str, const char *indent)
+{
+  fputc('"', out);
+  for (size_t i=0; i<str.size(); ++i) {
+    unsigned char c = static_cast<unsigned char>(str[i]);
+    switch (c) {
+      case '\\': fputs("\\\\", out); break;
+      case '"':  fputs("\\\"", out); break;
+      // not to make trigraphs:
+      case '?':  fputs("\\?", out);  break;
+      case '\t': fputs("\\t", out);  break;
+      case '\n':
+        fputs("\\n\"", out);
+        if (i + 1 < str.size()) {
+          fprintf(out, "\n%s\"", indent);
+        }
+        break;
+      default:
+        if (c < 0x20 || c >= 0x7f) {
+          fprintf(out, "\\%03o", c);
+        } else {
+          fputc(c, out);
+        }
+        break;
+    }
+  }
+  if (str.empty() || str[str.size() - 1] != '\n') {
+    fputc('"', out);
+  }
+}
+
+//--------------------------------------------------------------------
+// Free functions:
+//--------------------------------------------------------------------
+
+//--------------------------------------------------------------------
+// The layout of the plan being parsed, or that of the tree.
+// The layout is built even if the flags of the help don't need the
+// options, since it keeps the text:
+//--------------------------------------------------------------------
+static const HelpLayout &layoutFor(const argp_state *state)
+{
+  ParseContext &ctx  = ParseContext::of(state);
+  const argp   *root = state->root_argp;
+
+  if (ctx.plan_ && ctx.plan_->helpLayout().isFor(root)) {
+    return ctx.plan_->helpLayout();
+  }
+  ctx.help_layout_.build(root);
+  return ctx.help_layout_;
+}
+//--------------------------------------------------------------------
+static const std::string &helpText(const argp_state *state, unsigned flags)
+{
+  return layoutFor(state).text(state->root_argp, state, flags, state->name);
+}
+//--------------------------------------------------------------------
+void renderHelp(const argp_state *state, FILE *stream, unsigned flags)
+{
+  if (!state || (state->flags & ARGP_NO_ERRS) || !stream || !state->root_argp) {
+    return;
+  }
+  if (const ArgppPrebuiltHelp *ph = findPrebuilt(state, flags)) {
+    fwrite(ph->text_, 1, ph->size_, stream);
+    return;
+  }
+  const std::string &text = helpText(state, flags);
+  fwrite(text.data(), 1, text.size(), stream);
+}
+//--------------------------------------------------------------------
+void formatHelp(const argp_state *state, unsigned flags, std::string &out)
+{
+  if (state && state->root_argp) {
+    if (const ArgppPrebuiltHelp *ph = findPrebuilt(state, flags)) {
+      out.append(ph->text_, ph->size_);
+    } else {
+      out += helpText(state, flags);
+    }
+  }
+}
+//--------------------------------------------------------------------
+bool isHelpSearch(const char *arg)
+{
+  return strncmp(arg, "--help=", 7) == 0
+      || strncmp(arg, "--help-group=", 13) == 0
+      || strcmp(arg, "--help-group") == 0;
+}
+//--------------------------------------------------------------------
+bool makeHelpSearch(const char *arg, bool group, HelpSearch &search)
+{
+  search.pattern_ = NULL;
+  search.group_   = 0;
+  if (!group) {
+    search.pattern_ = arg;
+    return true;
+  }
+  char *end = NULL;
+  long  n   = strtol(arg, &end, 10);
+  if (end == arg || *end || n < INT_MIN || n > INT_MAX) {
+    return false;
+  }
+  search.group_ = static_cast<int>(n);
+  return true;
+}
+//--------------------------------------------------------------------
+bool renderHelpSearch(const argp_state *state, FILE *stream, const HelpSearch &search)
+{
+  if (!state || !state->root_argp) {
+    return false;
+  }
+  std::string text;
+  if (!layoutFor(state).renderMatches(state->root_argp, state, search, text)) {
+    return false;
+  }
+  if (!(state->flags & ARGP_NO_ERRS) && stream) {
+    fwrite(text.data(), 1, text.size(), stream);
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------
+void installPrebuiltHelp(const ArgppPrebuiltHelp *help, size_t n)
+{
+  prebuilt_help     = n ? help : NULL;
+  num_prebuilt_help = help ? n : 0;
+}
+//--------------------------------------------------------------------
+bool writePrebuiltHelp(FILE *out, const char *identifier, const argp *root
+                       , const char *name)
+{
+  unsigned long long fp = 0;
+  if (!out || !helpFingerprint(root, NULL, fp)) {
+    return false;
+  }
+  HelpLayout layout;
+  layout.build(root);
+
+  fprintf(out, "// Generated by argpp::ArgppBase::writePrebuiltHelp(); do not edit.\n");
+  fprintf(out, "static const argpp::ArgppPrebuiltHelp %s[] = {\n", identifier);
+  for (size_t i=0; i<sizeof(PREBUILT_FLAGS)/sizeof(PREBUILT_FLAGS[0]); ++i) {
+    std::string text;
+    layout.render(root, NULL, PREBUILT_FLAGS[i], name, text);
+
+    fprintf(out, "  { 0x%xu, 0x%llxULL, ", PREBUILT_FLAGS[i], fp);
+    writeLiteral(out, name, "");
+    fputs(",\n    ", out);
+    writeLiteral(out, text, "    ");
+    fprintf(out, ",\n    %lu }%s\n", static_cast<unsigned long>(text.size())
+            , (i + 1 < sizeof(PREBUILT_FLAGS)/sizeof(PREBUILT_FLAGS[0])) ? "," : "");
+  }
+  fputs("};\n", out);
+  return !ferror(out);
+}
+
+} // namespace impl
+} // namespace argpp
@@ -0,0 +1,144 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+#include <algorithm>
+#include <cstring>
+#include "argppmulticall.hpp"
+#include "argppbaseimpl.hpp"
+
+namespace argpp {
+  namespace impl {
+
+//--------------------------------------------------------------------
+// Orders the applets by name:
+//--------------------------------------------------------------------
+static bool appletLess(const ArgppApplet &a, const ArgppApplet &b)
+{
+  return strcmp(a.name_, b.name_) < 0;
+}
+//--------------------------------------------------------------------
+static bool appletNameLess(const ArgppApplet &a, const char *name)
+{
+  return strcmp(a.name_, name) < 0;
+}
+//--------------------------------------------------------------------
+static bool sameName(const ArgppApplet &a, const ArgppApplet &b)
+{
+  return strcmp(a.name_, b.name_) == 0;
+}
+
+//--------------------------------------------------------------------
+// ArgppMultiCallImpl:
+//--------------------------------------------------------------------
+ArgppMultiCallImpl::ArgppMultiCallImpl()
+  : applets_ ()
+  , strings_ ()
+{}
+//--------------------------------------------------------------------
+void ArgppMultiCallImpl::addTable(const ArgppApplet *applets, size_t count)
+{
+  applets_.reserve(applets_.size() + count);
+  for (size_t i=0; i<count; ++i) {
+    if (applets[i].name_ && *applets[i].name_ && applets[i].factory_) {
+      applets_.push_back(applets[i]);
+    }
+  }
+  //---------------------------------------------------
+  // A stable sort keeps the first of several applets
+  // with the same name in front, and unique() keeps
+  // only that one:
+  //---------------------------------------------------
+  std::stable_sort(applets_.begin(), applets_.end(), appletLess);
+  applets_.erase(std::unique(applets_.begin(), applets_.end(), sameName), applets_.end());
+}
+//--------------------------------------------------------------------
+bool ArgppMultiCallImpl::addApplet(const std::string &name
+                                   , AppletFactory factory
+                                   , const std::string &doc)
+{
+  if (name.empty() || !factory || findApplet(name.c_str())) {
+    return false;
+  }
+  ArgppApplet a;
+  a.name_    = copyString(name);
+  a.factory_ = factory;
+  a.doc_     = doc.empty() ? NULL : copyString(doc);
+  applets_.insert(std::lower_bound(applets_.begin(), applets_.end(), a, appletLess), a);
+  return true;
+}
+//--------------------------------------------------------------------
+const ArgppApplet *ArgppMultiCallImpl::findApplet(const char *name) const
+{
+  if (!name) {
+    return NULL;
+  }
+  std::vector<ArgppApplet>::const_iterator cit
+      = std::lower_bound(applets_.begin(), applets_.end(), name, appletNameLess);
+  if (cit != applets_.end() && strcmp(cit->name_, name) == 0) {
+    return &*cit;
+  }
+  return NULL;
+}
+//--------------------------------------------------------------------
+ArgppBase *ArgppMultiCallImpl::createParser(int argc, char **argv) const
+{
+  if (argc < 1 || !argv || !argv[0]) {
+    return NULL;
+  }
+  std::string buf;
+  const ArgppApplet *a = findApplet(appletName(argv[0], buf));
+  if (a) {
+    return a->factory_(argc, argv);
+  }
+  //---------------------------------------------------
+  // Called by its own name, as in "prog applet ...":
+  //---------------------------------------------------
+  if (argc > 1 && (a = findApplet(argv[1])) != NULL) {
+    return a->factory_(argc - 1, argv + 1);
+  }
+  return NULL;
+}
+//--------------------------------------------------------------------
+const char *ArgppMultiCallImpl::appletName(const char *argv0, std::string &buf)
+{
+  const char *name = ArgppBaseImpl::baseName(argv0);
+#ifdef _WIN32
+  size_t len = strlen(name);
+  if (len > 4 && (_stricmp(name + len - 4, ".exe") == 0)) {
+    buf.assign(name, len - 4);
+    name = buf.c_str();
+  }
+#else
+  (void)buf;
+#endif
+  return name;
+}
+//--------------------------------------------------------------------
+const char *ArgppMultiCallImpl::copyString(const std::string &s)
+{
+  char *retval = static_cast<char*>(strings_.allocate(s.size() + 1));
+  memcpy(retval, s.c_str(), s.size() + 1);
+  return retval;
+}
+
+} // namespace impl
+} // namespace argpp
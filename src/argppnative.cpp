@@ -0,0 +1,1340 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#ifdef __GLIBC__
+#  include <libintl.h>
+#endif
+#include "argppnative.hpp"
+
+namespace argpp {
+  namespace impl {
+
+//--------------------------------------------------------------------
+// The keys of the hidden default options, as in argp-parse.c:
+//--------------------------------------------------------------------
+static const int OPT_PROGNAME = -2;
+static const int OPT_USAGE    = -3;
+static const int OPT_HANG     = -4;
+
+//--------------------------------------------------------------------
+// argp reserves the high 8 bits of the keys of long options to
+// encode the group number:
+//--------------------------------------------------------------------
+static const int USER_BITS = 24;
+static const int USER_MASK = (1 << USER_BITS) - 1;
+
+//--------------------------------------------------------------------
+// The messages printed by getopt and argp are translated using the
+// "libc" domain; do the same so that the output stays identical:
+//--------------------------------------------------------------------
+static const char *libcText(const char *msgid)
+{
+#ifdef __GLIBC__
+  return dgettext("libc", msgid);
+#else
+  return msgid;
+#endif
+}
+
+//--------------------------------------------------------------------
+static char *shortProgramName()
+{
+#ifdef __GLIBC__
+  return program_invocation_short_name;
+#else
+  static char empty[] = "";
+  return empty;
+#endif
+}
+
+//--------------------------------------------------------------------
+static char *baseName(char *name)
+{
+  char *p = strrchr(name, ARGPP_DIR_SEPARATOR);
+  return p ? p + 1 : name;
+}
+
+//--------------------------------------------------------------------
+// Strips the group number (see USER_BITS) while preserving the sign:
+//--------------------------------------------------------------------
+static int userKey(int key)
+{
+  int k = key & USER_MASK;
+  if (k & (1 << (USER_BITS - 1))) {
+    k -= (1 << USER_BITS);
+  }
+  return k;
+}
+
+//--------------------------------------------------------------------
+static void requestExit(const argp_state *state, int status)
+{
+  ParseContext &ctx = ParseContext::of(state);
+  ctx.argpp_should_exit_   = true;
+  ctx.error_code_from_argp_ = status;
+}
+
+//--------------------------------------------------------------------
+// Same as argp_state_help(), except that the text is formatted by
+// renderHelp(), and that instead of calling exit() it asks the caller
+// of the native engine to do so after the engine's own objects have
+// been destroyed:
+//--------------------------------------------------------------------
+static void stateHelp(const argp_state *state, FILE *stream, unsigned flags)
+{
+  if (!(state->flags & ARGP_NO_ERRS) && stream) {
+    renderHelp(state, stream, flags);
+
+    if (!(state->flags & ARGP_NO_EXIT)) {
+      if (flags & ARGP_HELP_EXIT_ERR) {
+        requestExit(state, argp_err_exit_status);
+      } else if (flags & ARGP_HELP_EXIT_OK) {
+        requestExit(state, 0);
+      }
+    }
+  }
+}
+
+//--------------------------------------------------------------------
+// Same as argp_error(state, "%s", msg), see stateHelp():
+//--------------------------------------------------------------------
+static void stateError(const argp_state *state, const std::string &msg)
+{
+  if (!(state->flags & ARGP_NO_ERRS) && state->err_stream) {
+    fprintf(state->err_stream, "%s: %s\n"
+            , state->name ? state->name : shortProgramName()
+            , msg.c_str());
+    stateHelp(state, state->err_stream, ARGP_HELP_STD_ERR);
+  }
+}
+
+//--------------------------------------------------------------------
+// The default options and the --version option which argp_parse()
+// adds unless ARGP_NO_HELP is given. The text and the domain must
+// be the same as in argp-parse.c for the help output to match:
+//--------------------------------------------------------------------
+static const argp_option DEFAULT_OPTIONS[] = {
+  { "help",         '?',          0,      0,             "Give this help list", -1 },
+  { "usage",        OPT_USAGE,    0,      0,             "Give a short usage message", 0 },
+  { "program-name", OPT_PROGNAME, "NAME", OPTION_HIDDEN, "Set the program name", 0 },
+  { "HANG",         OPT_HANG,     "SECS", OPTION_ARG_OPTIONAL | OPTION_HIDDEN,
+                                                         "Hang for SECS seconds (default 3600)", 0 },
+  { NULL, 0, NULL, 0, NULL, 0 }
+};
+
+static const argp_option VERSION_OPTIONS[] = {
+  { "version",      'V',          0,      0,             "Print program version", -1 },
+  { NULL, 0, NULL, 0, NULL, 0 }
+};
+
+//--------------------------------------------------------------------
+static error_t defaultParser(int key, char *arg, argp_state *state)
+{
+  switch (key) {
+    case '?':
+      stateHelp(state, state->out_stream, ARGP_HELP_STD_HELP);
+      break;
+    case OPT_USAGE:
+      stateHelp(state, state->out_stream, ARGP_HELP_USAGE | ARGP_HELP_EXIT_OK);
+      break;
+    case OPT_PROGNAME:
+      state->name = baseName(arg);
+#ifdef __GLIBC__
+      program_invocation_name       = arg;
+      program_invocation_short_name = state->name;
+#endif
+      if ((state->flags & (ARGP_PARSE_ARGV0 | ARGP_NO_ERRS)) == ARGP_PARSE_ARGV0) {
+        state->argv[0] = arg;
+      }
+      break;
+    case OPT_HANG:
+    {
+      int secs = atoi(arg ? arg : "3600");
+      while (secs-- > 0) {
+        sleep(1);
+      }
+      break;
+    }
+    default:
+      return ARGP_ERR_UNKNOWN;
+  }
+  return ARGPP_SUCCESS;
+}
+
+//--------------------------------------------------------------------
+static error_t versionParser(int key, char * /* unused */, argp_state *state)
+{
+  if (key != 'V') {
+    return ARGP_ERR_UNKNOWN;
+  }
+  if (argp_program_version_hook) {
+    (*argp_program_version_hook)(state->out_stream, state);
+  } else if (argp_program_version) {
+    fprintf(state->out_stream, "%s\n", argp_program_version);
+  } else {
+    stateError(state, libcText("(PROGRAM ERROR) No version known!?"));
+  }
+  if (!(state->flags & ARGP_NO_EXIT) && !ParseContext::of(state).argpp_should_exit_) {
+    requestExit(state, 0);
+  }
+  return ARGPP_SUCCESS;
+}
+
+static const argp DEFAULT_ARGP = {
+  DEFAULT_OPTIONS, defaultParser, NULL, NULL, NULL, NULL, "libc"
+};
+
+static const argp VERSION_ARGP = {
+  VERSION_OPTIONS, versionParser, NULL, NULL, NULL, NULL, "libc"
+};
+
+//--------------------------------------------------------------------
+// PrefixIndex:
+//--------------------------------------------------------------------
+namespace {
+
+//--------------------------------------------------------------------
+// Orders the names as strcmp() would, and equal names by their values:
+//--------------------------------------------------------------------
+struct EntryLess {
+  bool operator()(const PrefixIndex::Entry &a, const PrefixIndex::Entry &b) const {
+    int cmp = memcmp(a.name_, b.name_, std::min(a.len_, b.len_));
+    if (cmp == 0 && a.len_ != b.len_) {
+      cmp = (a.len_ < b.len_) ? -1 : 1;
+    }
+    return (cmp < 0) || (cmp == 0 && a.value_ < b.value_);
+  }
+};
+
+//--------------------------------------------------------------------
+struct EntrySameName {
+  bool operator()(const PrefixIndex::Entry &a, const PrefixIndex::Entry &b) const {
+    return a.len_ == b.len_ && memcmp(a.name_, b.name_, a.len_) == 0;
+  }
+};
+
+//--------------------------------------------------------------------
+// Compares only the first len characters of the name with prefix;
+// returns 0 if the name begins with prefix:
+//--------------------------------------------------------------------
+int comparePrefix(const PrefixIndex::Entry &e, const char *prefix, size_t len)
+{
+  int cmp = memcmp(e.name_, prefix, std::min(e.len_, len));
+  if (cmp == 0 && e.len_ < len) {
+    cmp = -1;
+  }
+  return cmp;
+}
+
+} // anonymous namespace
+
+//--------------------------------------------------------------------
+PrefixIndex::PrefixIndex(ParseArena *arena)
+  : entries_ (ArenaAllocator<Entry>(arena))
+{}
+//--------------------------------------------------------------------
+void PrefixIndex::add(const char *name, size_t value)
+{
+  Entry e = { name, strlen(name), value };
+  entries_.push_back(e);
+}
+//--------------------------------------------------------------------
+void PrefixIndex::build()
+{
+  //---------------------------------------------------
+  // std::sort() doesn't need a temporary buffer as
+  // std::stable_sort() does; equal names are ordered
+  // by their values, and unique() keeps the first:
+  //---------------------------------------------------
+  std::sort(entries_.begin(), entries_.end(), EntryLess());
+  entries_.erase(std::unique(entries_.begin(), entries_.end(), EntrySameName())
+                 , entries_.end());
+}
+//--------------------------------------------------------------------
+PrefixIndex::Range PrefixIndex::matches(const char *prefix, size_t len) const
+{
+  if (entries_.empty()) {
+    return Range(NULL, NULL);
+  }
+  const Entry *base = &entries_[0];
+
+  //---------------------------------------------------
+  // The first entry not less than the prefix...
+  //---------------------------------------------------
+  size_t lo = 0, hi = entries_.size();
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (comparePrefix(base[mid], prefix, len) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  //---------------------------------------------------
+  // ...and the first one greater than it:
+  //---------------------------------------------------
+  size_t first = lo;
+  hi = entries_.size();
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (comparePrefix(base[mid], prefix, len) <= 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return Range(base + first, base + lo);
+}
+//--------------------------------------------------------------------
+int PrefixIndex::find(const char *prefix, size_t len, bool *ambiguous) const
+{
+  Range r = matches(prefix, len);
+  bool ambig = false;
+  int retval = -1;
+
+  if (r.first != r.second) {
+    if (r.first->len_ == len || (r.second - r.first) == 1) {
+      retval = static_cast<int>(r.first->value_);
+    } else {
+      ambig = true;
+    }
+  }
+  if (ambiguous) {
+    *ambiguous = ambig;
+  }
+  return retval;
+}
+
+//--------------------------------------------------------------------
+// NativeTable:
+//--------------------------------------------------------------------
+NativeTable::NativeTable(const argp *root, unsigned flags, ParseArena *arena, ArgppBase *owner)
+  : groups_          (ArenaAllocator<NativeGroup>(arena))
+  , long_options_    (ArenaAllocator<NativeLongOption>(arena))
+  , flags_           (flags)
+  , prefix_index_    (arena)
+  , root_argp_       (NULL)
+  , top_argp_        ()
+{
+  for (size_t i=0; i<256; ++i) {
+    short_group_[i]   = -1;
+    short_has_arg_[i] = 0;
+  }
+  memset(top_children_, 0, sizeof(top_children_));
+
+  //---------------------------------------------------
+  // The groups are numbered in the same (pre-)order as
+  // argp numbers them:
+  //---------------------------------------------------
+  size_t num_inputs = 0;
+  addParser(root, owner, -1, 0, num_inputs);
+  root_argp_ = root;
+
+  if (!(flags & ARGP_NO_HELP)) {
+    //-----------------------------------------------
+    // This is the argp struct which argp_parse()
+    // creates to hold the user's and its own argps;
+    // it has no options and no parser, so it is not
+    // a group of its own:
+    //-----------------------------------------------
+    size_t n = 0;
+    top_children_[n++].argp = root;
+    top_children_[n++].argp = &DEFAULT_ARGP;
+    addGroup(&DEFAULT_ARGP, NULL, -1, 0, 0, num_inputs);
+
+    if (argp_program_version || argp_program_version_hook) {
+      top_children_[n++].argp = &VERSION_ARGP;
+      addGroup(&VERSION_ARGP, NULL, -1, 0, 0, num_inputs);
+    }
+    top_argp_.children = top_children_;
+    root_argp_ = &top_argp_;
+  }
+
+  for (size_t i=0; i<long_options_.size(); ++i) {
+    prefix_index_.add(long_options_[i].name_, i);
+  }
+  prefix_index_.build();
+}
+//--------------------------------------------------------------------
+int NativeTable::findLongOption(const char *name, size_t len
+                                , std::vector<size_t> *ambiguous) const
+{
+  //---------------------------------------------------
+  // An exact match always wins; it is the first of the
+  // candidates if there is one:
+  //---------------------------------------------------
+  PrefixIndex::Range range = prefix_index_.matches(name, len);
+  if (range.first == range.second) {
+    return -1;
+  }
+  if (range.first->len_ == len) {
+    return static_cast<int>(range.first->value_);
+  }
+
+  //---------------------------------------------------
+  // Otherwise getopt takes the first abbreviation in
+  // the order of the options. Several matches are only
+  // ambiguous if they would do different things:
+  //---------------------------------------------------
+  const bool long_only = (flags_ & ARGP_LONG_ONLY) != 0;
+  size_t first = range.first->value_;
+  for (const PrefixIndex::Entry *e = range.first; e != range.second; ++e) {
+    first = std::min(first, e->value_);
+  }
+
+  const NativeLongOption &f = long_options_[first];
+  bool ambig = false;
+
+  for (const PrefixIndex::Entry *e = range.first; e != range.second; ++e) {
+    const NativeLongOption &lo = long_options_[e->value_];
+    if ((e->value_ != first)
+        && (long_only
+            || f.has_arg_ != lo.has_arg_
+            || f.key_     != lo.key_
+            || f.group_   != lo.group_)) {
+      if (ambiguous) {
+        if (!ambig) {
+          ambiguous->push_back(first);
+        }
+        ambiguous->push_back(e->value_);
+      }
+      ambig = true;
+    }
+  }
+  if (ambiguous) {
+    std::sort(ambiguous->begin(), ambiguous->end());
+  }
+  return ambig ? -1 : static_cast<int>(first);
+}
+//--------------------------------------------------------------------
+bool NativeTable::isDefaultGroup(size_t g) const
+{
+  return groups_[g].parser_ == defaultParser || groups_[g].parser_ == versionParser;
+}
+//--------------------------------------------------------------------
+void NativeTable::addParser(const argp *ap, ArgppBase *owner
+                            , int parent, unsigned parent_index, size_t &num_inputs)
+{
+  int me = static_cast<int>(groups_.size());
+
+  //---------------------------------------------------
+  // The parser only owns ap if it is its main_argp_;
+  // the children of ap are those of child_inputs_:
+  //---------------------------------------------------
+  ArgppBaseImpl *pi = owner ? ArgppBaseImpl::implOf(owner) : NULL;
+  if (pi && &pi->main_argp_ != ap) {
+    pi = NULL;
+  }
+
+  //---------------------------------------------------
+  // The array of children ends with a NULL argp:
+  //---------------------------------------------------
+  size_t num_children = 0;
+  while (ap->children && ap->children[num_children].argp) {
+    ++num_children;
+  }
+  addGroup(ap, pi ? owner : NULL, parent, parent_index, num_children, num_inputs);
+
+  for (size_t i=0; i<num_children; ++i) {
+    ArgppBase *child = (pi && i < pi->child_inputs_.size()) ? pi->child_inputs_[i] : NULL;
+    addParser(ap->children[i].argp, child, me, static_cast<unsigned>(i), num_inputs);
+  }
+}
+//--------------------------------------------------------------------
+void NativeTable::addGroup(const argp *ap, ArgppBase *owner
+                           , int parent, unsigned parent_index, size_t num_children
+                           , size_t &num_inputs)
+{
+  size_t g = groups_.size();
+  NativeGroup grp = { ap, ap->parser, parent, parent_index
+                      , num_inputs, num_children, lk_all };
+  if (ap == &DEFAULT_ARGP || ap == &VERSION_ARGP) {
+    grp.lifecycle_keys_ = lk_none;
+  } else if (owner) {
+    grp.lifecycle_keys_ = ArgppBaseImpl::implOf(owner)->lifecycle_keys_;
+  }
+  groups_.push_back(grp);
+  num_inputs += num_children;
+
+  //---------------------------------------------------
+  // Aliases take their argument and flags from the most
+  // recent option which is not an alias ("real"), as in
+  // argp's convert_options():
+  //---------------------------------------------------
+  const argp_option *real = NULL;
+
+  // argp stops at the first empty entry:
+  for (const argp_option *opt = ap->options;
+       opt && !ArgppBaseImpl::isOptionEnd(opt);
+       ++opt) {
+    if (!real || !(opt->flags & OPTION_ALIAS)) {
+      real = opt;
+    }
+    if (real->flags & OPTION_DOC) {
+      continue;
+    }
+
+    int has_arg = !real->arg
+        ? 0 : ((real->flags & OPTION_ARG_OPTIONAL) ? 2 : 1);
+
+    if (!(opt->flags & OPTION_DOC)
+        && (opt->key > 0) && (opt->key <= UCHAR_MAX) && isprint(opt->key)) {
+      unsigned char c = static_cast<unsigned char>(opt->key);
+      // getopt finds the first occurrence in the string of short options:
+      if (short_group_[c] < 0) {
+        short_group_[c]   = static_cast<int>(g);
+        short_has_arg_[c] = static_cast<signed char>(has_arg);
+      }
+    }
+
+    if (opt->name) {
+      NativeLongOption lo = { opt->name
+                              , strlen(opt->name)
+                              , has_arg
+                              , userKey(opt->key ? opt->key : real->key)
+                              , g };
+      long_options_.push_back(lo);
+    }
+  }
+}
+
+//--------------------------------------------------------------------
+// NativeLexer:
+//--------------------------------------------------------------------
+NativeLexer::NativeLexer(const NativeTable &table, int argc, char **argv, FILE *err_stream
+                         , bool in_order)
+  : optind_       (0)
+  , table_        (table)
+  , argc_         (argc)
+  , argv_         (argv)
+  , err_stream_   (err_stream)
+  , in_order_     (in_order)
+  , initialized_  (false)
+  , ordering_     (PERMUTE)
+  , nextchar_     (NULL)
+  , first_nonopt_ (0)
+  , last_nonopt_  (0)
+{}
+//--------------------------------------------------------------------
+bool NativeLexer::isNonOption(int idx) const
+{
+  return (argv_[idx][0] != '-') || (argv_[idx][1] == '\0');
+}
+//--------------------------------------------------------------------
+bool NativeLexer::isShortOption(char c) const
+{
+  return (table_.shortGroup(static_cast<unsigned char>(c)) >= 0)
+      && (c != ':') && (c != ';');
+}
+//--------------------------------------------------------------------
+void NativeLexer::exchange()
+{
+  //---------------------------------------------------
+  // Swaps the block of non-options we skipped with the
+  // block of options which followed them, exactly as
+  // getopt does:
+  //---------------------------------------------------
+  int bottom = first_nonopt_;
+  int middle = last_nonopt_;
+  int top    = optind_;
+
+  while (top > middle && middle > bottom) {
+    if (top - middle > middle - bottom) {
+      int len = middle - bottom;
+      for (int i=0; i<len; ++i) {
+        std::swap(argv_[bottom + i], argv_[top - (middle - bottom) + i]);
+      }
+      top -= len;
+    } else {
+      int len = top - middle;
+      for (int i=0; i<len; ++i) {
+        std::swap(argv_[bottom + i], argv_[middle + i]);
+      }
+      bottom += len;
+    }
+  }
+  first_nonopt_ += (optind_ - last_nonopt_);
+  last_nonopt_   = optind_;
+}
+//--------------------------------------------------------------------
+void NativeLexer::next(NativeToken &tok)
+{
+  tok.kind_       = NativeToken::tk_end;
+  tok.group_      = 0;
+  tok.key_        = 0;
+  tok.arg_        = NULL;
+  tok.long_index_ = -1;
+
+  if (argc_ < 1) {
+    return;
+  }
+
+  if (optind_ == 0 || !initialized_) {
+    if (optind_ == 0) {
+      optind_ = 1;
+    }
+    first_nonopt_ = last_nonopt_ = optind_;
+    nextchar_ = NULL;
+
+    if (in_order_ || (table_.flags_ & ARGP_IN_ORDER)) {
+      ordering_ = RETURN_IN_ORDER;
+    } else if ((table_.flags_ & ARGP_NO_ARGS) || getenv("POSIXLY_CORRECT")) {
+      ordering_ = REQUIRE_ORDER;
+    } else {
+      ordering_ = PERMUTE;
+    }
+    initialized_ = true;
+  }
+
+  if (nextchar_ == NULL || *nextchar_ == '\0') {
+    //-----------------------------------------------
+    // Advance to the next element of argv:
+    //-----------------------------------------------
+    if (last_nonopt_ > optind_) {
+      last_nonopt_ = optind_;
+    }
+    if (first_nonopt_ > optind_) {
+      first_nonopt_ = optind_;
+    }
+
+    if (ordering_ == PERMUTE) {
+      if (first_nonopt_ != last_nonopt_ && last_nonopt_ != optind_) {
+        exchange();
+      } else if (last_nonopt_ != optind_) {
+        first_nonopt_ = optind_;
+      }
+      while (optind_ < argc_ && isNonOption(optind_)) {
+        ++optind_;
+      }
+      last_nonopt_ = optind_;
+    }
+
+    //-----------------------------------------------
+    // "--" ends the options; everything after it is
+    // a non-option argument:
+    //-----------------------------------------------
+    if (optind_ != argc_ && strcmp(argv_[optind_], "--") == 0) {
+      ++optind_;
+      if (first_nonopt_ != last_nonopt_ && last_nonopt_ != optind_) {
+        exchange();
+      } else if (first_nonopt_ == last_nonopt_) {
+        first_nonopt_ = optind_;
+      }
+      last_nonopt_ = argc_;
+      optind_      = argc_;
+    }
+
+    if (optind_ == argc_) {
+      // Back up over the non-options we skipped:
+      if (first_nonopt_ != last_nonopt_) {
+        optind_ = first_nonopt_;
+      }
+      return;
+    }
+
+    if (isNonOption(optind_)) {
+      if (ordering_ == REQUIRE_ORDER) {
+        return;
+      }
+      tok.kind_ = NativeToken::tk_arg;
+      tok.arg_  = argv_[optind_++];
+      return;
+    }
+
+    if (argv_[optind_][1] == '-') {
+      nextchar_ = argv_[optind_] + 2;
+      longOption("--", tok);
+      return;
+    }
+
+    //-----------------------------------------------
+    // With ARGP_LONG_ONLY, "-f" is still the short
+    // option f, but "-fu" is tried as an abbreviation
+    // of a long option first:
+    //-----------------------------------------------
+    if ((table_.flags_ & ARGP_LONG_ONLY)
+        && (argv_[optind_][2] || !isShortOption(argv_[optind_][1]))) {
+      nextchar_ = argv_[optind_] + 1;
+      if (longOption("-", tok)) {
+        return;
+      }
+    }
+    nextchar_ = argv_[optind_] + 1;
+  }
+
+  //---------------------------------------------------
+  // The next short option character:
+  //---------------------------------------------------
+  char c = *nextchar_++;
+
+  if (*nextchar_ == '\0') {
+    ++optind_;
+  }
+
+  if (!isShortOption(c)) {
+    if (err_stream_) {
+      fprintf(err_stream_, libcText("%s: invalid option -- '%c'\n"), argv_[0], c);
+    }
+    tok.kind_ = NativeToken::tk_error;
+    tok.key_  = c;
+    return;
+  }
+
+  unsigned char uc = static_cast<unsigned char>(c);
+  int has_arg = table_.shortHasArg(uc);
+
+  if (has_arg == 2) {
+    if (*nextchar_ != '\0') {
+      tok.arg_ = nextchar_;
+      ++optind_;
+    }
+    nextchar_ = NULL;
+  } else if (has_arg == 1) {
+    if (*nextchar_ != '\0') {
+      tok.arg_ = nextchar_;
+      ++optind_;
+    } else if (optind_ == argc_) {
+      if (err_stream_) {
+        fprintf(err_stream_, libcText("%s: option requires an argument -- '%c'\n"), argv_[0], c);
+      }
+      nextchar_ = NULL;
+      tok.kind_ = NativeToken::tk_error;
+      tok.key_  = c;
+      return;
+    } else {
+      tok.arg_ = argv_[optind_++];
+    }
+    nextchar_ = NULL;
+  }
+
+  tok.kind_  = NativeToken::tk_option;
+  tok.group_ = static_cast<size_t>(table_.shortGroup(uc));
+  tok.key_   = uc;
+}
+//--------------------------------------------------------------------
+bool NativeLexer::longOption(const char *prefix, NativeToken &tok)
+{
+  const NativeLongOptions &lopts = table_.long_options_;
+  const bool long_only = (table_.flags_ & ARGP_LONG_ONLY) != 0;
+
+  char *nameend = nextchar_;
+  while (*nameend && *nameend != '=') {
+    ++nameend;
+  }
+  size_t namelen = static_cast<size_t>(nameend - nextchar_);
+
+  std::vector<size_t> ambig_set;
+  int found = table_.findLongOption(nextchar_, namelen, &ambig_set);
+
+  if (!ambig_set.empty()) {
+    if (err_stream_) {
+      fprintf(err_stream_, libcText("%s: option '%s%s' is ambiguous; possibilities:")
+              , argv_[0], prefix, nextchar_);
+      for (size_t i=0; i<ambig_set.size(); ++i) {
+        fprintf(err_stream_, " '%s%s'", prefix, lopts[ambig_set[i]].name_);
+      }
+      fprintf(err_stream_, "\n");
+    }
+    nextchar_ += strlen(nextchar_);
+    ++optind_;
+    tok.kind_ = NativeToken::tk_error;
+    return true;
+  }
+
+  if (found < 0) {
+    //-----------------------------------------------
+    // With ARGP_LONG_ONLY, "-x..." might still be a
+    // short option:
+    //-----------------------------------------------
+    if (!long_only || argv_[optind_][1] == '-' || !isShortOption(*nextchar_)) {
+      if (err_stream_) {
+        fprintf(err_stream_, libcText("%s: unrecognized option '%s%s'\n")
+                , argv_[0], prefix, nextchar_);
+      }
+      nextchar_ = NULL;
+      ++optind_;
+      tok.kind_ = NativeToken::tk_error;
+      return true;
+    }
+    return false;
+  }
+
+  const NativeLongOption &lo = lopts[static_cast<size_t>(found)];
+  ++optind_;
+  nextchar_ = NULL;
+
+  if (*nameend) {
+    if (lo.has_arg_) {
+      tok.arg_ = nameend + 1;
+    } else {
+      if (err_stream_) {
+        fprintf(err_stream_, libcText("%s: option '%s%s' doesn't allow an argument\n")
+                , argv_[0], prefix, lo.name_);
+      }
+      tok.kind_ = NativeToken::tk_error;
+      return true;
+    }
+  } else if (lo.has_arg_ == 1) {
+    if (optind_ < argc_) {
+      tok.arg_ = argv_[optind_++];
+    } else {
+      if (err_stream_) {
+        fprintf(err_stream_, libcText("%s: option '%s%s' requires an argument\n")
+                , argv_[0], prefix, lo.name_);
+      }
+      tok.kind_ = NativeToken::tk_error;
+      return true;
+    }
+  }
+
+  tok.kind_       = NativeToken::tk_option;
+  tok.group_      = lo.group_;
+  tok.key_        = lo.key_;
+  tok.long_index_ = found;
+  return true;
+}
+
+//--------------------------------------------------------------------
+// NativeParser:
+//--------------------------------------------------------------------
+NativeParser::NativeParser(const NativeTable &table, ParseArena *arena)
+  : table_        (table)
+  , state_        ()
+  , groups_       (ArenaAllocator<NativeGroupState>(arena))
+  , child_inputs_ (ArenaAllocator<void*>(arena))
+  , pstate_       ()
+#ifdef ARGPP_HAVE_GLIBC_ARGP_LAYOUT
+  , argp_groups_  (ArenaAllocator<ArgpGroupMirror>(arena))
+#endif
+  , try_getopt_   (true)
+{}
+//--------------------------------------------------------------------
+bool NativeParser::shouldExit() const
+{
+  return ParseContext::of(&state_).argpp_should_exit_;
+}
+//--------------------------------------------------------------------
+error_t NativeParser::groupParse(size_t g, int key, char *arg)
+{
+  NativeGroupState &grp = groups_[g];
+
+  state_.hook         = grp.hook_;
+  state_.input        = grp.input_;
+  state_.child_inputs = grp.child_inputs_;
+  state_.arg_num      = grp.args_processed_;
+
+  error_t err = table_.groups_[g].parser_(key, arg, &state_);
+
+  grp.hook_ = state_.hook;
+  return err;
+}
+//--------------------------------------------------------------------
+// Whether the parser of group g has anything to do with the key, which
+// is ARGP_KEY_ARG or one of the lifecycle keys. The table knows which
+// hooks our own parsers implement; the default options and --version
+// only have options:
+//--------------------------------------------------------------------
+bool NativeParser::wants(size_t g, int key) const
+{
+  if (key == ARGP_KEY_ARG) {
+    return !table_.isDefaultGroup(g);
+  }
+  return (table_.groups_[g].lifecycle_keys_ & ArgppBaseImpl::lifecycleKey(key)) != 0;
+}
+//--------------------------------------------------------------------
+error_t NativeParser::parse(int argc, char **argv, int *end_index, void *input)
+{
+  const size_t num_groups = table_.groups_.size();
+  size_t num_inputs = 0;
+  if (num_groups) {
+    const NativeGroup &last = table_.groups_[num_groups - 1];
+    num_inputs = last.child_inputs_begin_ + last.num_children_;
+  }
+
+  child_inputs_.assign(num_inputs, static_cast<void*>(NULL));
+  groups_.resize(num_groups);
+  for (size_t g=0; g<num_groups; ++g) {
+    const NativeGroup &ng = table_.groups_[g];
+    NativeGroupState &grp = groups_[g];
+    memset(&grp, 0, sizeof(grp));
+    grp.child_inputs_ = ng.num_children_ ? &child_inputs_[ng.child_inputs_begin_] : NULL;
+  }
+#ifdef ARGPP_HAVE_GLIBC_ARGP_LAYOUT
+  //---------------------------------------------------
+  // The copy of the groups for argp's helper functions:
+  //---------------------------------------------------
+  argp_groups_.resize(num_groups);
+  for (size_t g=0; g<num_groups; ++g) {
+    memset(&argp_groups_[g], 0, sizeof(argp_groups_[g]));
+    argp_groups_[g].parser = table_.groups_[g].parser_;
+    argp_groups_[g].argp   = table_.groups_[g].argp_;
+  }
+  memset(&pstate_, 0, sizeof(pstate_));
+  pstate_.argp         = table_.rootArgp();
+  pstate_.groups       = argp_groups_.empty() ? NULL : &argp_groups_[0];
+  pstate_.egroup       = pstate_.groups + num_groups;
+#endif
+
+  memset(&state_, 0, sizeof(state_));
+  state_.root_argp  = table_.rootArgp();
+  state_.argc       = argc;
+  state_.argv       = argv;
+  state_.flags      = table_.flags_;
+  state_.err_stream = stderr;
+  state_.out_stream = stdout;
+  state_.next       = 0;
+  state_.pstate     = &pstate_;
+  try_getopt_       = true;
+
+  //---------------------------------------------------
+  // Call each parser with ARGP_KEY_INIT, parents first,
+  // so that they can pass their child_inputs down:
+  //---------------------------------------------------
+  error_t err = ARGPP_SUCCESS;
+  if (num_groups) {
+    groups_[0].input_ = input;
+  }
+  for (size_t g=0; g<num_groups && (!err || err == ARGP_ERR_UNKNOWN); ++g) {
+    const NativeGroup &ng = table_.groups_[g];
+    NativeGroupState &grp = groups_[g];
+    if (ng.parent_ >= 0) {
+      grp.input_ = groups_[static_cast<size_t>(ng.parent_)].child_inputs_[ng.parent_index_];
+    }
+#ifdef ARGPP_HAVE_GLIBC_ARGP_LAYOUT
+    argp_groups_[g].input = grp.input_;
+#endif
+    err = groupParse(g, ARGP_KEY_INIT, NULL);
+  }
+  if (err == ARGP_ERR_UNKNOWN) {
+    err = ARGPP_SUCCESS;
+  }
+  if (err) {
+    return err;
+  }
+
+  //---------------------------------------------------
+  // getopt's own messages go where argp's do, so that a
+  // caller who redirects err_stream in ARGP_KEY_INIT
+  // gets all of them:
+  //---------------------------------------------------
+  FILE *lexer_errors = state_.err_stream ? state_.err_stream : stderr;
+  if (state_.flags & ARGP_NO_ERRS) {
+    lexer_errors = NULL;
+    if (state_.flags & ARGP_PARSE_ARGV0) {
+      //---------------------------------------------
+      // getopt always skips argv[0]; argp fakes it
+      // out like this, and so do we:
+      //---------------------------------------------
+      --state_.argv;
+      ++state_.argc;
+    }
+  }
+  if (state_.argv == argv && argv[0]) {
+    state_.name = baseName(argv[0]);
+  } else {
+    state_.name = shortProgramName();
+  }
+
+  NativeLexer lexer(table_, state_.argc, state_.argv, lexer_errors);
+  bool arg_ebadkey = false;
+
+  while (!err) {
+    err = parseNext(lexer, arg_ebadkey);
+    if (shouldExit()) {
+      return err;
+    }
+  }
+  return finalize(err, arg_ebadkey, end_index);
+}
+//--------------------------------------------------------------------
+error_t NativeParser::parseNext(NativeLexer &lexer, bool &arg_ebadkey)
+{
+  NativeToken tok;
+  tok.kind_ = NativeToken::tk_end;
+  tok.arg_  = NULL;
+
+  //---------------------------------------------------
+  // If a parser moved "next" back before a quoting "--",
+  // forget about it and let the lexer see it again:
+  //---------------------------------------------------
+  if (state_.quoted && state_.next < state_.quoted) {
+    state_.quoted = 0;
+  }
+
+  if (try_getopt_ && !state_.quoted) {
+    lexer.optind_ = state_.next;
+    lexer.next(tok);
+    state_.next = lexer.optind_;
+
+    if (tok.kind_ == NativeToken::tk_end) {
+      try_getopt_ = false;
+      if (state_.next > 1 && strcmp(state_.argv[state_.next - 1], "--") == 0) {
+        state_.quoted = state_.next;
+      }
+    } else if (tok.kind_ == NativeToken::tk_error) {
+      arg_ebadkey = false;
+      return ARGP_ERR_UNKNOWN;
+    }
+  }
+
+  if (tok.kind_ == NativeToken::tk_end) {
+    if (state_.next >= state_.argc || (state_.flags & ARGP_NO_ARGS)) {
+      arg_ebadkey = true;
+      return ARGP_ERR_UNKNOWN;
+    }
+    tok.kind_ = NativeToken::tk_arg;
+    tok.arg_  = state_.argv[state_.next++];
+  }
+
+  error_t err = (tok.kind_ == NativeToken::tk_arg)
+      ? parseArg(tok.arg_)
+      : parseOpt(tok);
+
+  if (err == ARGP_ERR_UNKNOWN) {
+    arg_ebadkey = (tok.kind_ == NativeToken::tk_arg);
+  }
+  return err;
+}
+//--------------------------------------------------------------------
+error_t NativeParser::parseArg(char *val)
+{
+  //---------------------------------------------------
+  // Offer the argument to each parser in turn, first as
+  // ARGP_KEY_ARG and then as ARGP_KEY_ARGS. A parser
+  // which has nothing to do with a key declines it:
+  //---------------------------------------------------
+  int index = --state_.next;
+  error_t err = ARGP_ERR_UNKNOWN;
+  int key = 0;
+  size_t g = 0;
+
+  for (; g<table_.groups_.size() && err == ARGP_ERR_UNKNOWN; ++g) {
+    ++state_.next;
+    key = ARGP_KEY_ARG;
+    err = wants(g, key) ? groupParse(g, key, val) : ARGP_ERR_UNKNOWN;
+
+    if (err == ARGP_ERR_UNKNOWN) {
+      --state_.next;
+      key = ARGP_KEY_ARGS;
+      err = wants(g, key) ? groupParse(g, key, NULL) : ARGP_ERR_UNKNOWN;
+    }
+  }
+
+  if (!err) {
+    if (key == ARGP_KEY_ARGS) {
+      state_.next = state_.argc;
+    }
+    if (state_.next > index) {
+      groups_[g - 1].args_processed_ += static_cast<unsigned>(state_.next - index);
+    } else {
+      // the parser wants to see some arguments again:
+      try_getopt_ = true;
+    }
+  }
+  return err;
+}
+//--------------------------------------------------------------------
+error_t NativeParser::parseOpt(const NativeToken &tok)
+{
+  error_t err = groupParse(tok.group_, tok.key_, tok.arg_);
+
+  if (err == ARGP_ERR_UNKNOWN) {
+    //-----------------------------------------------
+    // We know which parser owns the option, so it is
+    // a programming error if it doesn't handle it:
+    //-----------------------------------------------
+    const char *bad_key_err = "(PROGRAM ERROR) Option should have been recognized!?";
+    char buf[8];
+    std::string msg;
+
+    if (tok.long_index_ < 0) {
+      snprintf(buf, sizeof(buf), "-%c: ", tok.key_);
+      msg = buf;
+    } else {
+      //-------------------------------------------
+      // argp reports the first long option with
+      // the same key and group:
+      //-------------------------------------------
+      const NativeLongOptions &lopts = table_.long_options_;
+      size_t i = 0;
+      while (lopts[i].key_ != tok.key_ || lopts[i].group_ != tok.group_) {
+        ++i;
+      }
+      msg = std::string("--") + lopts[i].name_ + ": ";
+    }
+    msg += bad_key_err;
+    stateError(&state_, msg);
+  }
+  return err;
+}
+//--------------------------------------------------------------------
+error_t NativeParser::finalize(error_t err, bool arg_ebadkey, int *end_index)
+{
+  const size_t num_groups = table_.groups_.size();
+
+  // unparsed arguments are not an error:
+  if (err == ARGP_ERR_UNKNOWN && arg_ebadkey) {
+    err = ARGPP_SUCCESS;
+  }
+
+  if (!err) {
+    if (state_.next == state_.argc) {
+      //---------------------------------------------
+      // All arguments were parsed:
+      //---------------------------------------------
+      for (size_t g=0; g<num_groups && (!err || err == ARGP_ERR_UNKNOWN); ++g) {
+        if (groups_[g].args_processed_ == 0 && wants(g, ARGP_KEY_NO_ARGS)) {
+          err = groupParse(g, ARGP_KEY_NO_ARGS, NULL);
+        }
+      }
+      for (size_t g=num_groups; g>0 && (!err || err == ARGP_ERR_UNKNOWN); --g) {
+        if (wants(g - 1, ARGP_KEY_END)) {
+          err = groupParse(g - 1, ARGP_KEY_END, NULL);
+        }
+      }
+      if (err == ARGP_ERR_UNKNOWN) {
+        err = ARGPP_SUCCESS;
+      }
+      if (end_index) {
+        *end_index = state_.next;
+      }
+    } else if (end_index) {
+      // return the remaining arguments to the caller:
+      *end_index = state_.next;
+    } else {
+      if (!(state_.flags & ARGP_NO_ERRS) && state_.err_stream) {
+        fprintf(state_.err_stream, "%s: Too many arguments\n", state_.name);
+      }
+      err = ARGP_ERR_UNKNOWN;
+    }
+  }
+
+  if (err) {
+    if (err == ARGP_ERR_UNKNOWN) {
+      // the message describing the error was printed earlier:
+      stateHelp(&state_, state_.err_stream, ARGP_HELP_STD_ERR);
+      if (shouldExit()) {
+        return err;
+      }
+    }
+    for (size_t g=0; g<num_groups; ++g) {
+      if (wants(g, ARGP_KEY_ERROR)) {
+        groupParse(g, ARGP_KEY_ERROR, NULL);
+      }
+    }
+  } else {
+    //---------------------------------------------
+    // Children first, so that they can pass values
+    // back to their parents:
+    //---------------------------------------------
+    for (size_t g=num_groups; g>0 && (!err || err == ARGP_ERR_UNKNOWN); --g) {
+      if (wants(g - 1, ARGP_KEY_SUCCESS)) {
+        err = groupParse(g - 1, ARGP_KEY_SUCCESS, NULL);
+      }
+    }
+    if (err == ARGP_ERR_UNKNOWN) {
+      err = ARGPP_SUCCESS;
+    }
+  }
+
+  // errors are ignored here:
+  for (size_t g=num_groups; g>0; --g) {
+    if (wants(g - 1, ARGP_KEY_FINI)) {
+      groupParse(g - 1, ARGP_KEY_FINI, NULL);
+    }
+  }
+
+  if (err == ARGP_ERR_UNKNOWN) {
+    err = EINVAL;
+  }
+  return err;
+}
+
+//--------------------------------------------------------------------
+error_t nativeParse(const argp *ap, int argc, char **argv, unsigned flags, int *end_index, void *input)
+{
+  ParseArena &arena = ParseContext::scratch();
+  error_t err = ARGPP_SUCCESS;
+  {
+    NativeTable  table(ap, flags, &arena, static_cast<ArgppBase*>(input));
+    NativeParser parser(table, &arena);
+    err = parser.parse(argc, argv, end_index, input);
+  }
+  arena.release();
+  return err;
+}
+//--------------------------------------------------------------------
+error_t nativeParse(const NativeTable &table, int argc, char **argv, int *end_index, void *input)
+{
+  ParseArena &arena = ParseContext::scratch();
+  error_t err = ARGPP_SUCCESS;
+  {
+    NativeParser parser(table, &arena);
+    err = parser.parse(argc, argv, end_index, input);
+  }
+  arena.release();
+  return err;
+}
+
+//--------------------------------------------------------------------
+// Counts the options in opts whose long names begin with the first len
+// characters of name, and returns true for an exact match, which wins
+// over abbreviations as in PrefixIndex::find(). The first character
+// rules out all but one of the default options:
+//--------------------------------------------------------------------
+static bool findDefaultOption(const argp_option *opts, const char *name, size_t len
+                              , const argp_option *&found, size_t &num_found)
+{
+  for (const argp_option *ao = opts; ao->name; ++ao) {
+    if (ao->name[0] == name[0] && strncmp(ao->name, name, len) == 0) {
+      found = ao;
+      if (!ao->name[len]) {
+        num_found = 1;
+        return true;
+      }
+      ++num_found;
+    }
+  }
+  return false;
+}
+//--------------------------------------------------------------------
+bool isHelpRequest(const char *arg, bool with_version)
+{
+  if (arg[0] != '-') {
+    return false;
+  }
+  if (arg[1] != '-') {
+    return (strcmp(arg, "-?") == 0)
+        || (with_version && strcmp(arg, "-V") == 0);
+  }
+  const char *name = arg + 2;
+  size_t len = strcspn(name, "=");
+  if (!len || name[len]) {
+    return false;
+  }
+
+  //---------------------------------------------------
+  // This is done for every option on the command line,
+  // so there are no tables to build; there are only a
+  // handful of default options to compare with:
+  //---------------------------------------------------
+  const argp_option *found = NULL;
+  size_t num_found = 0;
+  if (!findDefaultOption(DEFAULT_OPTIONS, name, len, found, num_found) && with_version) {
+    findDefaultOption(VERSION_OPTIONS, name, len, found, num_found);
+  }
+  if (num_found != 1) {
+    return false;
+  }
+  int key = found->key;
+  return (key == '?') || (key == OPT_USAGE) || (key == 'V');
+}
+//--------------------------------------------------------------------
+bool isHelpRequest(const char *arg, const NativeTable &table)
+{
+  if (arg[0] != '-' || !arg[1]) {
+    return false;
+  }
+  int key   = 0;
+  int group = -1;
+  if (arg[1] != '-') {
+    if (arg[2] || (arg[1] != '?' && arg[1] != 'V')) {
+      return false;
+    }
+    key   = arg[1];
+    group = table.shortGroup(static_cast<unsigned char>(key));
+  } else {
+    const char *name = arg + 2;
+    size_t len = strcspn(name, "=");
+    if (!len) {
+      return false;
+    }
+    int found = table.findLongOption(name, len, NULL);
+    if (found < 0) {
+      return false;
+    }
+    const NativeLongOption &lo = table.long_options_[static_cast<size_t>(found)];
+    key   = lo.key_;
+    group = static_cast<int>(lo.group_);
+    //-----------------------------------------------
+    // --help[=PATTERN] and --help-group=N of the
+    // parser at the top (see HELP_SEARCH_KEY), which
+    // come before argp's --help:
+    //-----------------------------------------------
+    if (key == HELP_SEARCH_KEY && group == 0) {
+      return true;
+    }
+    if (name[len]) {
+      return false;
+    }
+  }
+  return group >= 0
+      && table.isDefaultGroup(static_cast<size_t>(group))
+      && ((key == '?') || (key == OPT_USAGE) || (key == 'V'));
+}
+//--------------------------------------------------------------------
+bool isOptionArgument(const NativeTable &table, char **argv, int idx)
+{
+  //---------------------------------------------------
+  // An argument is always the element after its option,
+  // wherever getopt moves the non-options, so only the
+  // elements before idx need to be looked at:
+  //---------------------------------------------------
+  bool taken = false;
+  for (int i=1; i<idx; ++i) {
+    const char *a = argv[i];
+    if (taken || a[0] != '-' || !a[1]) {
+      taken = false;
+      continue;
+    }
+    if (a[1] == '-') {
+      if (!a[2]) {
+        return false;
+      }
+      const char *name = a + 2;
+      size_t len = strcspn(name, "=");
+      int found = table.findLongOption(name, len, NULL);
+      taken = found >= 0 && !name[len]
+              && table.long_options_[static_cast<size_t>(found)].has_arg_ == 1;
+      continue;
+    }
+    for (const char *c = a + 1; *c; ++c) {
+      unsigned char ch = static_cast<unsigned char>(*c);
+      if (table.shortGroup(ch) >= 0 && table.shortHasArg(ch) != 0) {
+        taken = !c[1] && table.shortHasArg(ch) == 1;
+        break;
+      }
+    }
+  }
+  return taken;
+}
+
+} // namespace impl
+} // namespace argpp
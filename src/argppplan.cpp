@@ -0,0 +1,794 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include "argppplan.hpp"
+#include "argppcmdline.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#  include <unistd.h>
+#endif
+#if defined(_POSIX_VERSION) && (_POSIX_VERSION >= 200809L)
+#  define ARGPP_HAVE_OPEN_MEMSTREAM
+#endif
+
+//---------------------------------------------------------------
+// Files are only parsed on several threads if each thread has
+// its own ParseContext:
+//---------------------------------------------------------------
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+#  include <condition_variable>
+#  include <deque>
+#  include <exception>
+#  include <functional>
+#  include <mutex>
+#  include <thread>
+#  define ARGPP_HAVE_THREADS
+#endif
+
+namespace argpp {
+  namespace impl {
+
+//--------------------------------------------------------------------
+// Points the context for plans of the calling thread at one parse against
+// a plan for as long as it lasts, and puts back what was there before,
+// even if a callback throws:
+//--------------------------------------------------------------------
+class PlanParseScope
+{
+  public:
+    PlanParseScope(ParseContext &ctx, const ArgppPlanImpl *plan, ArgppParseResult *result
+                   , int argc, char **argv, bool help_called, FILE *err_stream)
+      : ctx_         (ctx)
+      , plan_        (ctx.plan_)
+      , result_      (ctx.result_)
+      , argc_        (ctx.argc_)
+      , argv_        (ctx.argv_)
+      , help_called_ (ctx.help_called_)
+      , should_exit_ (ctx.argpp_should_exit_)
+      , error_code_  (ctx.error_code_from_argp_)
+      , err_stream_  (ctx.err_stream_)
+    {
+      ctx.plan_                 = plan;
+      ctx.result_               = result;
+      ctx.argc_                 = argc;
+      ctx.argv_                 = argv;
+      ctx.help_called_          = help_called;
+      ctx.argpp_should_exit_    = false;
+      ctx.error_code_from_argp_ = 0;
+      ctx.err_stream_           = err_stream;
+    }
+    ~PlanParseScope()
+    {
+      ctx_.plan_                 = plan_;
+      ctx_.result_               = result_;
+      ctx_.argc_                 = argc_;
+      ctx_.argv_                 = argv_;
+      ctx_.help_called_          = help_called_;
+      ctx_.argpp_should_exit_    = should_exit_;
+      ctx_.error_code_from_argp_ = error_code_;
+      ctx_.err_stream_           = err_stream_;
+    }
+
+  private:
+    ParseContext         &ctx_;
+    const ArgppPlanImpl  *plan_;
+    ArgppParseResult     *result_;
+    int                   argc_;
+    char                **argv_;
+    bool                  help_called_;
+    bool                  should_exit_;
+    error_t               error_code_;
+    FILE                 *err_stream_;
+
+    PlanParseScope(const PlanParseScope &);
+    PlanParseScope& operator=(const PlanParseScope &);
+};
+
+//--------------------------------------------------------------------
+// Collects what argp prints to err_stream while one line of a batch
+// is parsed. The same memory stream is used for all of the lines:
+//--------------------------------------------------------------------
+class ErrorCapture
+{
+  public:
+    ErrorCapture()
+      : buf_    (NULL)
+      , size_   (0)
+      , stream_ (NULL)
+    {
+#ifdef ARGPP_HAVE_OPEN_MEMSTREAM
+      stream_ = open_memstream(&buf_, &size_);
+#endif
+    }
+    ~ErrorCapture()
+    {
+      if (stream_) {
+        fclose(stream_);
+      }
+      free(buf_);
+    }
+    ///
+    /// @brief NULL if the messages can't be captured.
+    ///
+    FILE *stream() const { return stream_; }
+    ///
+    /// @brief Moves what was printed since the last call into \c msg.
+    ///
+    void take(std::string &msg)
+    {
+      msg.clear();
+      if (stream_) {
+        fflush(stream_);
+        long len = ftell(stream_);
+        if (len > 0) {
+          msg.assign(buf_, static_cast<size_t>(len));
+        }
+        rewind(stream_);
+      }
+    }
+
+  private:
+    char   *buf_;
+    size_t  size_;
+    FILE   *stream_;
+
+    ErrorCapture(const ErrorCapture &);
+    ErrorCapture& operator=(const ErrorCapture &);
+};
+
+//--------------------------------------------------------------------
+// Reads the next line of in without the newline; returns false at
+// the end of the file:
+//--------------------------------------------------------------------
+static bool readLine(FILE *in, std::string &line)
+{
+  char chunk[4096];
+  bool got_any = false;
+
+  line.clear();
+  while (fgets(chunk, sizeof(chunk), in)) {
+    got_any = true;
+    size_t len = strlen(chunk);
+    if (len && chunk[len - 1] == '\n') {
+      line.append(chunk, len - 1);
+      break;
+    }
+    line.append(chunk, len);
+  }
+  return got_any;
+}
+
+//--------------------------------------------------------------------
+// What each thread needs for parsing the lines of a file:
+//--------------------------------------------------------------------
+struct BatchLineState
+{
+    BatchLineState() {}
+
+    ErrorCapture        errors_;
+    ArgppParseResult    result_;
+    CommandLineSplitter splitter_;
+
+  private:
+    BatchLineState(const BatchLineState &);
+    BatchLineState& operator=(const BatchLineState &);
+};
+
+#ifdef ARGPP_HAVE_THREADS
+
+//--------------------------------------------------------------------
+// The number of bytes read for each chunk, and the number of chunks
+// per thread which may be in memory at the same time:
+//--------------------------------------------------------------------
+static const size_t BATCH_CHUNK_SIZE      = 256 * 1024;
+static const size_t BATCH_CHUNKS_IN_FLIGHT = 4;
+
+//--------------------------------------------------------------------
+// A piece of a file made up of whole lines, and their results, in
+// which the line numbers start with 1:
+//--------------------------------------------------------------------
+struct BatchChunk
+{
+    BatchChunk()
+      : text_      ()
+      , results_   ()
+      , num_lines_ (0)
+      , done_      (false)
+    {}
+
+    std::string       text_;
+    ArgppBatchResults results_;
+    size_t            num_lines_;
+    bool              done_;
+
+  private:
+    BatchChunk(const BatchChunk &);
+    BatchChunk& operator=(const BatchChunk &);
+};
+
+//--------------------------------------------------------------------
+// The chunks waiting for a thread, and how the threads tell the
+// reading thread that a chunk is done. A thread takes the lock only
+// once for each chunk of several thousand lines, which are all about
+// as much work, so one queue is shared instead of one per thread:
+//--------------------------------------------------------------------
+class BatchChunkQueue
+{
+  public:
+    BatchChunkQueue()
+      : closed_ (false)
+    {}
+    void push(BatchChunk *c)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_.push_back(c);
+      work_cv_.notify_one();
+    }
+    ///
+    /// @brief Waits for the next chunk; returns NULL once the queue is closed.
+    ///
+    BatchChunk *pop()
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (!closed_ && pending_.empty()) {
+        work_cv_.wait(lock);
+      }
+      if (pending_.empty()) {
+        return NULL;
+      }
+      BatchChunk *c = pending_.front();
+      pending_.pop_front();
+      return c;
+    }
+    void finish(BatchChunk *c)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      c->done_ = true;
+      done_cv_.notify_one();
+    }
+    ///
+    /// @brief Stops everything because a callback threw.
+    ///
+    void fail(std::exception_ptr e)
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!error_) {
+        error_ = e;
+      }
+      closed_ = true;
+      pending_.clear();
+      work_cv_.notify_all();
+      done_cv_.notify_one();
+    }
+    ///
+    /// @brief Waits until \c c is done; returns false if a thread failed instead.
+    ///
+    bool waitFor(const BatchChunk *c)
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (!c->done_ && !error_) {
+        done_cv_.wait(lock);
+      }
+      return !error_;
+    }
+    ///
+    /// @brief Lets the threads finish; the chunks which no thread has taken are dropped.
+    ///
+    void close()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+      pending_.clear();
+      work_cv_.notify_all();
+    }
+    std::exception_ptr error()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return error_;
+    }
+
+  private:
+    std::mutex              mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::deque<BatchChunk*> pending_;
+    bool                    closed_;
+    std::exception_ptr      error_;
+
+    BatchChunkQueue(const BatchChunkQueue &);
+    BatchChunkQueue& operator=(const BatchChunkQueue &);
+};
+
+//--------------------------------------------------------------------
+// Reads about BATCH_CHUNK_SIZE bytes of in into text, up to the end
+// of a line; the beginning of the next line is kept in carry. Returns
+// false at the end of the file:
+//--------------------------------------------------------------------
+static bool readChunk(FILE *in, std::string &carry, std::string &text)
+{
+  text.swap(carry);
+  carry.clear();
+
+  for (;;) {
+    size_t old_size = text.size();
+    text.resize(old_size + BATCH_CHUNK_SIZE);
+    size_t got = fread(&text[old_size], 1, BATCH_CHUNK_SIZE, in);
+    text.resize(old_size + got);
+    if (got < BATCH_CHUNK_SIZE) {
+      break;
+    }
+    //-----------------------------------------------
+    // carry never contains a newline, so this finds
+    // the last one which was just read. If there is
+    // none, the line is longer than a chunk:
+    //-----------------------------------------------
+    size_t nl = text.rfind('\n');
+    if (nl != std::string::npos) {
+      carry.assign(text, nl + 1, std::string::npos);
+      text.resize(nl + 1);
+      break;
+    }
+  }
+  return !text.empty();
+}
+
+#endif // ARGPP_HAVE_THREADS
+
+//--------------------------------------------------------------------
+ArgppPlanImpl::ArgppPlanImpl(ArgppBase *root)
+  : nodes_   ()
+  , index_   ()
+  , strings_ ()
+  , flags_   (ArgppBaseImpl::implOf(root)->ctx_->argp_flags_ | ARGP_NO_EXIT)
+  , table_   (NULL)
+  , native_  (ArgppBaseImpl::implOf(root)->ctx_->engine_ == eng_native)
+  , group_parsers_()
+  , help_layout_  ()
+{
+  //---------------------------------------------------
+  // Let the tree set up its argp structs as it does
+  // for ArgppBase::parse(), then copy them:
+  //---------------------------------------------------
+  ArgppBaseImpl::implOf(root)->prepareParserVecs();
+  addNode(root);
+
+  //---------------------------------------------------
+  // nodes_ doesn't grow any more, so now the argp
+  // structs can point into it:
+  //---------------------------------------------------
+  for (size_t n=0; n<nodes_.size(); ++n) {
+    PlanNode &node = nodes_[n];
+    for (size_t i=0; i<node.child_nodes_.size(); ++i) {
+      node.children_[i].argp = &nodes_[node.child_nodes_[i]].argp_;
+    }
+    node.argp_.options  = node.options_.empty()  ? NULL : &node.options_[0];
+    node.argp_.children = node.children_.empty() ? NULL : &node.children_[0];
+  }
+
+  table_ = new NativeTable(&nodes_[0].argp_, flags_, NULL);
+
+  //---------------------------------------------------
+  // The groups and the nodes are both in pre-order;
+  // the groups of the default options come last and
+  // are the only ones without a node. The lifecycle
+  // keys are those the parsers have now:
+  //---------------------------------------------------
+  group_parsers_.resize(table_->groups_.size(), NULL);
+  for (size_t g=0, n=0; g<table_->groups_.size(); ++g) {
+    for (; n<nodes_.size(); ++n) {
+      if (table_->groups_[g].argp_ == &nodes_[n].argp_) {
+        group_parsers_[g] = nodes_[n].holder_;
+        table_->groups_[g].lifecycle_keys_
+            = ArgppBaseImpl::implOf(nodes_[n].holder_)->lifecycle_keys_;
+        break;
+      }
+    }
+  }
+}
+//--------------------------------------------------------------------
+ArgppPlanImpl::~ArgppPlanImpl()
+{
+  delete table_;
+}
+//--------------------------------------------------------------------
+const char *ArgppPlanImpl::copyString(const char *s)
+{
+  char *retval = NULL;
+  if (s) {
+    size_t len = strlen(s);
+    retval = static_cast<char*>(strings_.allocate(len + 1));
+    memcpy(retval, s, len + 1);
+  }
+  return retval;
+}
+//--------------------------------------------------------------------
+void ArgppPlanImpl::addNode(ArgppBase *p)
+{
+  ArgppBaseImpl *pi = ArgppBaseImpl::implOf(p);
+  size_t me = nodes_.size();
+
+  nodes_.push_back(PlanNode());
+  index_.insert(std::make_pair(static_cast<const ArgppBase*>(p), me));
+  {
+    PlanNode &node = nodes_[me];
+    node.holder_ = p;
+    node.argp_   = pi->main_argp_;
+    node.argp_.args_doc    = copyString(pi->main_argp_.args_doc);
+    node.argp_.doc         = copyString(pi->main_argp_.doc);
+    node.argp_.argp_domain = copyString(pi->main_argp_.argp_domain);
+
+    node.options_.reserve(pi->option_vec_.size());
+    for (Argp_Option_Vec::const_iterator
+         cit  = pi->option_vec_.begin();
+         cit != pi->option_vec_.end();
+         ++cit) {
+      argp_option opt = *cit;
+      opt.name = copyString(cit->name);
+      opt.arg  = copyString(cit->arg);
+      opt.doc  = copyString(cit->doc);
+      node.options_.push_back(opt);
+    }
+  }
+
+  const size_t len_children = pi->children_.size();
+  size_t num_children = 0;
+  for (size_t i=0; i<len_children; ++i) {
+    ArgppBase *pc = pi->children_[i];
+    //-----------------------------------------------
+    // Like ArgppBase::parse(), a plan leaves out the
+    // parsers of subcommands:
+    //-----------------------------------------------
+    if (ArgppBaseImpl::implOf(pc)->is_subcommand_) {
+      continue;
+    }
+    ++num_children;
+    argp_child ac = ArgppBaseImpl::implOf(pc)->child_argp_;
+    ac.argp   = NULL;
+    ac.header = copyString(ac.header);
+    {
+      PlanNode &node = nodes_[me];
+      node.children_.push_back(ac);
+      node.child_nodes_.push_back(nodes_.size());
+      node.child_inputs_.push_back(pc);
+    }
+    addNode(pc);
+  }
+  if (num_children) {
+    nodes_[me].children_.push_back(argp_child());
+  }
+}
+//--------------------------------------------------------------------
+void ArgppPlanImpl::setChildInputs(const ArgppBase *p, void **child_inputs) const
+{
+  PlanNodeIndex::const_iterator cit = index_.find(p);
+  if (cit != index_.end() && child_inputs) {
+    const std::vector<void*> &inputs = nodes_[cit->second].child_inputs_;
+    for (size_t i=0; i<inputs.size(); ++i) {
+      child_inputs[i] = inputs[i];
+    }
+  }
+}
+//--------------------------------------------------------------------
+ArgppBase *ArgppPlanImpl::argpParser(const argp *ap) const
+{
+  for (size_t g=0; g<table_->groups_.size(); ++g) {
+    if (table_->groups_[g].argp_ == ap) {
+      return group_parsers_[g];
+    }
+  }
+  return NULL;
+}
+//--------------------------------------------------------------------
+const HelpLayout &ArgppPlanImpl::helpLayout() const
+{
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+  std::call_once(help_once_, &HelpLayout::build, &help_layout_, table_->rootArgp());
+#else
+  help_layout_.build(table_->rootArgp());
+#endif
+  return help_layout_;
+}
+//--------------------------------------------------------------------
+bool ArgppPlanImpl::parse(int argc, char **argv, ArgppParseResult &result
+                          , FILE *err_stream) const
+{
+  result.clear();
+
+  result.help_called_ = ArgppBaseImpl::helpRequested(argc, argv, NULL, table_);
+
+  ParseContext &ctx = ParseContext::forPlans();
+  PlanParseScope scope(ctx, this, &result, argc, argv, result.help_called_, err_stream);
+
+  ArgppBase *root = nodes_[0].holder_;
+  error_t e = ARGPP_SUCCESS;
+  if (native_) {
+    e = nativeParse(*table_, argc, argv, &result.arg_idx_, root);
+  } else {
+    e = argp_parse(&nodes_[0].argp_, argc, argv, flags_, &result.arg_idx_, root);
+  }
+  result.retval_error_ = e;
+  result.error_code_   = ctx.error_code_from_argp_;
+  result.parsed_       = true;
+  return e == ARGPP_SUCCESS;
+}
+//--------------------------------------------------------------------
+void ArgppPlanImpl::setBadLine(ArgppParseResult &result, const char *msg)
+{
+  result.clear();
+  result.parsed_       = true;
+  result.retval_error_ = EINVAL;
+  result.error_code_   = EINVAL;
+  result.error_msg_    = msg;
+}
+//--------------------------------------------------------------------
+size_t ArgppPlanImpl::parseBatch(const ArgppCommandLines &lines, ArgppBatchSink &sink) const
+{
+  ErrorCapture errors;
+  ArgppParseResult result;
+  std::vector<char*> argv;
+  size_t n = 0;
+
+  while (n < lines.size()) {
+    const ArgppCommandLine &cmd = lines[n];
+    if (cmd.empty()) {
+      setBadLine(result, "empty command line");
+    } else {
+      //-----------------------------------------------
+      // Neither argp nor getopt write to the strings,
+      // they only permute the pointers:
+      //-----------------------------------------------
+      argv.clear();
+      for (ArgppCommandLine::const_iterator
+           cit  = cmd.begin();
+           cit != cmd.end();
+           ++cit) {
+        argv.push_back(const_cast<char*>(cit->c_str()));
+      }
+      argv.push_back(NULL);
+      parse(static_cast<int>(cmd.size()), &argv[0], result, errors.stream());
+      errors.take(result.error_msg_);
+    }
+    if (!sink.lineParsed(n++, result)) {
+      break;
+    }
+  }
+  return n;
+}
+//--------------------------------------------------------------------
+bool ArgppPlanImpl::parseLine(BatchLineState &st, const char *begin, const char *end
+                              , size_t line_no, ArgppBatchSink &sink) const
+{
+  if (!st.splitter_.split(begin, end)) {
+    setBadLine(st.result_, st.splitter_.error());
+  } else if (st.splitter_.argc() == 0) {
+    return true;
+  } else {
+    parse(st.splitter_.argc(), st.splitter_.argv(), st.result_, st.errors_.stream());
+    st.errors_.take(st.result_.error_msg_);
+  }
+  return sink.lineParsed(line_no, st.result_);
+}
+//--------------------------------------------------------------------
+bool ArgppPlanImpl::parseFile(FILE *in, ArgppBatchSink &sink, unsigned threads) const
+{
+#ifdef ARGPP_HAVE_THREADS
+  if (threads == 0) {
+    threads = std::thread::hardware_concurrency();
+  }
+  if (threads > 1) {
+    return parseFileParallel(in, sink, threads);
+  }
+#else
+  (void)threads;
+#endif
+  BatchLineState st;
+  std::string line;
+  size_t line_no = 0;
+  bool more = true;
+
+  while (more && readLine(in, line)) {
+    const char *text = line.data();
+    more = parseLine(st, text, text + line.size(), ++line_no, sink);
+  }
+  return !ferror(in);
+}
+
+#ifdef ARGPP_HAVE_THREADS
+
+//--------------------------------------------------------------------
+void ArgppPlanImpl::parseChunks(BatchChunkQueue &queue) const
+{
+  BatchLineState st;
+  while (BatchChunk *c = queue.pop()) {
+    try {
+      const char *p   = c->text_.data();
+      const char *end = p + c->text_.size();
+      size_t line_no = 0;
+      while (p < end) {
+        const char *eol = static_cast<const char*>(memchr(p, '\n', static_cast<size_t>(end - p)));
+        if (!eol) {
+          eol = end;
+        }
+        parseLine(st, p, eol, ++line_no, c->results_);
+        p = eol + 1;
+      }
+      c->num_lines_ = line_no;
+    } catch (...) {
+      queue.fail(std::current_exception());
+      return;
+    }
+    queue.finish(c);
+  }
+}
+//--------------------------------------------------------------------
+bool ArgppPlanImpl::parseFileParallel(FILE *in, ArgppBatchSink &sink, unsigned threads) const
+{
+  BatchChunkQueue queue;
+  std::vector<std::thread> workers;
+  //---------------------------------------------------
+  // The chunks which were read and not yet passed to
+  // the sink, in the order of the file:
+  //---------------------------------------------------
+  std::deque<BatchChunk*> in_flight;
+  std::exception_ptr error;
+
+  try {
+    for (unsigned t=0; t<threads; ++t) {
+      workers.push_back(std::thread(&ArgppPlanImpl::parseChunks, this, std::ref(queue)));
+    }
+
+    const size_t max_in_flight = BATCH_CHUNKS_IN_FLIGHT * threads;
+    std::string carry;
+    size_t line_base = 0;
+    bool at_eof = false;
+
+    for (;;) {
+      while (!at_eof && in_flight.size() < max_in_flight) {
+        BatchChunk *c = new BatchChunk;
+        if (!readChunk(in, carry, c->text_)) {
+          delete c;
+          at_eof = true;
+        } else {
+          in_flight.push_back(c);
+          queue.push(c);
+        }
+      }
+      if (in_flight.empty() || !queue.waitFor(in_flight.front())) {
+        break;
+      }
+
+      BatchChunk *c = in_flight.front();
+      in_flight.pop_front();
+      std::unique_ptr<BatchChunk> owner(c);
+
+      ArgppBatchResults::Lines &lines = c->results_.lines_;
+      for (size_t i=0; i<lines.size(); ++i) {
+        lines[i].line_ += line_base;
+      }
+      line_base += c->num_lines_;
+
+      if (!sink.linesParsed(c->results_)) {
+        break;
+      }
+    }
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  //---------------------------------------------------
+  // The threads may still be working on the chunks in
+  // flight, so they must be stopped first:
+  //---------------------------------------------------
+  queue.close();
+  for (size_t t=0; t<workers.size(); ++t) {
+    workers[t].join();
+  }
+  for (size_t i=0; i<in_flight.size(); ++i) {
+    delete in_flight[i];
+  }
+
+  if (!error) {
+    error = queue.error();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return !ferror(in);
+}
+
+#endif // ARGPP_HAVE_THREADS
+
+//--------------------------------------------------------------------
+// ArgppEventReaderImpl:
+//--------------------------------------------------------------------
+ArgppEventReaderImpl::ArgppEventReaderImpl(const ArgppPlanImpl &plan, int argc, char **argv)
+  : plan_  (plan)
+  , lexer_ (plan.table(), argc, argv, NULL, true)
+  , argc_  (argc)
+  , argv_  (argv)
+  , rest_  (-1)
+{}
+//--------------------------------------------------------------------
+int ArgppEventReaderImpl::index() const
+{
+  if (rest_ >= 0) {
+    return rest_ < argc_ ? rest_ : argc_;
+  }
+  int idx = lexer_.optind_ ? lexer_.optind_ : 1;
+  return idx < argc_ ? idx : argc_;
+}
+//--------------------------------------------------------------------
+bool ArgppEventReaderImpl::next(ArgppEvent &ev)
+{
+  ev = ArgppEvent();
+
+  if (rest_ < 0) {
+    //-----------------------------------------------
+    // Until an option has been read completely, the
+    // lexer's optind_ is the element it came from:
+    //-----------------------------------------------
+    int before = lexer_.optind_ ? lexer_.optind_ : 1;
+    NativeToken tok;
+    lexer_.next(tok);
+
+    switch (tok.kind_) {
+      case NativeToken::tk_option:
+        ev.kind_       = ArgppEvent::ev_option;
+        ev.key_        = tok.key_;
+        ev.arg_        = ArgppStringView(tok.arg_);
+        ev.argv_index_ = tok.arg_ ? lexer_.optind_ - 1 : before;
+        ev.parser_     = plan_.groupParser(tok.group_);
+        return true;
+      case NativeToken::tk_arg:
+        ev.kind_       = ArgppEvent::ev_arg;
+        ev.arg_        = ArgppStringView(tok.arg_);
+        ev.argv_index_ = before;
+        return true;
+      case NativeToken::tk_error:
+        ev.kind_       = ArgppEvent::ev_error;
+        ev.key_        = tok.key_;
+        ev.argv_index_ = before;
+        return true;
+      default:
+        //-------------------------------------------
+        // In order, the lexer only stops early at
+        // "--", leaving optind_ on what follows it:
+        //-------------------------------------------
+        rest_ = lexer_.optind_ ? lexer_.optind_ : 1;
+        break;
+    }
+  }
+
+  if (rest_ < argc_) {
+    ev.kind_       = ArgppEvent::ev_arg;
+    ev.arg_        = ArgppStringView(argv_[rest_]);
+    ev.argv_index_ = rest_++;
+    return true;
+  }
+  return false;
+}
+
+} // namespace impl
+} // namespace argpp
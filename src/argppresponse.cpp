@@ -0,0 +1,219 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include "argppresponse.hpp"
+#include "argppcmdline.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#  define ARGPP_HAVE_MMAP
+#endif
+
+namespace argpp {
+  namespace impl {
+
+//--------------------------------------------------------------------
+ResponseFiles::ResponseFiles()
+  : argc_       (0)
+  , argv_       (NULL)
+  , words_      ()
+  , buffers_    ()
+  , open_       ()
+  , error_path_ ()
+  , error_msg_  (NULL)
+{}
+//--------------------------------------------------------------------
+ResponseFiles::~ResponseFiles()
+{
+  release();
+}
+//--------------------------------------------------------------------
+void ResponseFiles::release()
+{
+  for (size_t i=0; i<buffers_.size(); ++i) {
+    Buffer &b = buffers_[i];
+#ifdef ARGPP_HAVE_MMAP
+    if (b.mapped_) {
+      munmap(b.data_, b.size_);
+      continue;
+    }
+#endif
+    delete [] b.data_;
+  }
+  buffers_.clear();
+  words_.clear();
+  open_.clear();
+  argc_ = 0;
+  argv_ = NULL;
+}
+//--------------------------------------------------------------------
+error_t ResponseFiles::expand(int argc, char **argv)
+{
+  release();
+  error_path_.clear();
+  error_msg_ = NULL;
+
+  bool any = false;
+  for (int i=1; i<argc && !any; ++i) {
+    any = argv[i] && argv[i][0] == '@';
+  }
+  if (!any) {
+    argc_ = argc;
+    argv_ = argv;
+    return ARGPP_SUCCESS;
+  }
+
+  words_.reserve(static_cast<size_t>(argc) + 1);
+  words_.push_back(argv[0]);
+  for (int i=1; i<argc; ++i) {
+    error_t e = expandArg(argv[i]);
+    if (e) {
+      release();
+      return e;
+    }
+  }
+  argc_ = static_cast<int>(words_.size());
+  words_.push_back(NULL);
+  argv_ = &words_[0];
+  return ARGPP_SUCCESS;
+}
+//--------------------------------------------------------------------
+error_t ResponseFiles::fail(const char *path, error_t e, const char *msg)
+{
+  error_path_ = path;
+  error_msg_  = msg;
+  return e;
+}
+//--------------------------------------------------------------------
+error_t ResponseFiles::expandArg(char *arg)
+{
+  const char *path = arg + 1;
+  struct stat st;
+
+  //---------------------------------------------------
+  // "@" alone, or a file which isn't there, is just an
+  // ordinary argument:
+  //---------------------------------------------------
+  if (arg[0] != '@' || !*path || stat(path, &st) != 0 || S_ISDIR(st.st_mode)) {
+    words_.push_back(arg);
+    return ARGPP_SUCCESS;
+  }
+
+  FileId id;
+  id.dev_  = static_cast<unsigned long long>(st.st_dev);
+  id.ino_  = static_cast<unsigned long long>(st.st_ino);
+  id.path_ = path;
+  for (size_t i=0; i<open_.size(); ++i) {
+    if (open_[i] == id) {
+      return fail(path, ELOOP, "response file includes itself");
+    }
+  }
+
+  Buffer buf;
+  error_t e = loadFile(path, buf);
+  if (e) {
+    return fail(path, e);
+  }
+  buffers_.push_back(buf);
+
+  std::vector<char*> words;
+  const char *msg = CommandLineSplitter::splitInPlace(buf.data_, buf.data_ + buf.size_, words);
+  if (msg) {
+    return fail(path, EINVAL, msg);
+  }
+
+  open_.push_back(id);
+  for (size_t i=0; i<words.size() && !e; ++i) {
+    e = expandArg(words[i]);
+  }
+  open_.pop_back();
+  return e;
+}
+//--------------------------------------------------------------------
+error_t ResponseFiles::loadFile(const char *path, Buffer &buf)
+{
+  buf.data_   = NULL;
+  buf.size_   = 0;
+  buf.mapped_ = false;
+
+#ifdef ARGPP_HAVE_MMAP
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return errno;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    error_t e = errno;
+    close(fd);
+    return e;
+  }
+  size_t size = static_cast<size_t>(st.st_size);
+  long page   = sysconf(_SC_PAGESIZE);
+
+  //---------------------------------------------------
+  // The rest of the last page reads as zeroes and can
+  // be written to, which leaves room for the last NUL:
+  //---------------------------------------------------
+  if (S_ISREG(st.st_mode) && size && page > 0 && size % static_cast<size_t>(page)) {
+    void *m = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (m != MAP_FAILED) {
+      close(fd);
+      buf.data_   = static_cast<char*>(m);
+      buf.size_   = size;
+      buf.mapped_ = true;
+      return ARGPP_SUCCESS;
+    }
+  }
+  close(fd);
+#endif
+
+  FILE *in = fopen(path, "rb");
+  if (!in) {
+    return errno;
+  }
+  std::vector<char> text;
+  char chunk[4096];
+  size_t got = 0;
+  while ((got = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+    text.insert(text.end(), chunk, chunk + got);
+  }
+  error_t e = ferror(in) ? EIO : ARGPP_SUCCESS;
+  fclose(in);
+  if (e) {
+    return e;
+  }
+  buf.data_ = new char[text.size() + 1];
+  buf.size_ = text.size();
+  if (!text.empty()) {
+    memcpy(buf.data_, &text[0], text.size());
+  }
+  return ARGPP_SUCCESS;
+}
+
+} // namespace impl
+} // namespace argpp
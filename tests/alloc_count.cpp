@@ -0,0 +1,89 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+
+//--------------------------------------------------------------------
+// Counts the heap allocations of a typical parse with the native
+// engine and a scratch buffer, and fails if there are more than
+// there used to be.
+//--------------------------------------------------------------------
+#include "testutil.hpp"
+
+using namespace argpp;
+using namespace argpp_test;
+
+//--------------------------------------------------------------------
+// The limits, as measured with libstdc++; raise them only with a good
+// reason. The first parse allocates the arrays of options and children
+// which later parses reuse, and the memory for the results:
+//--------------------------------------------------------------------
+static const unsigned long max_parse_allocs   = 9;
+static const unsigned long max_reparse_allocs = 0;
+
+static char  prog[]  = "alloc_count";
+static char  a1[]    = "--opt-0";
+static char  a2[]    = "--opt-1=one";
+static char  a3[]    = "--opt-3";
+static char  a4[]    = "two";
+static char  a5[]    = "--sub-4";
+static char  a6[]    = "input.txt";
+static char  a7[]    = "output.txt";
+static char *argv[]  = { prog, a1, a2, a3, a4, a5, a6, a7, NULL };
+static const int argc = sizeof argv / sizeof argv[0] - 1;
+
+//--------------------------------------------------------------------
+int main()
+{
+  static char scratch[16384];
+
+  ArgppBase::setParseEngine(eng_native);
+  ArgppBase::setScratchBuffer(scratch, sizeof scratch);
+
+  KeepingParser *root = Factory<KeepingParser>::createParser(argc, argv, makeOptions(20));
+  ARGPP_CHECK(root != NULL);
+  KeepingParser *child = Factory<KeepingParser>::createParser(argc, argv,
+                                                              makeOptions(10, 1100, "sub-"),
+                                                              root);
+  ARGPP_CHECK(child != NULL);
+  if (!root || !child) return result("alloc_count");
+  root->setArgpParseFlags(fl_no_exit);
+
+  unsigned long before = allocs;
+  ARGPP_CHECK(ArgppBase::parse());
+  unsigned long parse_allocs = allocs - before;
+
+  //------------------------------------------------------------------
+  // Once the tables are built and the results have their memory,
+  // parsing the same command line again should cost next to nothing:
+  //------------------------------------------------------------------
+  ARGPP_CHECK(ArgppBase::reparse(argc, argv));
+  before = allocs;
+  ARGPP_CHECK(ArgppBase::reparse(argc, argv));
+  unsigned long reparse_allocs = allocs - before;
+
+  std::printf("allocations: parse() %lu, reparse() %lu\n", parse_allocs, reparse_allocs);
+  ARGPP_CHECK(parse_allocs   <= max_parse_allocs);
+  ARGPP_CHECK(reparse_allocs <= max_reparse_allocs);
+
+  ArgppBase::clearAllParsers();
+  return result("alloc_count");
+}
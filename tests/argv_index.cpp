@@ -0,0 +1,122 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+
+//--------------------------------------------------------------------
+// Checks the argv indexes of the parsed options with both engines: in
+// clusters of short options, with arguments in the same and in the next
+// element, and after non-options which getopt moves behind them. The
+// index is that in argv once it has been permuted.
+//--------------------------------------------------------------------
+#include <cstring>
+#include <vector>
+#include "testutil.hpp"
+
+using namespace argpp;
+using namespace argpp_test;
+
+//--------------------------------------------------------------------
+// The command lines, and each parsed option as key@index:
+//--------------------------------------------------------------------
+struct IndexCase {
+    const char *args_;
+    const char *expected_;
+};
+
+static const IndexCase cases[] = {
+  { "-cb val -ba",                   "c@1 b@1 b@2 a@2" },
+  { "f2 -abc --alpha",               "a@1 b@1 c@1 a@2" },
+  { "-p f2 -aofoo -x",               "p@1 a@2 o@2 x@3" },
+  { "-x val -ba --out=z -cb",        "x@1 b@2 a@2 o@3 c@4 b@4" },
+  { "-yv -y -bx f2 -aofoo",          "y@1 y@3 a@4 o@4" },
+  { "-c -aofoo val file -ba",        "c@1 a@2 o@2 b@3 a@3" },
+  { "--out=z -xy -y val -- -abc",    "o@1 x@2 y@3" },
+  { "--beta --beta val - -ba -ab",   "b@1 b@2 b@3 a@3 a@4 b@4" },
+  { "val -abc --opt --yy=3 -c --opt", "a@1 b@1 c@1 p@2 y@3 c@4 p@5" }
+};
+static const size_t num_cases = sizeof(cases) / sizeof(cases[0]);
+
+//--------------------------------------------------------------------
+static std::string parseCase(const IndexCase &c)
+{
+  std::vector<std::string> words(1, "argv_index");
+  std::string              args(c.args_);
+  for (size_t pos = 0; pos < args.size(); ) {
+    size_t end = args.find(' ', pos);
+    if (end == std::string::npos) {
+      end = args.size();
+    }
+    words.push_back(args.substr(pos, end - pos));
+    pos = end + 1;
+  }
+  std::vector<char*> argv;
+  for (size_t i = 0; i < words.size(); ++i) {
+    argv.push_back(&words[i][0]);
+  }
+  argv.push_back(NULL);
+  int argc = static_cast<int>(words.size());
+
+  ArgppOptions opts;
+  opts.push_back(ArgppOption("alpha", 'a', NULL, 0,                   "a"));
+  opts.push_back(ArgppOption("beta",  'b', NULL, 0,                   "b"));
+  opts.push_back(ArgppOption(NULL,    'c', NULL, 0,                   "c"));
+  opts.push_back(ArgppOption("out",   'o', "F",  0,                   "o"));
+  opts.push_back(ArgppOption("opt",   'p', "V",  opt_arg_is_optional, "p"));
+  KeepingParser *root = Factory<KeepingParser>::createParser(argc, &argv[0], opts);
+
+  ArgppOptions child_opts;
+  child_opts.push_back(ArgppOption("xx", 'x', NULL, 0, "x"));
+  child_opts.push_back(ArgppOption("yy", 'y', "N",  0, "y"));
+  Factory<KeepingParser>::createParser(argc, &argv[0], child_opts, root);
+
+  ArgppBase::setArgpParseFlags(fl_no_exit);
+  std::string got;
+  if (ArgppBase::parse()) {
+    const ParsedOptionViews &views = root->getParsedOptionViews();
+    for (size_t i = 0; i < views.size(); ++i) {
+      char buf[32];
+      std::snprintf(buf, sizeof buf, "%s%c@%d", i ? " " : "", views[i].key_, views[i].argv_index_);
+      got += buf;
+    }
+  }
+  ArgppBase::clearAllParsers();
+  return got;
+}
+
+//--------------------------------------------------------------------
+int main()
+{
+  static const argpp_parse_engine engines[] = { eng_argp, eng_native };
+  for (size_t e = 0; e < 2; ++e) {
+    ArgppBase::setParseEngine(engines[e]);
+    for (size_t i = 0; i < num_cases; ++i) {
+      std::string got = parseCase(cases[i]);
+      if (got != cases[i].expected_) {
+        std::printf("%s engine, \"%s\": got \"%s\", expected \"%s\"\n"
+                    , engines[e] == eng_native ? "native" : "argp"
+                    , cases[i].args_, got.c_str(), cases[i].expected_);
+        ++failures;
+      }
+    }
+  }
+  return result("argv_index");
+}
@@ -0,0 +1,154 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+
+//--------------------------------------------------------------------
+// Builds a root parser with 1,000 children and checks that each child
+// is called with itself as argp_state::input and gets exactly its own
+// options. The argp engine only gets 100 children: getopt returns the
+// index of the child in the upper bits of the key of a long option,
+// which leaves room for fewer than 128. The children only implement
+// keyEndImpl() and say so with setLifecycleKeys(), so none of their
+// other lifecycle hooks may be called, with the tree or with a plan.
+//--------------------------------------------------------------------
+#include "testutil.hpp"
+
+using namespace argpp;
+using namespace argpp_test;
+
+static const int    first_key    = 2000;
+
+//--------------------------------------------------------------------
+// A child with the single option "--c<n>=VALUE":
+//--------------------------------------------------------------------
+class ChildParser : public ArgppBase {
+  public:
+    ChildParser(int argc, char **argv, ArgppBase *parent)
+      : ArgppBase(argc, argv, parent)
+      , inits_(0)
+      , ends_(0)
+      , wrong_input_(0)
+      , other_hooks_(0)
+    {
+      if (setLifecycleKeys(lk_all + 1)) ++other_hooks_;
+      setLifecycleKeys(lk_end);
+    }
+    int inits_;
+    int ends_;
+    int wrong_input_;
+    int other_hooks_;
+  private:
+    error_t initImpl(argp_state *state) {
+      ++inits_;
+      if (state->input != this) ++wrong_input_;
+      return ARGPP_SUCCESS;
+    }
+    error_t keyEndImpl(argp_state *state) {
+      ++ends_;
+      if (state->input != this) ++wrong_input_;
+      return ARGPP_SUCCESS;
+    }
+    error_t keyNoArgsImpl (argp_state *) { ++other_hooks_; return ARGPP_DONT_CARE; }
+    error_t keySuccessImpl(argp_state *) { ++other_hooks_; return ARGPP_DONT_CARE; }
+    error_t finiImpl      (argp_state *) { ++other_hooks_; return ARGPP_DONT_CARE; }
+    error_t parserImpl(int key, const char *arg, argp_state *state) {
+      if (state->input != this) ++wrong_input_;
+      return genericParserImpl(key, arg, state);
+    }
+};
+
+//--------------------------------------------------------------------
+static void run(argpp_parse_engine engine, size_t num_children)
+{
+  static char prog[] = "children_test";
+
+  //------------------------------------------------------------------
+  // Every seventh child gets its option, in reverse order:
+  //------------------------------------------------------------------
+  std::vector<std::string> words;
+  for (size_t i = num_children; i-- > 0; ) {
+    if (i % 7 == 3) words.push_back(numbered("--c", i) + numbered("=v", i));
+  }
+  std::vector<char*> argv;
+  argv.push_back(prog);
+  for (size_t i = 0; i < words.size(); ++i) {
+    argv.push_back(&words[i][0]);
+  }
+  argv.push_back(NULL);
+  int argc = static_cast<int>(argv.size() - 1);
+
+  ArgppBase::setParseEngine(engine);
+  ArgppBase::setRootHasParsedOptions(false);
+  TestParser *root = Factory<TestParser>::createParser(argc, &argv[0]);
+  ARGPP_CHECK(root != NULL);
+  if (!root) return;
+  root->setArgpParseFlags(fl_no_exit);
+
+  std::vector<ChildParser*> children;
+  for (size_t i = 0; i < num_children; ++i) {
+    ArgppOptions opts;
+    std::string  name = numbered("c", i);
+    opts.push_back(ArgppOption(name.c_str(), first_key + static_cast<int>(i),
+                               "VALUE", 0, "An option of one child"));
+    children.push_back(Factory<ChildParser>::createParser(argc, &argv[0], opts, root));
+    ARGPP_CHECK(children.back() != NULL);
+    if (!children.back()) return;
+  }
+
+  ARGPP_CHECK(ArgppBase::parse());
+  {
+    ArgppPlan        plan(root);
+    ArgppParseResult result;
+    ARGPP_CHECK(plan.parse(argc, &argv[0], result));
+  }
+
+  size_t bad = 0;
+  for (size_t i = 0; i < num_children; ++i) {
+    const ChildParser   *child = children[i];
+    const ParsedOptions &opts  = child->getParsedOptions();
+    bool ok = child->inits_ == 2 && child->ends_ == 2
+              && child->wrong_input_ == 0 && child->other_hooks_ == 0;
+    if (i % 7 == 3) {
+      ok = ok && opts.size() == 1
+              && opts[0].key_ == first_key + static_cast<int>(i)
+              && opts[0].arg_ == numbered("v", i);
+    } else {
+      ok = ok && opts.empty();
+    }
+    if (!ok) ++bad;
+  }
+  std::printf("%s engine: %lu of %lu children wrong\n",
+              engine == eng_native ? "native" : "argp",
+              static_cast<unsigned long>(bad),
+              static_cast<unsigned long>(num_children));
+  ARGPP_CHECK(bad == 0);
+
+  ArgppBase::clearAllParsers();
+}
+
+//--------------------------------------------------------------------
+int main()
+{
+  run(eng_argp,   100);
+  run(eng_native, 1000);
+  return result("children_test");
+}
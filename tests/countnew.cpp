@@ -0,0 +1,89 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+
+//--------------------------------------------------------------------
+// Replaces the global operator new and operator delete with versions
+// which count the blocks taken from the heap; see testutil.hpp.
+//--------------------------------------------------------------------
+#include <cstdlib>
+#include <new>
+#include "testutil.hpp"
+
+namespace argpp_test {
+  unsigned long allocs      = 0;
+  long          live_blocks = 0;
+}
+
+#if __cplusplus >= 201103L
+#define THROWS_BAD_ALLOC
+#define NO_THROW noexcept
+#else
+#define THROWS_BAD_ALLOC throw(std::bad_alloc)
+#define NO_THROW throw()
+#endif
+
+void* operator new(size_t size) THROWS_BAD_ALLOC
+{
+  void *p = std::malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  ++argpp_test::allocs;
+  ++argpp_test::live_blocks;
+  return p;
+}
+
+void* operator new[](size_t size) THROWS_BAD_ALLOC
+{
+  return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) NO_THROW
+{
+  void *p = std::malloc(size ? size : 1);
+  if (p) {
+    ++argpp_test::allocs;
+    ++argpp_test::live_blocks;
+  }
+  return p;
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) NO_THROW
+{
+  return operator new(size, std::nothrow);
+}
+
+static void release(void *p)
+{
+  if (p) {
+    --argpp_test::live_blocks;
+    std::free(p);
+  }
+}
+
+void operator delete(void *p) NO_THROW                         { release(p); }
+void operator delete[](void *p) NO_THROW                       { release(p); }
+void operator delete(void *p, const std::nothrow_t&) NO_THROW   { release(p); }
+void operator delete[](void *p, const std::nothrow_t&) NO_THROW { release(p); }
+#if __cpp_sized_deallocation
+void operator delete(void *p, size_t) NO_THROW                 { release(p); }
+void operator delete[](void *p, size_t) NO_THROW               { release(p); }
+#endif
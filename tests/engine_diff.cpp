@@ -0,0 +1,243 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+
+//--------------------------------------------------------------------
+// Parses the same command lines with the argp engine and with the
+// native engine and compares everything the parsers see: the keys and
+// arguments of the callbacks, argp_state::next, arg_num and the order
+// of argv, the messages printed, the return values and the exit code.
+// Each parse runs in a child process, since argp may call exit().
+//--------------------------------------------------------------------
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "testutil.hpp"
+
+using namespace argpp;
+using namespace argpp_test;
+
+//--------------------------------------------------------------------
+// What a case changes besides the command line:
+//--------------------------------------------------------------------
+enum {
+  root_args    = 1,  // the root takes the non-option arguments
+  child_stops  = 2,  // the child refuses its second argument
+  with_version = 4,  // the root has --version
+  posixly      = 8   // POSIXLY_CORRECT is set
+};
+
+static unsigned variant = 0;
+
+static void trace(const char *who, const char *what, const argp_state *s, const char *arg)
+{
+  std::printf("%s %s arg=%s next=%d argnum=%u argc=%d |",
+              who, what, arg ? arg : "(null)", s->next, s->arg_num, s->argc);
+  for (int i = 0; i < s->argc; ++i) {
+    std::printf(" %s", s->argv[i]);
+  }
+  std::printf("\n");
+}
+
+#define TRACE_HOOKS(WHO)                                                                     \
+  error_t initImpl      (argp_state *s) { trace(WHO, "INIT",    s, NULL); return ARGPP_DONT_CARE; } \
+  error_t errorImpl     (argp_state *s) { trace(WHO, "ERROR",   s, NULL); return ARGPP_DONT_CARE; } \
+  error_t finiImpl      (argp_state *s) { trace(WHO, "FINI",    s, NULL); return ARGPP_DONT_CARE; } \
+  error_t keyArgsImpl   (argp_state *s) { trace(WHO, "ARGS",    s, NULL); return ARGPP_DONT_CARE; } \
+  error_t keyNoArgsImpl (argp_state *s) { trace(WHO, "NOARGS",  s, NULL); return ARGPP_DONT_CARE; } \
+  error_t keySuccessImpl(argp_state *s) { trace(WHO, "SUCCESS", s, NULL); return ARGPP_DONT_CARE; } \
+  error_t keyEndImpl    (argp_state *s) { trace(WHO, "END",     s, NULL); return ARGPP_DONT_CARE; }
+
+class RootParser : public ArgppBase {
+  public:
+    RootParser(int argc, char **argv, ArgppBase *parent)
+      : ArgppBase(argc, argv, parent)
+    {}
+  private:
+    TRACE_HOOKS("R")
+    error_t keyArgImpl(const char *arg, argp_state *s) {
+      trace("R", "ARG", s, arg);
+      return (variant & root_args) ? ArgppBase::keyArgImpl(arg, s) : ARGPP_DONT_CARE;
+    }
+    error_t parserImpl(int key, const char *arg, argp_state *s) {
+      std::string what = numbered("opt", static_cast<size_t>(key));
+      trace("R", what.c_str(), s, arg);
+      if (key == 'e') argp_error(s, "bad %s", arg ? arg : "");
+      return ARGPP_SUCCESS;
+    }
+};
+
+class ChildParser : public ArgppBase {
+  public:
+    ChildParser(int argc, char **argv, ArgppBase *parent)
+      : ArgppBase(argc, argv, parent)
+    {}
+  private:
+    TRACE_HOOKS("C")
+    error_t keyArgImpl(const char *arg, argp_state *s) {
+      trace("C", "ARG", s, arg);
+      if ((variant & child_stops) && s->arg_num == 1) return ARGPP_DONT_CARE;
+      return ArgppBase::keyArgImpl(arg, s);
+    }
+    error_t parserImpl(int key, const char *arg, argp_state *s) {
+      std::string what = numbered("opt", static_cast<size_t>(key));
+      trace("C", what.c_str(), s, arg);
+      return ARGPP_SUCCESS;
+    }
+};
+
+//--------------------------------------------------------------------
+// Builds the tree and parses argv; runs in the child process:
+//--------------------------------------------------------------------
+static void parseOnce(argpp_parse_engine engine, unsigned flags, int argc, char **argv)
+{
+  ArgppBase::setParseEngine(engine);
+  RootParser *root = Factory<RootParser>::createParser(argc, argv);
+  ArgppOptions ro;
+  ro.push_back(ArgppOption("alpha",     'a',  NULL,  0,                    "alpha"));
+  ro.push_back(ArgppOption("all",       'A',  NULL,  opt_is_alias));
+  ro.push_back(ArgppOption("beta",      'b',  "ARG", 0,                    "beta"));
+  ro.push_back(ArgppOption("beta-long", 'c',  "OPT", opt_arg_is_optional,  "bl"));
+  ro.push_back(ArgppOption("long",      1000, NULL,  0,                    "lo"));
+  ro.push_back(ArgppOption("lang",      1001, "X",   0,                    "la"));
+  ro.push_back(ArgppOption("err",       'e',  "E",   0,                    "err"));
+  root->addOptions(ro);
+  if (variant & with_version) root->installProgVersion("1.0");
+
+  ChildParser *child = Factory<ChildParser>::createParser();
+  ArgppOptions co;
+  co.push_back(ArgppOption("xray",     'x', NULL, 0, "x"));
+  co.push_back(ArgppOption("yank",     'y', "Y",  0, "y"));
+  co.push_back(ArgppOption("alphabet", 'a', NULL, 0, "dup"));
+  child->addOptions(co);
+
+  ArgppBase::setArgpParseFlags(flags);
+  bool ok = ArgppBase::parse();
+  std::printf("ok=%d ret=%d code=%d\n", ok,
+              ArgppBase::getRetvalErrorFromArgpParse(), ArgppBase::getErrorCodeFromArgp());
+  ArgppBase::clearAllParsers();
+}
+
+//--------------------------------------------------------------------
+// Returns all that parseOnce() wrote to stdout and stderr, and how it
+// exited:
+//--------------------------------------------------------------------
+static std::string run(argpp_parse_engine engine, unsigned flags, const char *line)
+{
+  //------------------------------------------------------------------
+  // Split the command line at blanks; the words live in the child:
+  //------------------------------------------------------------------
+  std::string              copy(line);
+  std::vector<std::string> words(1, "engine_diff");
+  for (size_t pos = 0; pos < copy.size(); ) {
+    size_t end = copy.find(' ', pos);
+    if (end == std::string::npos) end = copy.size();
+    if (end > pos) words.push_back(copy.substr(pos, end - pos));
+    pos = end + 1;
+  }
+
+  int fds[2];
+  if (pipe(fds) != 0) return "pipe failed";
+  std::fflush(stdout);
+  std::fflush(stderr);
+  pid_t pid = fork();
+  if (pid < 0) return "fork failed";
+  if (pid == 0) {
+    close(fds[0]);
+    dup2(fds[1], 1);
+    dup2(fds[1], 2);
+    setenv("COLUMNS", "80", 1);
+    unsetenv("ARGP_HELP_FMT");
+    if (variant & posixly) {
+      setenv("POSIXLY_CORRECT", "1", 1);
+    } else {
+      unsetenv("POSIXLY_CORRECT");
+    }
+    std::vector<char*> argv;
+    for (size_t i = 0; i < words.size(); ++i) {
+      argv.push_back(&words[i][0]);
+    }
+    argv.push_back(NULL);
+    parseOnce(engine, flags, static_cast<int>(words.size()), &argv[0]);
+    std::fflush(stdout);
+    std::fflush(stderr);
+    _exit(0);
+  }
+  close(fds[1]);
+  std::string out;
+  char        buf[4096];
+  ssize_t     n;
+  while ((n = read(fds[0], buf, sizeof buf)) > 0) {
+    out.append(buf, static_cast<size_t>(n));
+  }
+  close(fds[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  char rc[32];
+  std::sprintf(rc, "rc=%d\n", WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+  return out + rc;
+}
+
+//--------------------------------------------------------------------
+int main()
+{
+  static const char *lines[] = {
+    "", "-a", "-ax f1 -b v f2", "-bv -c", "--beta-long=1 --beta-long 2 --bet", "--b",
+    "--be x", "--al --all --alph", "--l", "--lo", "--la q", "-long", "-lang=z",
+    "f1 -- -a f2", "f1 - -x", "-q", "--nope", "--alpha=3", "-b", "--beta", "--yank",
+    "-y", "f1 f2 f3 f4", "-e boom", "--help", "-?", "--usage", "--version", "-V",
+    "--program-name=foo", "--progr x", "-xa -- f", "--a", "-a -- --", "--alphabet",
+    "--HANG=0", "--hang"
+  };
+  static const unsigned flag_sets[] = {
+    0, 0x1, 0x2, 0x4, 0x8, 0x10, 0x20, 0x40, 0x80, 0x22, 0x28, 0x24, 0x41, 0x48, 0x62, 0x2a
+  };
+  static const unsigned variants[] = {
+    0, posixly, root_args, child_stops, with_version, root_args | child_stops
+  };
+  static const size_t num_lines    = sizeof lines     / sizeof lines[0];
+  static const size_t num_flags    = sizeof flag_sets / sizeof flag_sets[0];
+  static const size_t num_variants = sizeof variants  / sizeof variants[0];
+
+  size_t cases = 0, different = 0;
+  for (size_t f = 0; f < num_flags; ++f) {
+    for (size_t v = 0; v < num_variants; ++v) {
+      variant = variants[v];
+      for (size_t l = 0; l < num_lines; ++l) {
+        std::string a = run(eng_argp,   flag_sets[f], lines[l]);
+        std::string n = run(eng_native, flag_sets[f], lines[l]);
+        ++cases;
+        if (a != n) {
+          if (++different <= 5) {
+            std::printf("flags 0x%x, variant %u, \"%s\":\n--- argp:\n%s--- native:\n%s",
+                        flag_sets[f], variant, lines[l], a.c_str(), n.c_str());
+          }
+        }
+      }
+    }
+  }
+  std::printf("%lu of %lu cases differ\n",
+              static_cast<unsigned long>(different), static_cast<unsigned long>(cases));
+  ARGPP_CHECK(different == 0);
+  return result("engine_diff");
+}
@@ -0,0 +1,252 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+
+//--------------------------------------------------------------------
+// Compares the help which the library formats itself with that of
+// argp_state_help(), for trees of parsers made up from fixed seeds:
+// option names and words which end near the right margin, arguments,
+// aliases, hidden and documentation options, groups, headers, usage
+// patterns and doc strings. Each tree is compared with every kind of
+// help at the end of a parse with the argp engine.
+//
+// argp looks at the byte past the end of its buffer when a word ends
+// right at the margin, and that byte is whatever an earlier allocation
+// left there. So that it can't be a blank, as in the buffer of the
+// library, the program runs itself again with the thread cache of
+// glibc's malloc turned off and new allocations zeroed.
+//--------------------------------------------------------------------
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include "testutil.hpp"
+
+using namespace argpp;
+using namespace argpp_test;
+
+static const size_t num_trees = 300;
+static size_t       tree      = 0;
+
+static const unsigned flag_sets[] = {
+  ARGP_HELP_STD_HELP & ~ARGP_HELP_EXIT_OK,
+  ARGP_HELP_USAGE,
+  ARGP_HELP_SHORT_USAGE | ARGP_HELP_SEE,
+  ARGP_HELP_LONG | ARGP_HELP_DOC | ARGP_HELP_BUG_ADDR,
+  ARGP_HELP_USAGE | ARGP_HELP_LONG | ARGP_HELP_DOC
+};
+static const size_t num_flag_sets = sizeof(flag_sets) / sizeof(flag_sets[0]);
+
+//--------------------------------------------------------------------
+// A linear congruential generator, so that the trees are the same
+// everywhere:
+//--------------------------------------------------------------------
+static unsigned long seed = 1;
+
+static int rnd(int n)
+{
+  seed = (seed * 1103515245UL + 12345UL) & 0xffffffffUL;
+  return static_cast<int>((seed >> 8) % static_cast<unsigned long>(n));
+}
+
+static std::string words(int max_words)
+{
+  static const char *word[] = {
+    "foo", "bar", "a", "mediumlongwordthatgoesonandon", "x", "the",
+    "option", "Z", "-", "b", "alpha beta", "gamma\n", "list,"
+  };
+  std::string text;
+  int n = rnd(max_words);
+  for (int i = 0; i < n; ++i) {
+    if (i) {
+      text += rnd(10) ? " " : "\n";
+    }
+    text += word[rnd(sizeof(word) / sizeof(word[0]))];
+  }
+  return text;
+}
+
+static const char *longName()
+{
+  static const char *name[] = {
+    "alpha", "beta", "Alpha", "gamma", "delta-x", "b", "zeta", "a", "ZZ",
+    "exactly-long-enough-to-reach", "verylongoptionnamethatismuchwiderthanthecolumn"
+  };
+  return name[rnd(sizeof(name) / sizeof(name[0]))];
+}
+
+static ArgppOptions makeRandomOptions(size_t max_options)
+{
+  ArgppOptions opts;
+  int n = rnd(static_cast<int>(max_options));
+  for (int i = 0; i < n; ++i) {
+    if (rnd(6) == 0) {
+      //-----------------------------------------------
+      // A header:
+      //-----------------------------------------------
+      std::string doc = rnd(3) ? words(4) : std::string("Header:");
+      opts.push_back(ArgppOption(NULL, 0, NULL, 0, doc.c_str(), rnd(3) ? 0 : rnd(5) - 1));
+      continue;
+    }
+    const char *name = rnd(4) ? longName() : NULL;
+    int         key  = rnd(3) ? "abcdefxyzABC0#"[rnd(14)] : 1000 + rnd(100);
+    if (!name && key >= 1000) {
+      key = 'q';
+    }
+    const char *arg = rnd(2) ? (rnd(3) ? "ARG" : "LONGERARGUMENTNAME") : NULL;
+
+    unsigned flags = 0;
+    if (i > 0 && rnd(4) == 0) flags |= opt_is_alias;
+    if (rnd(6) == 0)          flags |= opt_is_hidden;
+    if (rnd(5) == 0)          flags |= opt_arg_is_optional;
+    if (rnd(8) == 0)          flags |= opt_is_doc;
+    if (rnd(8) == 0)          flags |= opt_not_in_usage;
+
+    std::string doc = rnd(5) ? words(rnd(2) ? 8 : 40) : std::string();
+    opts.push_back(ArgppOption(name, key, arg, flags, doc.empty() ? NULL : doc.c_str(),
+                               rnd(4) ? 0 : rnd(7) - 2));
+  }
+  return opts;
+}
+
+//--------------------------------------------------------------------
+// The root compares the help of the tree with that of argp at the end
+// of the parse:
+//--------------------------------------------------------------------
+class GoldenParser : public ArgppBase {
+  public:
+    GoldenParser(int argc, char **argv, ArgppBase *parent)
+      : ArgppBase(argc, argv, parent)
+    {}
+  private:
+    error_t parserImpl(int, const char *, argp_state *) {
+      return ARGPP_DONT_CARE;
+    }
+    error_t keyEndImpl(argp_state *state) {
+      if (!getParent()) {
+        for (size_t i = 0; i < num_flag_sets; ++i) {
+          compareHelp(state, flag_sets[i]);
+        }
+      }
+      return ARGPP_DONT_CARE;
+    }
+    static void compareHelp(argp_state *state, unsigned flags);
+};
+
+//--------------------------------------------------------------------
+void GoldenParser::compareHelp(argp_state *state, unsigned flags)
+{
+  std::string ours;
+  argppStateHelp(state, ours, flags);
+
+  char   *text = NULL;
+  size_t  size = 0;
+  FILE   *out  = open_memstream(&text, &size);
+  if (!out) {
+    ARGPP_CHECK(out != NULL);
+    return;
+  }
+  argp_state_help(state, out, flags);
+  std::fclose(out);
+  std::string theirs(text, size);
+  std::free(text);
+
+  if (ours != theirs) {
+    size_t pos  = 0;
+    size_t line = 1;
+    while (pos < ours.size() && pos < theirs.size() && ours[pos] == theirs[pos]) {
+      if (ours[pos++] == '\n') {
+        ++line;
+      }
+    }
+    std::fprintf(stderr, "tree %lu, flags 0x%x: the help differs from line %lu on\n"
+                 "--- argp:\n%s--- library:\n%s---\n",
+                 static_cast<unsigned long>(tree), flags, static_cast<unsigned long>(line),
+                 theirs.c_str(), ours.c_str());
+    ++failures;
+  }
+}
+
+//--------------------------------------------------------------------
+// Makes up a parser, and below \c parent up to two levels of children:
+//--------------------------------------------------------------------
+static void makeTree(int argc, char **argv, ArgppBase *parent, int depth)
+{
+  GoldenParser *p = Factory<GoldenParser>::createParser(
+      argc, argv, makeRandomOptions(depth == 0 ? 12 : 7), parent);
+  if (!p) {
+    ++failures;
+    return;
+  }
+  if (rnd(3)) {
+    p->setUsageMessage(rnd(2) ? words(3) : std::string(rnd(2) ? "ARG1 ARG2\nOTHER\n-x X" : "FILE..."));
+  }
+  if (rnd(2)) {
+    std::string doc = words(20);
+    if (rnd(2)) {
+      doc += "\v" + words(20);
+    }
+    p->setDocMessage(doc);
+  }
+  if (parent) {
+    if (rnd(3) == 0) {
+      p->setGroup(rnd(6) - 2);
+    }
+    if (rnd(3) == 0) {
+      p->setChildHeader(rnd(4) ? words(5) : std::string(), true);
+    }
+  }
+  if (depth < 2) {
+    for (int n = rnd(depth == 0 ? 4 : 3); n > 0; --n) {
+      makeTree(argc, argv, p, depth + 1);
+    }
+  }
+}
+
+//--------------------------------------------------------------------
+int main(int, char **argv)
+{
+#ifdef __GLIBC__
+  static const char tunables[] = "glibc.malloc.tcache_count=0:glibc.malloc.perturb=255";
+  const char *set = std::getenv("GLIBC_TUNABLES");
+  if (!set || std::strcmp(set, tunables) != 0) {
+    setenv("GLIBC_TUNABLES", tunables, 1);
+    execv("/proc/self/exe", argv);
+    std::printf("help_golden: skipped, can't run itself again\n");
+    return 77;
+  }
+#endif
+  ArgppBase::setParseEngine(eng_argp);
+
+  char  name[] = "golden";
+  char *args[] = { name, NULL };
+  for (tree = 0; tree < num_trees; ++tree) {
+    seed = tree * 7919 + 1;
+    argp_program_bug_address = rnd(2) ? "<bugs@example.org>" : NULL;
+    makeTree(1, args, NULL, 0);
+    ArgppBase::setArgpParseFlags(fl_no_exit);
+    ArgppBase::parse();
+    ArgppBase::clearAllParsers();
+  }
+  std::printf("help_golden: %lu trees compared with %lu kinds of help\n",
+              static_cast<unsigned long>(num_trees), static_cast<unsigned long>(num_flag_sets));
+  return result("help_golden");
+}
@@ -0,0 +1,212 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+
+//--------------------------------------------------------------------
+// Checks with both engines that "--help=PATTERN" and "--help-group=N"
+// are options like any other: getopt hands them over where they are
+// options, an option which takes an argument gets them as its argument,
+// and an option of the program with the same name wins. The root sends
+// what the parse prints to memory streams, so that the text of each
+// search and of each error is compared as well.
+//--------------------------------------------------------------------
+#include <cstdlib>
+#include <vector>
+#include "testutil.hpp"
+
+using namespace argpp;
+using namespace argpp_test;
+
+//--------------------------------------------------------------------
+// The command lines, with or without a child which has an option
+// --help-group of its own (key 'H'); whether the parse succeeds; the
+// options which the tree has parsed as key or key=arg; whether it is
+// a request for help; and what is printed to out_stream and err_stream:
+//--------------------------------------------------------------------
+struct SearchCase {
+    const char *args_;
+    bool        own_group_;
+    bool        ok_;
+    const char *parsed_;
+    bool        help_;
+    const char *out_;
+    const char *err_;
+};
+
+static const char verbose_line[] = "  -v, --verbose              Be verbose\n";
+static const char out_lines[]    =
+    "  -o, --out=FILE             Output file\n"
+    "\n"
+    "Mandatory or optional arguments to long options are also mandatory or optional\n"
+    "for any corresponding short options.\n";
+static const char try_line[]     =
+    "Try `help_search --help' or `help_search --usage' for more information.\n";
+
+static const SearchCase cases[] = {
+  { "-o --help=foo",           false, true,  "o=--help=foo",       false, "",           "" },
+  { "--out --help-group=3 -v", false, true,  "o=--help-group=3 v", false, "",           "" },
+  { "-vo --help",              false, true,  "v o=--help",         false, "",           "" },
+  { "-v -- --help=foo",        false, true,  "v",                  false, "",           "" },
+  { "--help=verb -v",          false, true,  "v",                  true,  verbose_line, "" },
+  { "--he=OUT",                false, true,  "",                   true,  out_lines,    "" },
+  { "--help-g=1 -o x",         false, true,  "o=x",                true,  verbose_line, "" },
+  { "--help-group 1 -o x",     false, true,  "o=x",                true,  verbose_line, "" },
+  { "-o x --help-g 1",         false, true,  "o=x",                true,  verbose_line, "" },
+  { "--help=zzz",              false, false, "",                   true,  "",
+    "help_search: no options match `zzz'\n" },
+  { "--help-group=7",          false, false, "",                   true,  "",
+    "help_search: no options in group 7\n" },
+  { "--help-group=x",          false, false, "",                   true,  "",
+    "help_search: invalid help group `x'\n" },
+  { "-v --help-group",         false, false, "v",                  true,  "",
+    "help_search: option '--help-group' requires an argument\n" },
+  { "--help-group=3",          true,  true,  "H=3",                false, "",           "" },
+  { "-v --help-gr 2",          true,  true,  "v H=2",              false, "",           "" },
+  { "--help=out",              true,  true,  "",                   true,  out_lines,    "" }
+};
+static const size_t num_cases = sizeof(cases) / sizeof(cases[0]);
+
+//--------------------------------------------------------------------
+// The root makes the parse print to memory streams:
+//--------------------------------------------------------------------
+static FILE *out_stream = NULL;
+static FILE *err_stream = NULL;
+
+class StreamParser : public KeepingParser {
+  public:
+    StreamParser(int argc, char **argv, ArgppBase *parent)
+      : KeepingParser(argc, argv, parent)
+    {}
+  private:
+    error_t initImpl(argp_state *state) {
+      if (!getParent()) {
+        state->out_stream = out_stream;
+        state->err_stream = err_stream;
+      }
+      return ARGPP_DONT_CARE;
+    }
+};
+
+//--------------------------------------------------------------------
+static std::string parsed(ArgppBase *p)
+{
+  std::string text;
+  const ParsedOptions &opts = p->getParsedOptions();
+  for (size_t i = 0; i < opts.size(); ++i) {
+    if (i) {
+      text += ' ';
+    }
+    text += static_cast<char>(opts[i].key_);
+    if (!opts[i].arg_.empty()) {
+      text += "=" + opts[i].arg_;
+    }
+  }
+  return text;
+}
+
+//--------------------------------------------------------------------
+static std::string closeStream(FILE *stream, char **text, size_t *size)
+{
+  std::fclose(stream);
+  std::string contents(*text ? *text : "", *size);
+  std::free(*text);
+  return contents;
+}
+
+//--------------------------------------------------------------------
+static bool parseCase(const SearchCase &c)
+{
+  std::vector<std::string> words(1, "help_search");
+  std::string              args(c.args_);
+  for (size_t pos = 0; pos < args.size(); ) {
+    size_t end = args.find(' ', pos);
+    if (end == std::string::npos) {
+      end = args.size();
+    }
+    words.push_back(args.substr(pos, end - pos));
+    pos = end + 1;
+  }
+  std::vector<char*> argv;
+  for (size_t i = 0; i < words.size(); ++i) {
+    argv.push_back(&words[i][0]);
+  }
+  argv.push_back(NULL);
+  int argc = static_cast<int>(words.size());
+
+  ArgppOptions opts;
+  opts.push_back(ArgppOption("out",     'o', "FILE", 0, "Output file"));
+  opts.push_back(ArgppOption("verbose", 'v', NULL,   0, "Be verbose", 1));
+  StreamParser *root = Factory<StreamParser>::createParser(argc, &argv[0], opts);
+  if (c.own_group_) {
+    ArgppOptions child_opts;
+    child_opts.push_back(ArgppOption("help-group", 'H', "N", 0, "The program's own"));
+    Factory<KeepingParser>::createParser(argc, &argv[0], child_opts, root);
+  }
+
+  char   *out_text = NULL;
+  char   *err_text = NULL;
+  size_t  out_size = 0;
+  size_t  err_size = 0;
+  out_stream = open_memstream(&out_text, &out_size);
+  err_stream = open_memstream(&err_text, &err_size);
+  if (!out_stream || !err_stream) {
+    ARGPP_CHECK(out_stream && err_stream);
+    return false;
+  }
+
+  ArgppBase::setArgpParseFlags(fl_no_exit);
+  const bool        ok   = ArgppBase::parse();
+  const std::string got  = parsed(root);
+  const bool        help = ArgppBase::wasHelpEntered();
+  const std::string out  = closeStream(out_stream, &out_text, &out_size);
+  const std::string err  = closeStream(err_stream, &err_text, &err_size);
+  ArgppBase::clearAllParsers();
+
+  std::string expected_err(c.err_);
+  if (!expected_err.empty()) {
+    expected_err += try_line;
+  }
+  if (ok == c.ok_ && got == c.parsed_ && help == c.help_ && out == c.out_ && err == expected_err) {
+    return true;
+  }
+  std::printf("\"%s\": parse %d, parsed \"%s\", help %d\n--- out:\n%s--- err:\n%s---\n"
+              , c.args_, ok ? 1 : 0, got.c_str(), help ? 1 : 0, out.c_str(), err.c_str());
+  return false;
+}
+
+//--------------------------------------------------------------------
+int main()
+{
+  static const argpp_parse_engine engines[] = { eng_argp, eng_native };
+  for (size_t e = 0; e < 2; ++e) {
+    ArgppBase::setParseEngine(engines[e]);
+    for (size_t i = 0; i < num_cases; ++i) {
+      if (!parseCase(cases[i])) {
+        std::printf("  with the %s engine, expected parse %d, \"%s\", help %d\n"
+                    , engines[e] == eng_native ? "native" : "argp"
+                    , cases[i].ok_ ? 1 : 0, cases[i].parsed_, cases[i].help_ ? 1 : 0);
+        ++failures;
+      }
+    }
+  }
+  return result("help_search");
+}
@@ -0,0 +1,106 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+
+//--------------------------------------------------------------------
+// Looks up options by key and by long name in parsers with 10 to
+// 10,000 options. The time per lookup must not grow with the number
+// of options (beyond what the caches of the machine account for).
+//--------------------------------------------------------------------
+#include "testutil.hpp"
+
+using namespace argpp;
+using namespace argpp_test;
+
+//--------------------------------------------------------------------
+// The number of lookups per measurement and of measurements per size;
+// the fastest measurement counts:
+//--------------------------------------------------------------------
+static const size_t lookups = 200000;
+static const int    rounds  = 5;
+
+//--------------------------------------------------------------------
+// Returns the time of one lookup in nanoseconds:
+//--------------------------------------------------------------------
+static double measure(size_t n, bool by_name)
+{
+  static char  prog[] = "lookup_bench";
+  static char *argv[] = { prog, NULL };
+
+  TestParser *root = Factory<TestParser>::createParser(1, argv, makeOptions(n));
+  ARGPP_CHECK(root != NULL);
+  if (!root) return 0.0;
+
+  std::vector<std::string> names;
+  for (size_t i = 0; i < n; ++i) {
+    names.push_back(numbered("opt-", i));
+  }
+
+  double best = 0.0;
+  for (int r = 0; r < rounds; ++r) {
+    size_t found = 0;
+    ArgppOption opt;
+    double start = now();
+    for (size_t i = 0; i < lookups; ++i) {
+      size_t k = (i * 7919) % n;
+      if (by_name ? root->findOption(names[k], opt)
+                  : root->findOption(1000 + static_cast<int>(k), opt)) {
+        ++found;
+      }
+    }
+    double t = (now() - start) * 1e9 / lookups;
+    ARGPP_CHECK(found == lookups);
+    if (r == 0 || t < best) best = t;
+  }
+
+  ArgppOption opt;
+  ARGPP_CHECK(!root->findOption(1000 + static_cast<int>(n), opt));
+  ARGPP_CHECK(!root->findOption(std::string("no-such-option"), opt));
+
+  ArgppBase::clearAllParsers();
+  return best;
+}
+
+//--------------------------------------------------------------------
+int main()
+{
+  static const size_t sizes[] = { 10, 100, 1000, 10000 };
+  static const size_t count   = sizeof sizes / sizeof sizes[0];
+
+  for (int by_name = 0; by_name < 2; ++by_name) {
+    double first = 0.0, last = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+      double t = measure(sizes[i], by_name != 0);
+      std::printf("findOption(%s) with %5lu options: %8.1f ns\n",
+                  by_name ? "name" : "key ",
+                  static_cast<unsigned long>(sizes[i]), t);
+      if (i == 0) first = t;
+      last = t;
+    }
+    //----------------------------------------------------------------
+    // A linear search takes about 1,000 times as long with 10,000
+    // options as with 10:
+    //----------------------------------------------------------------
+    ARGPP_CHECK(last < 10.0 * first + 100.0);
+  }
+  return result("lookup_bench");
+}
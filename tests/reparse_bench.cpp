@@ -0,0 +1,111 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+
+//--------------------------------------------------------------------
+// Re-parses two command lines in turn one million times with the same
+// tree of parsers. The number of live heap blocks and the resident
+// set size must be the same at the end as after the first thousand.
+//--------------------------------------------------------------------
+#include <unistd.h>
+#include "testutil.hpp"
+
+using namespace argpp;
+using namespace argpp_test;
+
+static const unsigned long reparses = 1000000;
+static const unsigned long warm_up  = 1000;
+
+//--------------------------------------------------------------------
+// Returns the resident set size in kilobytes, or 0 if it is unknown:
+//--------------------------------------------------------------------
+static unsigned long residentKb()
+{
+  unsigned long pages = 0, resident = 0;
+  FILE *f = std::fopen("/proc/self/statm", "r");
+  if (f) {
+    if (std::fscanf(f, "%lu %lu", &pages, &resident) != 2) resident = 0;
+    std::fclose(f);
+  }
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static char  prog[] = "reparse_bench";
+static char  a1[]   = "--opt-0";
+static char  a2[]   = "--opt-1=one";
+static char  a3[]   = "--sub-3";
+static char  a4[]   = "two";
+static char  a5[]   = "input.txt";
+static char  b1[]   = "--opt-5";
+static char  b2[]   = "three";
+static char  b3[]   = "--sub-0";
+static char *argv_a[] = { prog, a1, a2, a3, a4, a5, NULL };
+static char *argv_b[] = { prog, b1, b2, b3, NULL };
+
+//--------------------------------------------------------------------
+int main()
+{
+  static char scratch[16384];
+
+  ArgppBase::setParseEngine(eng_native);
+  ArgppBase::setScratchBuffer(scratch, sizeof scratch);
+
+  KeepingParser *root = Factory<KeepingParser>::createParser(6, argv_a, makeOptions(20));
+  KeepingParser *child = root
+      ? Factory<KeepingParser>::createParser(6, argv_a, makeOptions(10, 1100, "sub-"), root)
+      : NULL;
+  ARGPP_CHECK(root != NULL && child != NULL);
+  if (!child) return result("reparse_bench");
+  root->setArgpParseFlags(fl_no_exit);
+  ARGPP_CHECK(ArgppBase::parse());
+
+  long          blocks = 0;
+  unsigned long rss    = 0;
+  unsigned long failed = 0;
+  double        start  = now();
+  for (unsigned long i = 0; i < reparses; ++i) {
+    bool ok = (i % 2) ? ArgppBase::reparse(4, argv_b)
+                      : ArgppBase::reparse(6, argv_a);
+    if (!ok) ++failed;
+    if (i + 1 == warm_up) {
+      blocks = live_blocks;
+      rss    = residentKb();
+    }
+  }
+  double secs = now() - start;
+
+  std::printf("%lu re-parses in %.2f s (%.0f ns each)\n",
+              reparses, secs, secs * 1e9 / reparses);
+  std::printf("live heap blocks: %ld after %lu, %ld after %lu\n",
+              blocks, warm_up, live_blocks, reparses);
+  std::printf("resident set: %lu kB after %lu, %lu kB after %lu\n",
+              rss, warm_up, residentKb(), reparses);
+
+  ARGPP_CHECK(failed == 0);
+  ARGPP_CHECK(live_blocks == blocks);
+  ARGPP_CHECK(residentKb() <= rss + 256);
+
+  ArgppOption opt;
+  ARGPP_CHECK(child->findOption(1100, opt));
+  ArgppBase::clearAllParsers();
+  return result("reparse_bench");
+}
@@ -0,0 +1,158 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+
+//--------------------------------------------------------------------
+// Parses a file of command lines with ArgppPlan::parseFile() on 1, 2,
+// 4 ... threads, up to the number of cores, and prints how the time
+// scales. The results must be the same with any number of threads,
+// and on a machine with two or more cores, each number of threads up
+// to the number of cores must be at least min_speedup times as fast
+// per thread as one. With only one core, the test is skipped once the
+// results were compared.
+//--------------------------------------------------------------------
+#include "testutil.hpp"
+
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+#  include <thread>
+#endif
+
+using namespace argpp;
+using namespace argpp_test;
+
+static const size_t num_lines   = 200000;
+static const double min_speedup = 0.6;
+
+//--------------------------------------------------------------------
+// Writes the command lines into a temporary file:
+//--------------------------------------------------------------------
+static FILE* writeLines()
+{
+  FILE *f = std::tmpfile();
+  if (!f) return NULL;
+  for (size_t i = 0; i < num_lines; ++i) {
+    std::fprintf(f, "prog --opt-%lu --opt-%lu=\"value %lu\" --sub-%lu file-%lu.txt 'other file'\n",
+                 static_cast<unsigned long>(i % 20 / 2 * 2),
+                 static_cast<unsigned long>(i % 20 / 2 * 2 + 1),
+                 static_cast<unsigned long>(i),
+                 static_cast<unsigned long>(i % 5 * 2),
+                 static_cast<unsigned long>(i));
+  }
+  return f;
+}
+
+//--------------------------------------------------------------------
+// Returns true if both batches hold the same results:
+//--------------------------------------------------------------------
+static bool sameResults(const ArgppBatchResults &a, const ArgppBatchResults &b)
+{
+  if (a.getLines().size()   != b.getLines().size()
+      || a.getOptions().size() != b.getOptions().size()
+      || a.getArgs().size()    != b.getArgs().size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.getLines().size(); ++i) {
+    const ArgppBatchResults::Line &x = a.getLines()[i];
+    const ArgppBatchResults::Line &y = b.getLines()[i];
+    if (x.line_ != y.line_ || x.retval_error_ != y.retval_error_
+        || x.num_options_ != y.num_options_ || x.num_args_ != y.num_args_) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < a.getOptions().size(); ++i) {
+    const ArgppBatchResults::Option &x = a.getOptions()[i];
+    const ArgppBatchResults::Option &y = b.getOptions()[i];
+    if (x.key_ != y.key_ || x.argv_index_ != y.argv_index_
+        || a.getString(x.arg_).str() != b.getString(y.arg_).str()) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < a.getArgs().size(); ++i) {
+    if (a.getString(a.getArgs()[i].arg_).str()
+        != b.getString(b.getArgs()[i].arg_).str()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------
+int main()
+{
+  static char  prog[] = "scaling_bench";
+  static char *argv[] = { prog, NULL };
+
+  ArgppBase::setParseEngine(eng_native);
+  KeepingParser *root = Factory<KeepingParser>::createParser(1, argv, makeOptions(20));
+  KeepingParser *child = root
+      ? Factory<KeepingParser>::createParser(1, argv, makeOptions(10, 1100, "sub-"), root)
+      : NULL;
+  FILE *in = writeLines();
+  ARGPP_CHECK(child != NULL && in != NULL);
+  if (!child || !in) return result("scaling_bench");
+
+  ArgppPlan plan(root);
+  ARGPP_CHECK(plan.isValid());
+
+  //------------------------------------------------------------------
+  // At least four threads, so that the results are compared even on a
+  // machine with fewer cores:
+  //------------------------------------------------------------------
+  unsigned cores = 1;
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+  cores = std::thread::hardware_concurrency();
+#endif
+  unsigned max_threads = cores < 4 ? 4 : cores;
+
+  ArgppBatchResults first;
+  double            one_thread = 0.0;
+  for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+    ArgppBatchResults results;
+    std::rewind(in);
+    double start = now();
+    ARGPP_CHECK(plan.parseFile(in, results, threads));
+    double secs = now() - start;
+    if (threads == 1) {
+      one_thread = secs;
+      first.linesParsed(results);
+      ARGPP_CHECK(results.getLines().size() == num_lines);
+      ARGPP_CHECK(results.getOptions().size() == 3 * num_lines);
+      ARGPP_CHECK(results.getArgs().size() == 2 * num_lines);
+    } else {
+      ARGPP_CHECK(sameResults(first, results));
+    }
+    double speedup = one_thread / secs;
+    std::printf("%2u thread(s): %6.3f s, %5.2f times as fast as one\n",
+                threads, secs, speedup);
+    if (threads > 1 && threads <= cores) {
+      ARGPP_CHECK(speedup >= min_speedup * threads);
+    }
+  }
+
+  std::fclose(in);
+  ArgppBase::clearAllParsers();
+  if (cores < 2 && argpp_test::failures == 0) {
+    std::printf("scaling_bench: skipped, the speedup can't be measured on one core\n");
+    return 77;
+  }
+  return result("scaling_bench");
+}
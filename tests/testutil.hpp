@@ -0,0 +1,124 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+#ifndef ARGPP_TESTUTIL_H
+#define ARGPP_TESTUTIL_H
+
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include "argpp.hpp"
+
+//--------------------------------------------------------------------
+// Helpers shared by the programs run by "make check".
+//--------------------------------------------------------------------
+namespace argpp_test {
+
+  /// @brief The number of failed checks; main() returns 1 if it is not 0.
+  static int failures = 0;
+
+  /// @brief The number of blocks which operator new has allocated, and the number
+  /// of them which have not been deleted yet; only counted in the programs which
+  /// are linked with countnew.cpp.
+  extern unsigned long allocs;
+  extern long          live_blocks;
+
+  /// @brief Reports a failed check with its location and counts it.
+#define ARGPP_CHECK(cond)                                               \
+  do {                                                                  \
+    if (!(cond)) {                                                      \
+      std::fprintf(stderr, "%s:%d: check failed: %s\n",                 \
+                   __FILE__, __LINE__, #cond);                          \
+      ++argpp_test::failures;                                           \
+    }                                                                   \
+  } while (0)
+
+  /// @brief Returns the time of a monotonic clock in seconds.
+  inline double now()
+  {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+  }
+
+  /// @brief Returns "<prefix><n>".
+  inline std::string numbered(const char *prefix, size_t n)
+  {
+    char buf[32];
+    std::sprintf(buf, "%lu", static_cast<unsigned long>(n));
+    return std::string(prefix) + buf;
+  }
+
+  /// @brief Returns \c n options "--<prefix>0" ... with the keys
+  /// \c first_key, \c first_key + 1 ...; every second option takes an argument.
+  inline argpp::ArgppOptions makeOptions(size_t n, int first_key = 1000,
+                                         const char *prefix = "opt-")
+  {
+    argpp::ArgppOptions opts;
+    opts.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+      std::string name = numbered(prefix, i);
+      opts.push_back(argpp::ArgppOption(name.c_str(),
+                                        first_key + static_cast<int>(i),
+                                        (i % 2) ? "VALUE" : NULL,
+                                        0,
+                                        "An option made up by the test"));
+    }
+    return opts;
+  }
+
+  /// @brief A parser which accepts all of its own options and does nothing else.
+  class TestParser : public argpp::ArgppBase {
+    public:
+      TestParser(int argc, char **argv, argpp::ArgppBase *parent)
+        : ArgppBase(argc, argv, parent)
+      {}
+    private:
+      error_t parserImpl(int key, const char * /*arg*/, argp_state * /*state*/) {
+        argpp::ArgppOption opt;
+        return findOption(key, opt) ? ARGPP_SUCCESS : ARGPP_DONT_CARE;
+      }
+  };
+
+  /// @brief A parser which keeps what it parses with genericParserImpl(), as most
+  /// programs do.
+  class KeepingParser : public argpp::ArgppBase {
+    public:
+      KeepingParser(int argc, char **argv, argpp::ArgppBase *parent)
+        : ArgppBase(argc, argv, parent)
+      {}
+    private:
+      error_t parserImpl(int key, const char *arg, argp_state *state) {
+        return genericParserImpl(key, arg, state);
+      }
+  };
+
+  /// @brief Returns 0 if no check has failed, otherwise 1.
+  inline int result(const char *name)
+  {
+    std::printf("%s: %s\n", name, failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+  }
+
+} // namespace argpp_test
+
+#endif // ARGPP_TESTUTIL_H
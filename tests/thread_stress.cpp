@@ -0,0 +1,226 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+
+//--------------------------------------------------------------------
+// Builds trees of parsers on one thread and parses them on another,
+// and parses independent trees on several threads at once, with both
+// engines. Meant to be run with the library and this program built
+// with -fsanitize=thread as well, which reports any state that the
+// trees still share.
+//--------------------------------------------------------------------
+#include "testutil.hpp"
+
+#ifdef ARGPP_HAVE_THREAD_LOCAL
+#  include <thread>
+#  include <vector>
+
+using namespace argpp;
+using namespace argpp_test;
+
+static const size_t num_options = 12;
+static const size_t num_threads = 4;
+static const size_t num_rounds  = 50;
+
+//--------------------------------------------------------------------
+// The command line which every tree parses: each option of the root
+// and of the child once, and two arguments:
+//--------------------------------------------------------------------
+class CommandLine {
+  public:
+    explicit CommandLine(size_t round)
+      : words_()
+      , argv_()
+    {
+      words_.push_back("thread_stress");
+      for (size_t i = 0; i < num_options; ++i) {
+        words_.push_back(numbered("--opt-", i) + ((i % 2) ? numbered("=r", round) : ""));
+        words_.push_back(numbered("--sub-", i) + ((i % 2) ? numbered("=c", round) : ""));
+      }
+      words_.push_back(numbered("file", round));
+      words_.push_back("last");
+      for (size_t i = 0; i < words_.size(); ++i) {
+        argv_.push_back(&words_[i][0]);
+      }
+      argv_.push_back(NULL);
+    }
+    int    argc() { return static_cast<int>(argv_.size() - 1); }
+    char **argv() { return &argv_[0]; }
+  private:
+    std::vector<std::string> words_;
+    std::vector<char*>       argv_;
+};
+
+//--------------------------------------------------------------------
+// Makes a root with a child on the calling thread:
+//--------------------------------------------------------------------
+static KeepingParser *buildTree(argpp_parse_engine engine, CommandLine &cmd)
+{
+  ArgppBase::setParseEngine(engine);
+  KeepingParser *root = Factory<KeepingParser>::createParser(
+      cmd.argc(), cmd.argv(), makeOptions(num_options, 1000, "opt-"));
+  if (root) {
+    root->setArgpParseFlags(fl_no_exit);
+    Factory<KeepingParser>::createParser(
+        cmd.argc(), cmd.argv(), makeOptions(num_options, 2000, "sub-"), root);
+  }
+  return root;
+}
+
+//--------------------------------------------------------------------
+// Parses the tree selected on the calling thread and returns the number
+// of results which are not those of \c round:
+//--------------------------------------------------------------------
+static size_t checkParse(KeepingParser *root, size_t round)
+{
+  size_t bad = 0;
+  if (!ArgppBase::parse()) {
+    ++bad;
+  }
+  const ParsedOptions &opts = root->getParsedOptions();
+  const OtherArgs     &args = root->getNonOptionArgs();
+  if (opts.size() != 2 * num_options) {
+    ++bad;
+  }
+  for (size_t i = 0; i < opts.size(); ++i) {
+    bool with_arg = ((opts[i].key_ % 1000) % 2) != 0;
+    if (with_arg && opts[i].arg_ != numbered(opts[i].key_ < 2000 ? "r" : "c", round)) {
+      ++bad;
+    }
+  }
+  if (args.size() != 2 || (args.size() == 2 && args[0] != numbered("file", round))) {
+    ++bad;
+  }
+  return bad;
+}
+
+//--------------------------------------------------------------------
+// A tree built on one thread and parsed on another, which selects it
+// with installArgppRootInstance(). The builder keeps it selected until
+// the parser is done, and finds it destroyed afterwards:
+//--------------------------------------------------------------------
+static void handOff(argpp_parse_engine engine, size_t round, size_t *bad)
+{
+  std::thread builder([=]() {
+    CommandLine    cmd(round);
+    KeepingParser *root = buildTree(engine, cmd);
+    if (!root) {
+      ++*bad;
+      return;
+    }
+    std::thread parser([=]() {
+      ArgppBase::installArgppRootInstance(root);
+      if (ArgppBase::getRootInstance() != root
+          || !ArgppBase::isParentValid(root)
+          || ArgppBase::getParseEngine() != engine) {
+        ++*bad;
+      }
+      *bad += checkParse(root, round);
+      ArgppBase::clearAllParsers();
+    });
+    parser.join();
+    if (ArgppBase::getRootInstance() != NULL) {
+      ++*bad;
+    }
+  });
+  builder.join();
+}
+
+//--------------------------------------------------------------------
+// Each thread builds its own tree and parses it again and again:
+//--------------------------------------------------------------------
+static void independent(argpp_parse_engine engine, size_t first_round, size_t *bad)
+{
+  CommandLine    cmd(first_round);
+  KeepingParser *root = buildTree(engine, cmd);
+  if (!root) {
+    ++*bad;
+    return;
+  }
+  *bad += checkParse(root, first_round);
+  for (size_t r = 1; r < num_rounds; ++r) {
+    CommandLine next(first_round + r);
+    if (!ArgppBase::reparse(next.argc(), next.argv())) {
+      ++*bad;
+    }
+    const ParsedOptions &opts = root->getParsedOptions();
+    if (opts.size() != 2 * num_options
+        || opts[3].arg_ != numbered("c", first_round + r)) {
+      ++*bad;
+    }
+  }
+  ArgppBase::clearAllParsers();
+}
+
+//--------------------------------------------------------------------
+static void run(argpp_parse_engine engine)
+{
+  const char *name = engine == eng_native ? "native" : "argp";
+
+  size_t bad = 0;
+  for (size_t r = 0; r < num_rounds; ++r) {
+    handOff(engine, r, &bad);
+  }
+  std::printf("%s engine: %lu wrong results in %lu trees handed off\n",
+              name, static_cast<unsigned long>(bad), static_cast<unsigned long>(num_rounds));
+  ARGPP_CHECK(bad == 0);
+
+  std::vector<size_t>      bads(num_threads, 0);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; ++t) {
+    threads.push_back(std::thread(independent, engine, t * num_rounds, &bads[t]));
+  }
+  bad = 0;
+  for (size_t t = 0; t < num_threads; ++t) {
+    threads[t].join();
+    bad += bads[t];
+  }
+  std::printf("%s engine: %lu wrong results on %lu threads at once\n",
+              name, static_cast<unsigned long>(bad), static_cast<unsigned long>(num_threads));
+  ARGPP_CHECK(bad == 0);
+
+  //------------------------------------------------------------------
+  // None of it has reached the tree of the main thread:
+  //------------------------------------------------------------------
+  ARGPP_CHECK(ArgppBase::getRootInstance() == NULL);
+}
+
+//--------------------------------------------------------------------
+int main()
+{
+  run(eng_argp);
+  run(eng_native);
+  return result("thread_stress");
+}
+
+#else // ARGPP_HAVE_THREAD_LOCAL
+
+//--------------------------------------------------------------------
+// Without thread_local support there is only one tree per process:
+//--------------------------------------------------------------------
+int main()
+{
+  std::printf("thread_stress: skipped, the library was built without threads\n");
+  return 77;
+}
+
+#endif // ARGPP_HAVE_THREAD_LOCAL
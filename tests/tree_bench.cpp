@@ -0,0 +1,94 @@
+/* ARGP++ is a C++ wrapper library around the GNU argp library.
+   Copyright (C) 2014 by Robert Hairgrove <code@roberthairgrove.com>.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+   The argp library is part of the GNU C Library.
+   Written by Miles Bader <miles@gnu.ai.mit.edu>.
+   Copyright (C) 1995-1999, 2003, 2004, 2005, 2006, 2007, 2009
+   Free Software Foundation, Inc.
+*/
+
+//--------------------------------------------------------------------
+// Builds trees of 625 to 10,000 parsers with Factory::createParser(),
+// each node added under an earlier one, and checks that the time per
+// node does not grow with the size of the tree.
+//--------------------------------------------------------------------
+#include "testutil.hpp"
+
+using namespace argpp;
+using namespace argpp_test;
+
+static const int rounds = 3;
+
+//--------------------------------------------------------------------
+// Returns the time to build a tree of n parsers in seconds; the best
+// of a few rounds counts:
+//--------------------------------------------------------------------
+static double measure(size_t n)
+{
+  static char  prog[] = "tree_bench";
+  static char *argv[] = { prog, NULL };
+
+  double best = 0.0;
+  for (int r = 0; r < rounds; ++r) {
+    std::vector<ArgppBase*> nodes;
+    nodes.reserve(n);
+    size_t failed = 0;
+    double start  = now();
+    nodes.push_back(Factory<TestParser>::createParser(1, argv));
+    for (size_t i = 1; i < n; ++i) {
+      //--------------------------------------------------------------
+      // Half of the nodes go under the one before, so that the tree
+      // is both wide and deep:
+      //--------------------------------------------------------------
+      ArgppBase *parent = (i % 2) ? nodes[i - 1] : nodes[(i / 2 * 7919) % i];
+      ArgppBase *node   = Factory<TestParser>::createParser(1, argv, ArgppOptions(), parent);
+      if (!node) {
+        ++failed;
+        node = parent;
+      }
+      nodes.push_back(node);
+    }
+    double t = now() - start;
+    ARGPP_CHECK(failed == 0);
+    ARGPP_CHECK(ArgppBase::isParentValid(nodes[n - 1]));
+    ArgppBase::clearAllParsers();
+    if (r == 0 || t < best) best = t;
+  }
+  return best;
+}
+
+//--------------------------------------------------------------------
+int main()
+{
+  static const size_t sizes[] = { 625, 1250, 2500, 5000, 10000 };
+  static const size_t count   = sizeof sizes / sizeof sizes[0];
+
+  double first = 0.0, last = 0.0;
+  for (size_t i = 0; i < count; ++i) {
+    double t = measure(sizes[i]) * 1e9 / sizes[i];
+    std::printf("%5lu parsers: %8.1f ns per parser\n",
+                static_cast<unsigned long>(sizes[i]), t);
+    if (i == 0) first = t;
+    last = t;
+  }
+  //------------------------------------------------------------------
+  // With a quadratic construction a node costs 16 times as much in
+  // the largest tree as in the smallest:
+  //------------------------------------------------------------------
+  ARGPP_CHECK(last < 4.0 * first + 500.0);
+  return result("tree_bench");
+}